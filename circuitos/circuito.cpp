@@ -0,0 +1,248 @@
+/*************************************************************
+ * circuito.cpp - Simula un circuito descrito en un fichero YAML
+ *
+ * En lugar de un main() por topología (n1-2.cpp, n1-2-3.cpp,
+ * cpg_completo.cpp), el circuito se lee al arrancar:
+ *
+ *   ./Circuit cpg_completo.yaml [opciones de Trace.h] > cpg.txt
+ *
+ * Formato (ver cpg_completo.yaml y n1-2.yaml):
+ *
+ *   simulation: {step: 0.01, duration: 10000}
+ *   neurons:
+ *     - name: N1M
+ *       n_type: 1            # los 5 parámetros de VavoulisModel
+ *       tau_p: 250.0         # (n_type, tau_p, tau_q, g_eca, g_ecs)
+ *       ...
+ *       initial: {v: -67, va: -67, p: 0.0557, ...}
+ *   synapses:                # GradualActivationSynapsis (Tabla 2)
+ *     - {from: N1M, to: N2v, esyn: 0, gsyn: 0.077, tau_syn: 200,
+ *        v_r: -40, dec_slope: 2.5}
+ *   stimuli:                 # pulsos de corriente en [start, end)
+ *     - {neuron: N1M, start: 100, end: 9500, amplitude: -6}
+ *   record: [N1M.v, N1M.va, N1M->N2v, N1M.p]
+ *
+ * Cada neurona debe dar todos los parámetros del modelo: uno que falte
+ * valdría 0 (con tau_p = 0 el modelo divide por cero). Las variables
+ * iniciales que no se den valen 0.
+ *
+ * Un canal "neurona.variable" registra una variable de la neurona y
+ * "pre->post" la corriente de esa sinapsis; sólo puede haber una
+ * sinapsis por par. La primera columna de la traza es siempre el
+ * tiempo. El circuito se integra como una sola red (FusedNetwork con
+ * tamaño dinámico y DynamicRungeKutta4), así que el acoplamiento se
+ * recalcula en cada etapa de RungeKutta4. Los pulsos de cada neurona
+ * se compilan con Stimulus.h sobre la rejilla de pasos.
+ *
+ *************************************************************/
+
+#include <DifferentialNeuronWrapper.h>
+#include <DynamicRungeKutta4.h>
+#include <FusedNetwork.h>
+#include <RungeKutta4.h>
+#include <Stimulus.h>
+#include <SystemWrapper.h>
+#include <Trace.h>
+#include <VavoulisModel.h>
+#include <yaml-cpp/yaml.h>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, RungeKutta4> Neuron;
+typedef FusedNetwork<Neuron, std::dynamic_extent, std::dynamic_extent> Network;
+
+const std::map<std::string, Neuron::parameter> neuron_parameters = {
+    {"n_type", Neuron::n_type}, {"tau_p", Neuron::tau_p}, {"tau_q", Neuron::tau_q},
+    {"g_eca", Neuron::g_eca},   {"g_ecs", Neuron::g_ecs}};
+
+const std::map<std::string, Neuron::variable> neuron_variables = {
+    {"v", Neuron::v}, {"va", Neuron::va}, {"p", Neuron::p},
+    {"q", Neuron::q}, {"h", Neuron::h},   {"n", Neuron::n}};
+
+struct Channel {
+  std::string name;
+  bool synapse;
+  std::size_t index;
+  Neuron::variable var;
+};
+
+struct Simulation {
+  double step = 0.01;
+  double duration = 1000;
+  std::map<std::string, std::size_t> neurons;  // nombre -> índice
+  std::map<std::string, std::size_t> synapses; // "pre->post" -> índice
+  std::vector<Channel> channels;
+
+  // Red leída: argumentos, valores iniciales (0 si no se dan) y
+  // estímulo de cada neurona, y argumentos de cada sinapsis
+  std::vector<Neuron::ConstructorArgs> neuron_args;
+  std::vector<std::array<double, Neuron::n_variables>> initial;
+  std::vector<StimulusProtocol> stimuli;
+  std::vector<Network::SynapseArgs> synapse_args;
+};
+
+template <typename T> T required(const YAML::Node &node, const std::string &key) {
+  if (!node[key]) {
+    throw std::runtime_error("Falta el campo '" + key + "'");
+  }
+  return node[key].as<T>();
+}
+
+std::size_t neuron_index(const Simulation &sim, const std::string &name) {
+  auto it = sim.neurons.find(name);
+  if (it == sim.neurons.end()) {
+    throw std::runtime_error("Neurona desconocida: " + name);
+  }
+  return it->second;
+}
+
+void load(const std::string &path, Simulation &sim) {
+  YAML::Node root = YAML::LoadFile(path);
+
+  if (YAML::Node s = root["simulation"]) {
+    sim.step = s["step"].as<double>(sim.step);
+    sim.duration = s["duration"].as<double>(sim.duration);
+  }
+
+  for (const YAML::Node &n : root["neurons"]) {
+    std::string name = required<std::string>(n, "name");
+    Neuron::ConstructorArgs args;
+    std::array<bool, Neuron::n_parameters> given{};
+    for (const auto &entry : n) {
+      std::string key = entry.first.as<std::string>();
+      if (key == "name" || key == "initial") {
+        continue;
+      }
+      auto it = neuron_parameters.find(key);
+      if (it == neuron_parameters.end()) {
+        throw std::runtime_error("Parámetro de neurona desconocido en " + name + ": " + key);
+      }
+      args.params[it->second] = entry.second.as<double>();
+      given[it->second] = true;
+    }
+    for (const auto &[key, p] : neuron_parameters) {
+      if (!given[p]) {
+        throw std::runtime_error("Falta el parámetro " + key + " en la neurona " + name);
+      }
+    }
+
+    if (!sim.neurons.emplace(name, sim.neuron_args.size()).second) {
+      throw std::runtime_error("Neurona repetida: " + name);
+    }
+    sim.neuron_args.push_back(args);
+    sim.initial.emplace_back();
+    sim.initial.back().fill(0.0);
+    sim.stimuli.emplace_back();
+    for (const auto &entry : n["initial"]) {
+      std::string key = entry.first.as<std::string>();
+      auto it = neuron_variables.find(key);
+      if (it == neuron_variables.end()) {
+        throw std::runtime_error("Variable desconocida en " + name + ": " + key);
+      }
+      sim.initial.back()[it->second] = entry.second.as<double>();
+    }
+  }
+
+  for (const YAML::Node &s : root["synapses"]) {
+    std::string from = required<std::string>(s, "from");
+    std::string to = required<std::string>(s, "to");
+    Network::SynapseArgs args{neuron_index(sim, from),
+                              neuron_index(sim, to),
+                              required<double>(s, "esyn"),
+                              required<double>(s, "gsyn"),
+                              required<double>(s, "tau_syn"),
+                              s["v_r"].as<double>(-40.0),
+                              s["dec_slope"].as<double>(2.5)};
+    // Los canales nombran la sinapsis por su par de neuronas
+    if (!sim.synapses.emplace(from + "->" + to, sim.synapse_args.size()).second) {
+      throw std::runtime_error("Sinapsis repetida: " + from + "->" + to);
+    }
+    sim.synapse_args.push_back(args);
+  }
+
+  for (const YAML::Node &p : root["stimuli"]) {
+    sim.stimuli[neuron_index(sim, required<std::string>(p, "neuron"))].pulse(
+        required<double>(p, "start"), required<double>(p, "end"),
+        required<double>(p, "amplitude"));
+  }
+
+  for (const YAML::Node &c : root["record"]) {
+    std::string name = c.as<std::string>();
+    std::size_t arrow = name.find("->");
+    std::size_t dot = name.rfind('.');
+    if (arrow != std::string::npos) {
+      auto it = sim.synapses.find(name);
+      if (it == sim.synapses.end()) {
+        throw std::runtime_error("Sinapsis desconocida: " + name);
+      }
+      sim.channels.push_back({name, true, it->second, Neuron::v});
+    } else if (dot != std::string::npos) {
+      auto var = neuron_variables.find(name.substr(dot + 1));
+      if (var == neuron_variables.end()) {
+        throw std::runtime_error("Variable desconocida: " + name);
+      }
+      sim.channels.push_back(
+          {name, false, neuron_index(sim, name.substr(0, dot)), var->second});
+    } else {
+      throw std::runtime_error("Canal no válido (neurona.variable o pre->post): " + name);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::fprintf(stderr, "Uso: %s circuito.yaml [opciones de traza]\n", argv[0]);
+    return 1;
+  }
+
+  Simulation sim;
+  std::vector<Stimulus> stimuli;
+  try {
+    load(argv[1], sim);
+    for (const StimulusProtocol &protocol : sim.stimuli) {
+      stimuli.push_back(protocol.compile(sim.step));
+    }
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s: %s\n", argv[1], e.what());
+    return 1;
+  }
+
+  Network circuit(sim.neuron_args, sim.synapse_args);
+  for (std::size_t i = 0; i < circuit.neurons(); ++i) {
+    for (std::size_t var = 0; var < Neuron::n_variables; ++var) {
+      circuit.set(i, Neuron::variable(var), sim.initial[i][var]);
+    }
+  }
+
+  std::vector<std::string> columns = {"tiempo"};
+  for (const Channel &c : sim.channels) {
+    columns.push_back(c.name);
+  }
+  // argv[1] es el circuito; el resto son opciones de la traza
+  Trace trace(argc - 1, argv + 1, columns);
+
+  std::vector<double> row(columns.size());
+  const long steps = std::lround(sim.duration / sim.step);
+  for (long k = 0; k < steps; ++k) {
+    double time = k * sim.step;
+    for (std::size_t i = 0; i < circuit.neurons(); ++i) {
+      circuit.set_input(i, stimuli[i].current(k));
+    }
+    circuit.step<DynamicRungeKutta4>(sim.step);
+
+    row[0] = time;
+    for (std::size_t c = 0; c < sim.channels.size(); ++c) {
+      const Channel &ch = sim.channels[c];
+      row[c + 1] = ch.synapse ? circuit.current(ch.index) : circuit.get(ch.index, ch.var);
+    }
+    trace.row(row.data(), row.size());
+  }
+
+  return 0;
+}
@@ -33,14 +33,68 @@
  * - N3t -> N1M: Inhibitoria, g_syn = 8.0, E_syn = -90 mV, tau = 50 ms
  * - N2v -> N3t: Inhibitoria, g_syn = 2.0, E_syn = -90 mV, tau = 50 ms
  * 
+ * ANÁLISIS EN LÍNEA (BurstDetector.h):
+ *
+ *   ./CPG --no-trace --events ráfagas.txt --intervals ciclos.txt
+ *
+ * --events escribe una fila por ráfaga de N1M, N2v y N3t:
+ *   neurona (0 N1M, 1 N2v, 2 N3t), inicio, final, número de spikes
+ * --intervals escribe una fila por ciclo N1M -> N2v -> N3t:
+ *   ciclo, inicio, periodo, duración N1M, N2v y N3t,
+ *   intervalo N1M-N2v, intervalo N2v-N3t, delay N1M-N2v, delay N2v-N3t
+ * El resto de argumentos son los de Trace.h.
+ *
+ * PERFIL (Profiler.h, compilando con cmake -DPROFILE=ON):
+ *
+ *   ./CPG --no-trace --profile perfil.json [--profile-every 16]
+ *
+ * Al terminar escribe por stderr el tiempo de cada sinapsis, neurona,
+ * estímulo, salida y análisis; --profile guarda además el JSON.
+ * --profile-every N mide una de cada N iteraciones (16 por defecto).
+ *
+ * ESTADO (Checkpoint.h):
+ *
+ *   ./CPG --no-trace --save-state estable.ckp
+ *   ./CPG --load-state estable.ckp --time 20000
+ *
+ * --save-state guarda al final el estado de las neuronas y sinapsis;
+ * --load-state continúa desde un estado guardado (por ejemplo, ya sin
+ * el transitorio) hasta --time ms. Los nombres son los de LymnaeaCPG,
+ * así que CPGSweep --warm-start acepta el mismo fichero. Sin
+ * --load-state se parte del reposo de la red completa (SteadyState.h).
+ *
+ * PARADA EN EL CICLO LÍMITE (LimitCycle.h):
+ *
+ *   ./CPG --no-trace --intervals ciclos.txt --until-converged [--cycle-tolerance 1e-3]
+ *
+ * Sigue el mapa de retorno del primer spike de cada ráfaga de N1M
+ * desde el inicio del estímulo y para en cuanto dos vueltas seguidas
+ * coinciden (estado de la red y periodo) o si en 8 s no hay ninguna.
+ * Escribe por stderr el resultado, el periodo y el instante de parada.
+ * 
  *************************************************************/
 
+#include <BurstDetector.h>
+#include <Checkpoint.h>
 #include <DifferentialNeuronWrapper.h>
+#include <FusedNetwork.h>
 #include <VavoulisModel.h>
 #include <GradualActivationSynapsis.h>
+#include <LimitCycle.h>
+#include <LymnaeaCPG.h>
+#include <Profiler.h>
 #include <RungeKutta4.h>
+#include <SteadyState.h>
+#include <Stimulus.h>
 #include <SystemWrapper.h>
-#include <iostream>
+#include <Trace.h>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
 typedef RungeKutta4 Integrator;
 typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, Integrator> Neuron;
@@ -209,7 +263,7 @@ int main(int argc, char **argv) {
 
   // PARÁMETROS DE SIMULACIÓN
   const double step = 0.01;              // Paso de integración (ms)
-  const double simulation_time = 10000;  // 10 segundos
+  double simulation_time = 10000;        // 10 segundos (--time)
 
   // Estimulación de SO para activar el CPG (como en Fig. 4C)
   const double t_stim_start = 100;       // Inicio del estímulo (ms)
@@ -221,67 +275,276 @@ int main(int argc, char **argv) {
   const double I_drive_n1m = -6.0;       // Drive a N1M (más fuerte, es el "líder")
   const double I_drive_n2v = -2.0;       // Drive a N2v (más débil)
   const double I_drive_n3t = 0.0;       // Drive a N3t
+
+  // --events, --intervals, --profile y el estado son del análisis; el
+  // resto, de la traza
+  std::vector<char *> trace_args = {argv[0]};
+  std::string profile_path, save_path, load_path;
+  long profile_every = 16;
+  bool until_converged = false;
+  LimitCycleOptions cycle_options;
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> events_file(nullptr, std::fclose);
+  std::unique_ptr<std::FILE, int (*)(std::FILE *)> intervals_file(nullptr, std::fclose);
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if ((arg == "--events" || arg == "--intervals") && i + 1 < argc) {
+      std::FILE *file = std::fopen(argv[++i], "w");
+      if (!file) {
+        std::perror(argv[i]);
+        return 1;
+      }
+      (arg == "--events" ? events_file : intervals_file).reset(file);
+    } else if (arg == "--profile" && i + 1 < argc) {
+      profile_path = argv[++i];
+    } else if (arg == "--profile-every" && i + 1 < argc) {
+      profile_every = std::atol(argv[++i]);
+    } else if (arg == "--save-state" && i + 1 < argc) {
+      save_path = argv[++i];
+    } else if (arg == "--load-state" && i + 1 < argc) {
+      load_path = argv[++i];
+    } else if (arg == "--time" && i + 1 < argc) {
+      simulation_time = std::atof(argv[++i]);
+    } else if (arg == "--until-converged") {
+      until_converged = true;
+    } else if (arg == "--cycle-tolerance" && i + 1 < argc) {
+      cycle_options.tolerance = cycle_options.period_tolerance = std::atof(argv[++i]);
+    } else {
+      trace_args.push_back(argv[i]);
+    }
+  }
+
+  std::unique_ptr<TraceWriter> events, intervals;
+  if (events_file) {
+    events = std::make_unique<TraceWriter>(events_file.get());
+  }
+  if (intervals_file) {
+    intervals = std::make_unique<TraceWriter>(intervals_file.get());
+  }
+
+  // Ciclos N1M -> N2v -> N3t
+  PhaseIntervals<3> cycles;
+  auto analyse = [&](bool cycle) {
+    for (std::size_t p = 0; p < 3; ++p) {
+      const Burst &b = cycles.detector(p).burst();
+      if (events && cycles.closed(p)) {
+        events->row(static_cast<int>(p), b.start, b.end, b.spikes);
+      }
+    }
+    if (intervals && cycle) {
+      const PhaseIntervals<3>::Cycle &c = cycles.cycle();
+      intervals->row(c.index, c.start, c.period,
+                     c.duration[0], c.duration[1], c.duration[2],
+                     c.interval[0], c.interval[1], c.delay[0], c.delay[1]);
+    }
+  };
+
+  Trace trace(static_cast<int>(trace_args.size()), trace_args.data(), {"tiempo",
+                     "V_N1M_s", "V_N1M_a", "V_N2v_s", "V_N2v_a",
+                     "V_N3t_s", "V_N3t_a", "V_SO_s", "V_SO_a",
+                     "I_n1m_n2v", "I_n2v_n1m", "I_n1m_n3t", "I_n3t_n1m",
+                     "I_n2v_n3t", "I_n2v_so", "I_so_n1m", "I_so_n2v",
+                     "p_N1M", "p_N2v", "q_N2v", "p_N3t", "q_N3t", "p_SO"},
+              "[--time ms] [--events f] [--intervals f] [--profile f.json] "
+              "[--profile-every n] [--save-state f.ckp] [--load-state f.ckp] "
+              "[--until-converged] [--cycle-tolerance x]");
+
+#ifndef NEUN_PROFILE
+  if (!profile_path.empty()) {
+    std::fprintf(stderr, "--profile: compilado sin perfil (cmake -DPROFILE=ON)\n");
+  }
+#endif
+
+  // Drive tónico de cada neurona sobre la rejilla de pasos (Stimulus.h)
+  Stimulus drive_so = StimulusProtocol().pulse(t_stim_start, t_stim_end, I_drive_so).compile(step);
+  Stimulus drive_n1m = StimulusProtocol().pulse(t_stim_start, t_stim_end, I_drive_n1m).compile(step);
+  Stimulus drive_n2v = StimulusProtocol().pulse(t_stim_start, t_stim_end, I_drive_n2v).compile(step);
+  Stimulus drive_n3t = StimulusProtocol().pulse(t_stim_start, t_stim_end, I_drive_n3t).compile(step);
+  const long steps = std::lround(simulation_time / step);
+
+  // Estado de neuronas y sinapsis con los nombres de LymnaeaCPG
+  auto each_state = [&](auto f) {
+    f("N1M", n1m); f("N2v", n2v); f("N3t", n3t); f("SO", so);
+    f("n1m_n2v", s_n1m_n2v); f("n2v_n1m", s_n2v_n1m); f("n1m_n3t", s_n1m_n3t);
+    f("n3t_n1m", s_n3t_n1m); f("n2v_n3t", s_n2v_n3t); f("n2v_so", s_n2v_so);
+    f("so_n1m", s_so_n1m); f("so_n2v", s_so_n2v);
+  };
+
+  long first = 0;
+  if (!load_path.empty()) {
+    try {
+      Checkpoint state = Checkpoint::read(load_path);
+      if (state.h() != step) {
+        std::fprintf(stderr, "%s: paso %g distinto de %g\n", load_path.c_str(), state.h(), step);
+        return 1;
+      }
+      each_state([&](const char *name, auto &x) { state.restore(name, x); });
+      first = state.step();
+    } catch (const std::runtime_error &e) {
+      std::fprintf(stderr, "--load-state %s: %s\n", load_path.c_str(), e.what());
+      return 1;
+    }
+  } else {
+    // Reposo de toda la red sin drive (SteadyState.h) en lugar de los
+    // valores a -67 mV, resuelto sobre la red fusionada con los mismos
+    // parámetros de neuronas y sinapsis que los objetos de arriba
+    typedef FusedNetwork<Neuron, CPGParameters::n_neurons, CPGParameters::n_synapses> Network;
+    Neuron *neurons[] = {&n1m, &n2v, &n3t, &so};
+    Synapse *synapses[] = {&s_n1m_n2v, &s_n2v_n1m, &s_n1m_n3t, &s_n3t_n1m,
+                           &s_n2v_n3t, &s_n2v_so,  &s_so_n1m,  &s_so_n2v};
+    const Synapse::ConstructorArgs *syn_args[] = {
+        &syn_n1m_to_n2v, &syn_n2v_to_n1m, &syn_n1m_to_n3t, &syn_n3t_to_n1m,
+        &syn_n2v_to_n3t, &syn_n2v_to_so,  &syn_so_to_n1m,  &syn_so_to_n2v};
+    std::array<Neuron::ConstructorArgs, CPGParameters::n_neurons> neuron_args = {
+        args_n1m, args_n2v, args_n3t, args_so};
+    std::array<Network::SynapseArgs, CPGParameters::n_synapses> fused_syn;
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      const double *p = syn_args[s]->params;
+      fused_syn[s] = {static_cast<std::size_t>(CPGParameters::synapse_pre(s)),
+                      static_cast<std::size_t>(CPGParameters::synapse_post(s)),
+                      p[Synapse::esyn], p[Synapse::gsyn], p[Synapse::tau_syn],
+                      p[Synapse::v_r], p[Synapse::dec_slope]};
+    }
+    Network network(neuron_args, fused_syn);
+    for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+      for (std::size_t var = 0; var < Neuron::n_variables; ++var) {
+        network.set(k, Neuron::variable(var), neurons[k]->get(Neuron::variable(var)));
+      }
+    }
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      network.set_synapse(s, Network::r, synapses[s]->get(Synapse::r));
+      network.set_synapse(s, Network::s, synapses[s]->get(Synapse::s));
+    }
+
+    SteadyStateResult rest =
+        SteadyState::solve(network, network.variables(), network.parameters());
+    if (rest.converged) {
+      for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+        for (std::size_t var = 0; var < Neuron::n_variables; ++var) {
+          neurons[k]->set(Neuron::variable(var), network.get(k, Neuron::variable(var)));
+        }
+      }
+      for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+        synapses[s]->set(Synapse::r, network.get_synapse(s, Network::r));
+        synapses[s]->set(Synapse::s, network.get_synapse(s, Network::s));
+        synapses[s]->set(Synapse::i, network.current(s));
+      }
+    } else {
+      std::fprintf(stderr, "Reposo sin converger (residuo %g); se parte de -67 mV\n",
+                   rest.residual);
+    }
+  }
+
+  // Mapa de retorno de N1M (la primera variable del estado) desde el
+  // inicio del estímulo
+  const std::size_t n_state = LymnaeaCPG<Integrator, double>::n_state;
+  std::unique_ptr<LimitCycleMonitor> monitor;
+  std::vector<double> state(n_state);
+  if (until_converged) {
+    cycle_options.begin = t_stim_start;
+    monitor = std::make_unique<LimitCycleMonitor>(n_state, cycle_options);
+  }
+  long last = steps;
+
   // BUCLE DE SIMULACIÓN
-  for (double time = 0; time < simulation_time; time += step) {
-    
+  PROFILE_LAP(lap, profile_every);
+  for (long k = first; k < steps; ++k) {
+    const double time = k * step;
+    PROFILE_ITERATION(lap);
+
     // Actualizar todas las sinapsis (8 en total)
     // CPG trifásico
     s_n1m_n2v.step(step);
+    PROFILE_MARK(lap, "sinapsis", "s_n1m_n2v");
     s_n2v_n1m.step(step);
+    PROFILE_MARK(lap, "sinapsis", "s_n2v_n1m");
     s_n1m_n3t.step(step);
+    PROFILE_MARK(lap, "sinapsis", "s_n1m_n3t");
     s_n3t_n1m.step(step);
+    PROFILE_MARK(lap, "sinapsis", "s_n3t_n1m");
     s_n2v_n3t.step(step);
+    PROFILE_MARK(lap, "sinapsis", "s_n2v_n3t");
 
     // Sinapsis con SO
     s_n2v_so.step(step);
+    PROFILE_MARK(lap, "sinapsis", "s_n2v_so");
     s_so_n1m.step(step);
+    PROFILE_MARK(lap, "sinapsis", "s_so_n1m");
     s_so_n2v.step(step);
+    PROFILE_MARK(lap, "sinapsis", "s_so_n2v");
 
-    if (time >= t_stim_start && time <= t_stim_end) {
-      so.add_synaptic_input(I_drive_so);
-      n1m.add_synaptic_input(I_drive_n1m);  
-      n2v.add_synaptic_input(I_drive_n2v);
-      n3t.add_synaptic_input(I_drive_n3t);
-    }
+    so.add_synaptic_input(drive_so.current(k));
+    n1m.add_synaptic_input(drive_n1m.current(k));
+    n2v.add_synaptic_input(drive_n2v.current(k));
+    n3t.add_synaptic_input(drive_n3t.current(k));
+    PROFILE_MARK(lap, "estímulo", "drive");
 
     // Integrar todas las neuronas
     n1m.step(step);
+    PROFILE_MARK(lap, "neurona", "n1m");
     n2v.step(step);
+    PROFILE_MARK(lap, "neurona", "n2v");
     n3t.step(step);
+    PROFILE_MARK(lap, "neurona", "n3t");
     so.step(step);
+    PROFILE_MARK(lap, "neurona", "so");
 
     // Salida: 23 columnas
     // tiempo, V_N1M_s, V_N1M_a, V_N2v_s, V_N2v_a, V_N3t_s, V_N3t_a, V_SO_s, V_SO_a,
     // I_n1m_n2v, I_n2v_n1m, I_n1m_n3t, I_n3t_n1m, I_n2v_n3t, I_n2v_so, I_so_n1m, I_so_n2v,
     // p_N1M, p_N2v, q_N2v, p_N3t, q_N3t, p_SO
-    std::cout << time << " " 
+    trace.row(time,
               // Voltajes (8 valores)
-              << n1m.get(Neuron::v) << " " 
-              << n1m.get(Neuron::va) << " "
-              << n2v.get(Neuron::v) << " " 
-              << n2v.get(Neuron::va) << " "
-              << n3t.get(Neuron::v) << " " 
-              << n3t.get(Neuron::va) << " "
-              << so.get(Neuron::v) << " " 
-              << so.get(Neuron::va) << " "
+              n1m.get(Neuron::v), n1m.get(Neuron::va),
+              n2v.get(Neuron::v), n2v.get(Neuron::va),
+              n3t.get(Neuron::v), n3t.get(Neuron::va),
+              so.get(Neuron::v), so.get(Neuron::va),
               // Corrientes sinápticas (8 valores)
-              << s_n1m_n2v.get(Synapse::i) << " "
-              << s_n2v_n1m.get(Synapse::i) << " "
-              << s_n1m_n3t.get(Synapse::i) << " "
-              << s_n3t_n1m.get(Synapse::i) << " "
-              << s_n2v_n3t.get(Synapse::i) << " "
-              << s_n2v_so.get(Synapse::i) << " "
-              << s_so_n1m.get(Synapse::i) << " "
-              << s_so_n2v.get(Synapse::i) << " "
+              s_n1m_n2v.get(Synapse::i), s_n2v_n1m.get(Synapse::i),
+              s_n1m_n3t.get(Synapse::i), s_n3t_n1m.get(Synapse::i),
+              s_n2v_n3t.get(Synapse::i), s_n2v_so.get(Synapse::i),
+              s_so_n1m.get(Synapse::i), s_so_n2v.get(Synapse::i),
               // Variables de gating (6 valores)
-              << n1m.get(Neuron::p) << " "
-              << n2v.get(Neuron::p) << " "
-              << n2v.get(Neuron::q) << " "
-              << n3t.get(Neuron::p) << " "
-              << n3t.get(Neuron::q) << " "
-              << so.get(Neuron::p)
-              << std::endl;
+              n1m.get(Neuron::p), n2v.get(Neuron::p), n2v.get(Neuron::q),
+              n3t.get(Neuron::p), n3t.get(Neuron::q), so.get(Neuron::p));
+    PROFILE_MARK(lap, "salida", "trace");
+
+    const double v[] = {n1m.get(Neuron::v), n2v.get(Neuron::v), n3t.get(Neuron::v)};
+    analyse(cycles.add(time, v));
+    PROFILE_MARK(lap, "análisis", "cycles");
+
+    if (monitor) {
+      double *x = state.data();
+      each_state([&](const char *, const auto &system) { x = state_variables(system, x); });
+      // Estado tras el paso: tiempo (k + 1) h, como en LimitCycle.h
+      const bool running =
+          monitor->add((k + 1) * step, state.data()) == LimitCycleMonitor::running;
+      PROFILE_MARK(lap, "análisis", "ciclo límite");
+      if (!running) {
+        last = k + 1;
+        break;
+      }
+    }
+  }
+
+  analyse(cycles.finish());
+
+  if (monitor) {
+    std::fprintf(stderr, "%s: %ld vueltas, periodo %.3f ms (cambio %.2g), parada en t = %.2f ms\n",
+                 LimitCycleMonitor::name(monitor->state()), monitor->returns(),
+                 monitor->period(), monitor->difference(), std::max(first, last) * step);
+  }
+
+  if (!save_path.empty()) {
+    Checkpoint state(std::max(first, last), step);
+    each_state([&](const char *name, const auto &x) { state.save(name, x); });
+    try {
+      state.write(save_path);
+    } catch (const std::runtime_error &e) {
+      std::fprintf(stderr, "--save-state: %s\n", e.what());
+      return 1;
+    }
   }
+  PROFILE_REPORT(profile_path);
 
   return 0;
 }
@@ -31,8 +31,10 @@
 #include <VavoulisModel.h>
 #include <GradualActivationSynapsis.h>
 #include <RungeKutta4.h>
+#include <Stimulus.h>
 #include <SystemWrapper.h>
-#include <iostream>
+#include <Trace.h>
+#include <cmath>
 
 typedef RungeKutta4 Integrator;
 typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, Integrator> Neuron;
@@ -160,7 +162,21 @@ int main(int argc, char **argv) {
   const double I_drive_n2v = -1.0;
   const double I_drive_n3t = -3.0;
 
-  for (double time = 0; time < simulation_time; time += step) {
+  Trace trace(argc, argv, {"tiempo",
+                     "V_N1M_soma", "V_N1M_axon", "V_N2v_soma", "V_N2v_axon",
+                     "V_N3t_soma", "V_N3t_axon",
+                     "I_syn_N1M->N2v", "I_syn_N2v->N1M", "I_syn_N1M->N3t",
+                     "I_syn_N3t->N1M", "I_syn_N2v->N3t",
+                     "p_N1M", "p_N2v", "q_N2v", "p_N3t", "q_N3t"});
+
+  // Drive tónico de cada neurona sobre la rejilla de pasos (Stimulus.h)
+  Stimulus drive_n1m = StimulusProtocol().pulse(t_stim_start, t_stim_end, I_drive_n1m).compile(step);
+  Stimulus drive_n2v = StimulusProtocol().pulse(t_stim_start, t_stim_end, I_drive_n2v).compile(step);
+  Stimulus drive_n3t = StimulusProtocol().pulse(t_stim_start, t_stim_end, I_drive_n3t).compile(step);
+  const long steps = std::lround(simulation_time / step);
+
+  for (long k = 0; k < steps; ++k) {
+    const double time = k * step;
     
     // Actualizar sinapsis con activación gradual - LAS 5 sinapsis de la Tabla 2
     s_n1m_n2v.step(step);
@@ -171,11 +187,9 @@ int main(int argc, char **argv) {
 
     // Drive tónico diferencial a cada neurona (simula entrada de SO)
     // Este drive es necesario para que el half-center oscillator funcione
-    if (time >= t_stim_start && time <= t_stim_end) {
-      n1m.add_synaptic_input(I_drive_n1m);
-      n2v.add_synaptic_input(I_drive_n2v);
-      n3t.add_synaptic_input(I_drive_n3t);
-    }
+    n1m.add_synaptic_input(drive_n1m.current(k));
+    n2v.add_synaptic_input(drive_n2v.current(k));
+    n3t.add_synaptic_input(drive_n3t.current(k));
 
     n1m.step(step);
     n2v.step(step);
@@ -184,24 +198,15 @@ int main(int argc, char **argv) {
     // Salida: tiempo, V_N1M_soma, V_N1M_axon, V_N2v_soma, V_N2v_axon, V_N3t_soma, V_N3t_axon,
     //         I_syn_N1M->N2v, I_syn_N2v->N1M, I_syn_N1M->N3t, I_syn_N3t->N1M, I_syn_N2v->N3t,
     //         p_N1M, p_N2v, q_N2v, p_N3t, q_N3t
-    std::cout << time << " " 
-              << n1m.get(Neuron::v) << " " 
-              << n1m.get(Neuron::va) << " "
-              << n2v.get(Neuron::v) << " " 
-              << n2v.get(Neuron::va) << " "
-              << n3t.get(Neuron::v) << " " 
-              << n3t.get(Neuron::va) << " "
-              << s_n1m_n2v.get(Synapse::i) << " "
-              << s_n2v_n1m.get(Synapse::i) << " "
-              << s_n1m_n3t.get(Synapse::i) << " "
-              << s_n3t_n1m.get(Synapse::i) << " "
-              << s_n2v_n3t.get(Synapse::i) << " "
-              << n1m.get(Neuron::p) << " "
-              << n2v.get(Neuron::p) << " "
-              << n2v.get(Neuron::q) << " "
-              << n3t.get(Neuron::p) << " "
-              << n3t.get(Neuron::q)
-              << std::endl;
+    trace.row(time,
+              n1m.get(Neuron::v), n1m.get(Neuron::va),
+              n2v.get(Neuron::v), n2v.get(Neuron::va),
+              n3t.get(Neuron::v), n3t.get(Neuron::va),
+              s_n1m_n2v.get(Synapse::i), s_n2v_n1m.get(Synapse::i),
+              s_n1m_n3t.get(Synapse::i), s_n3t_n1m.get(Synapse::i),
+              s_n2v_n3t.get(Synapse::i),
+              n1m.get(Neuron::p), n2v.get(Neuron::p), n2v.get(Neuron::q),
+              n3t.get(Neuron::p), n3t.get(Neuron::q));
   }
 
   return 0;
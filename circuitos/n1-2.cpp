@@ -32,8 +32,10 @@
 #include <VavoulisModel.h>
 #include <GradualActivationSynapsis.h>
 #include <RungeKutta4.h>
+#include <Stimulus.h>
 #include <SystemWrapper.h>
-#include <iostream>
+#include <Trace.h>
+#include <cmath>
 
 typedef RungeKutta4 Integrator;
 typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, Integrator> Neuron;
@@ -121,34 +123,37 @@ int main(int argc, char **argv) {
   const double I_drive_n1m = -6.0;       // Drive a N1M
   const double I_drive_n2v = -1.5;       // Drive a N2v
 
-  for (double time = 0; time < simulation_time; time += step) {
+  Trace trace(argc, argv, {"tiempo",
+                     "V_N1M_soma", "V_N1M_axon", "V_N2v_soma", "V_N2v_axon",
+                     "I_syn_N1M->N2v", "I_syn_N2v->N1M",
+                     "p_N1M", "p_N2v", "q_N2v"});
+
+  // Drive tónico de cada neurona sobre la rejilla de pasos (Stimulus.h)
+  Stimulus drive_n1m = StimulusProtocol().pulse(t_stim_start, t_stim_end, I_drive_n1m).compile(step);
+  Stimulus drive_n2v = StimulusProtocol().pulse(t_stim_start, t_stim_end, I_drive_n2v).compile(step);
+  const long steps = std::lround(simulation_time / step);
+
+  for (long k = 0; k < steps; ++k) {
+    const double time = k * step;
     
     // Actualizar sinapsis con activación gradual
     // NOTA: step(h) actualiza v_pre internamente y aplica I_syn a la neurona postsináptica
     s_n1m_n2v.step(step);  // N1M -> N2v
     s_n2v_n1m.step(step);  // N2v -> N1M
 
-    if (time >= t_stim_start && time <= t_stim_end) {
-      n1m.add_synaptic_input(I_drive_n1m);  // Drive más fuerte a N1M
-      n2v.add_synaptic_input(I_drive_n2v);  // Drive más débil a N2v
-    }
+    n1m.add_synaptic_input(drive_n1m.current(k));  // Drive más fuerte a N1M
+    n2v.add_synaptic_input(drive_n2v.current(k));  // Drive más débil a N2v
 
     n1m.step(step);
     n2v.step(step);
 
     // Salida: tiempo, V_N1M_soma, V_N1M_axon, V_N2v_soma, V_N2v_axon, 
     //         I_syn_N1M->N2v, I_syn_N2v->N1M, p_N1M, p_N2v, q_N2v
-    std::cout << time << " " 
-              << n1m.get(Neuron::v) << " " 
-              << n1m.get(Neuron::va) << " "
-              << n2v.get(Neuron::v) << " " 
-              << n2v.get(Neuron::va) << " "
-              << s_n1m_n2v.get(Synapse::i) << " "
-              << s_n2v_n1m.get(Synapse::i) << " "
-              << n1m.get(Neuron::p) << " "
-              << n2v.get(Neuron::p) << " "
-              << n2v.get(Neuron::q)
-              << std::endl;
+    trace.row(time,
+              n1m.get(Neuron::v), n1m.get(Neuron::va),
+              n2v.get(Neuron::v), n2v.get(Neuron::va),
+              s_n1m_n2v.get(Synapse::i), s_n2v_n1m.get(Synapse::i),
+              n1m.get(Neuron::p), n2v.get(Neuron::p), n2v.get(Neuron::q));
   }
 
   return 0;
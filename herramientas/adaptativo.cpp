@@ -0,0 +1,166 @@
+/*************************************************************
+ * adaptativo.cpp - DormandPrince54 frente a RungeKutta4
+ *
+ * Plateau de N1M con el estímulo de neuronas/N1.cpp (pulso de -10
+ * entre 200 y 1800 ms), integrado de tres formas:
+ *
+ *   - RungeKutta4 a paso fijo --step (referencia)
+ *   - DormandPrince54 como Integrator de Neun, con step(--grid) y los
+ *     pasos cortados en los cambios del estímulo (Breakpoints)
+ *   - DormandPrince54::Solver por tramos entre los cambios del
+ *     estímulo, con pasos libres y salida densa en la rejilla --grid
+ *
+ * Para cada una se informa del número de evaluaciones del sistema,
+ * del número de spikes (cruces ascendentes de -20 mV) y de la mayor
+ * diferencia en el instante de los spikes respecto a la referencia.
+ *
+ * Uso: ./Adaptive [--atol x] [--rtol x] [--step ms] [--grid ms]
+ *
+ *************************************************************/
+
+#include <Breakpoints.h>
+#include <DifferentialNeuronWrapper.h>
+#include <DormandPrince54.h>
+#include <RungeKutta4.h>
+#include <SpikeTimes.h>
+#include <SystemWrapper.h>
+#include <VavoulisModel.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, RungeKutta4> Neuron;
+typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, DormandPrince54>
+    AdaptiveNeuron;
+
+void report(const char *name, const DormandPrince54::Statistics &stats,
+            const SpikeTimes &spikes, unsigned long ref_evaluations, const SpikeTimes &ref) {
+  std::printf("  %-28s %8lu evaluaciones (x%.1f menos), %lu pasos (%lu rechazados), "
+              "%zu spikes, desfase máx. %.3g ms\n",
+              name, stats.evaluations, double(ref_evaluations) / stats.evaluations,
+              stats.accepted, stats.rejected, spikes.size(), max_shift(spikes, ref));
+}
+
+void plateau(double step, double grid, double atol, double rtol) {
+  const double simulation_time = 2000;
+  const double t_pulse_start = 200, t_pulse_end = 1800;
+  const double I_inj = -10.0;
+
+  Neuron::ConstructorArgs args;
+  args.params[Neuron::n_type] = 1;
+  args.params[Neuron::tau_p] = 250.0;
+  args.params[Neuron::tau_q] = 1.0;
+  args.params[Neuron::g_eca] = 8.0;
+  args.params[Neuron::g_ecs] = 8.0;
+
+  auto rest = [](auto &n) {
+    n.set(Neuron::v, -67);
+    n.set(Neuron::va, -67);
+    n.set(Neuron::p, 1 / (1 + exp((-38.8 - (-67.0)) / 10.0)));
+    n.set(Neuron::q, 0.0);
+    n.set(Neuron::h, 1 / (1 + exp((-55.2 - (-67.0)) / -7.1)));
+    n.set(Neuron::n, 1.0 / (1.0 + exp((-30.0 - (-67.0)) / 17.4)));
+  };
+
+  // Referencia a paso fijo. El pulso es [start, end) para que coincida
+  // con los tramos del adaptativo.
+  Neuron ref(args);
+  rest(ref);
+  SpikeTimes ref_spikes;
+  const long steps = std::lround(simulation_time / step);
+  const long per_sample = std::max(1L, std::lround(grid / step));
+  ref_spikes.add(0.0, ref.get(Neuron::v));
+  for (long k = 0; k < steps; ++k) {
+    double time = k * step;
+    if (time >= t_pulse_start && time < t_pulse_end) {
+      ref.add_synaptic_input(I_inj);
+    }
+    ref.step(step);
+    if ((k + 1) % per_sample == 0) {
+      ref_spikes.add((k + 1) * step, ref.get(Neuron::v));
+    }
+  }
+  const unsigned long ref_evaluations = 4 * steps;
+
+  Breakpoints breaks{t_pulse_start, t_pulse_end, simulation_time};
+
+  // Integrator de Neun: cada step(grid) se resuelve con subpasos
+  // adaptativos y ningún step cruza un cambio del estímulo
+  DormandPrince54::set_tolerances(atol, rtol);
+  AdaptiveNeuron::ConstructorArgs adaptive_args;
+  for (int i = 0; i < Neuron::n_parameters; ++i) {
+    adaptive_args.params[i] = args.params[i];
+  }
+  AdaptiveNeuron drop_in(adaptive_args);
+  rest(drop_in);
+  SpikeTimes drop_in_spikes;
+  drop_in_spikes.add(0.0, drop_in.get(AdaptiveNeuron::v));
+  for (long k = 0; k * grid < simulation_time - 1e-9;) {
+    double time = k * grid;
+    // Avanza hasta el siguiente punto de la rejilla o cambio del estímulo
+    double h = breaks.clip(time, grid);
+    for (double t = time; t < time + grid - 1e-9; t += h, h = breaks.clip(t, time + grid - t)) {
+      if (t >= t_pulse_start && t < t_pulse_end) {
+        drop_in.add_synaptic_input(I_inj);
+      }
+      drop_in.step(h);
+    }
+    ++k;
+    drop_in_spikes.add(k * grid, drop_in.get(AdaptiveNeuron::v));
+  }
+
+  // Adaptativo con salida densa. La neurona sólo se usa como sistema
+  // (eval); el estado vive en vars y la entrada se cambia en cada
+  // tramo sumando la diferencia de corriente.
+  Neuron n(args);
+  rest(n);
+  double vars[Neuron::n_variables];
+  for (int i = 0; i < Neuron::n_variables; ++i) {
+    vars[i] = n.get(static_cast<Neuron::variable>(i));
+  }
+
+  DormandPrince54::Solver<Neuron> solver(atol, rtol);
+  SpikeTimes spikes;
+  spikes.add(0.0, vars[Neuron::v]);
+  double I = 0.0;
+  for (double t = 0; t < simulation_time; t = breaks.next(t)) {
+    double I_new = (t >= t_pulse_start && t < t_pulse_end) ? I_inj : 0.0;
+    n.add_synaptic_input(I_new - I);
+    I = I_new;
+    solver.integrate(n, vars, args.params, t, breaks.next(t), grid,
+                     [&](double t_k, const double *y) { spikes.add(t_k, y[Neuron::v]); });
+  }
+
+  std::printf("N1M plateau, %g ms, referencia RungeKutta4 a %g ms: %lu evaluaciones, "
+              "%zu spikes\n",
+              simulation_time, step, ref_evaluations, ref_spikes.size());
+  report("DormandPrince54 (Integrator)", DormandPrince54::statistics(), drop_in_spikes,
+         ref_evaluations, ref_spikes);
+  report("DormandPrince54::Solver", solver.statistics(), spikes, ref_evaluations,
+         ref_spikes);
+}
+
+int main(int argc, char **argv) {
+  double atol = 1e-6, rtol = 1e-6;
+  double step = 0.01, grid = 0.1;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      throw std::invalid_argument("Falta el valor de " + arg);
+    }
+    double value = std::atof(argv[++i]);
+    if (arg == "--atol") atol = value;
+    else if (arg == "--rtol") rtol = value;
+    else if (arg == "--step") step = value;
+    else if (arg == "--grid") grid = value;
+    else throw std::invalid_argument("Argumento no reconocido: " + arg);
+  }
+
+  plateau(step, grid, atol, rtol);
+  return 0;
+}
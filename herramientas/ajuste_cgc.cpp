@@ -0,0 +1,408 @@
+/*************************************************************
+ * ajuste_cgc.cpp - Ajuste de parámetros de la CGC a un registro
+ *
+ * Busca los parámetros de VavoulisCGCModel (los de la Tabla 1 de
+ * neuronas/CGC.cpp que se elijan con --fit) que mejor reproducen un
+ * registro, con evolución diferencial (DifferentialEvolution.h). Cada
+ * candidato es una simulación del protocolo de CGC (reposo, pulso de
+ * --current nA entre --pulse inicio y final) y los de una generación
+ * se reparten entre --threads hilos:
+ *
+ *   ./CGC > cgc.txt
+ *   ./CGCFit --target cgc.txt --fit Gnat,Ga,Gd,Ghva --generations 60
+ *   ./CGCFit --target-spikes spikes.txt --fit Gnat,Gnap,vh_h --range vh_h -65 -45
+ *
+ * Costes:
+ *
+ *   trace   (con --target) error cuadrático medio en mV del voltaje
+ *           frente a las filas de la traza (texto de Trace.h: tiempo,
+ *           V, ...; se comparan en el paso más cercano a cada tiempo).
+ *   spikes  (con --target-spikes, un instante por línea, o --cost
+ *           spikes con --target) media sobre los spikes del registro
+ *           de |t_candidato - t_registro| emparejados en orden, con un
+ *           máximo de --penalty ms por spike; los que sobran o faltan
+ *           cuestan --penalty.
+ *
+ * Los dos costes sólo crecen a lo largo de la simulación, así que un
+ * candidato se para en cuanto supera el coste del individuo al que
+ * tendría que sustituir (la cota de DifferentialEvolution). También se
+ * para si el voltaje deja de ser finito.
+ *
+ * Cada parámetro se busca en --range nombre min max o, si no se da, en
+ * su valor de la Tabla 1 +-50%. Los valores de la Tabla 1 entran en la
+ * población inicial. Por stderr se escribe el progreso de cada
+ * generación; por stdout los --report mejores conjuntos con su coste.
+ *
+ * Uso: ./CGCFit (--target traza.txt | --target-spikes spikes.txt)
+ *               [--cost trace|spikes] [--fit p1,p2,...] [--range p min max]
+ *               [--population n] [--generations n] [--F x] [--CR x]
+ *               [--tolerance x] [--seed n] [--threads n] [--report n]
+ *               [--current nA] [--pulse inicio final] [--time ms]
+ *               [--step ms] [--penalty ms]
+ *
+ *************************************************************/
+
+#include <CGCNeuron.h>
+#include <DifferentialEvolution.h>
+#include <DifferentialNeuronWrapper.h>
+#include <RungeKutta4.h>
+#include <SpikeTimes.h>
+#include <SteadyState.h>
+#include <Stimulus.h>
+#include <SystemWrapper.h>
+#include <VavoulisCGCModel.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisCGCModel<double>>, RungeKutta4> CGC;
+
+// Nombres de los parámetros del modelo
+const std::map<std::string, CGC::parameter> parameter_names = {
+    {"cm", CGC::cm},         {"vna", CGC::vna},       {"vk", CGC::vk},
+    {"vca", CGC::vca},       {"Gnat", CGC::Gnat},     {"Gnap", CGC::Gnap},
+    {"Ga", CGC::Ga},         {"Gd", CGC::Gd},         {"Glva", CGC::Glva},
+    {"Ghva", CGC::Ghva},     {"vh_h", CGC::vh_h},     {"vs_h", CGC::vs_h},
+    {"tau0_h", CGC::tau0_h}, {"delta_h", CGC::delta_h}, {"vh_r", CGC::vh_r},
+    {"vs_r", CGC::vs_r},     {"tau0_r", CGC::tau0_r}, {"delta_r", CGC::delta_r},
+    {"vh_a", CGC::vh_a},     {"vs_a", CGC::vs_a},     {"tau0_a", CGC::tau0_a},
+    {"delta_a", CGC::delta_a}, {"vh_b", CGC::vh_b},   {"vs_b", CGC::vs_b},
+    {"tau0_b", CGC::tau0_b}, {"delta_b", CGC::delta_b}, {"vh_n", CGC::vh_n},
+    {"vs_n", CGC::vs_n},     {"tau0_n", CGC::tau0_n}, {"delta_n", CGC::delta_n},
+    {"vh_e", CGC::vh_e},     {"vs_e", CGC::vs_e},     {"tau0_e", CGC::tau0_e},
+    {"delta_e", CGC::delta_e}, {"vh_f", CGC::vh_f},   {"vs_f", CGC::vs_f},
+    {"tau0_f", CGC::tau0_f}, {"delta_f", CGC::delta_f}, {"Vh_m", CGC::Vh_m},
+    {"Vs_m", CGC::Vs_m},     {"Vh_c", CGC::Vh_c},     {"Vs_c", CGC::Vs_c},
+    {"Vh_d", CGC::Vh_d},     {"Vs_d", CGC::Vs_d}};
+
+// Reposo sin estímulo, desde x_inf(-60 mV) de cada compuerta
+void cgc_rest(CGC &n, const CGC::ConstructorArgs &args) {
+  CGCNeuron<CGC>::rest(args.params, [&](CGC::variable var, double x) { n.set(var, x); });
+  SteadyState::rest(n);
+}
+
+struct Target {
+  std::vector<long> steps;        // Paso más cercano a cada fila de la traza
+  std::vector<double> voltage;
+  std::vector<double> spikes;
+};
+
+// Traza de texto: tiempo y V en las dos primeras columnas
+void read_trace(const std::string &path, double h, Target &target) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("No se puede abrir " + path);
+  }
+  SpikeTimes spikes;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream row(line);
+    double t, v;
+    if (line.empty() || line[0] == '#' || !(row >> t >> v)) {
+      continue;
+    }
+    target.steps.push_back(std::lround(t / h));
+    target.voltage.push_back(v);
+    spikes.add(t, v);
+  }
+  if (target.steps.empty()) {
+    throw std::runtime_error(path + " no tiene filas de tiempo y voltaje");
+  }
+  target.spikes = spikes.times;
+}
+
+void read_spikes(const std::string &path, Target &target) {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error("No se puede abrir " + path);
+  }
+  double t;
+  while (in >> t) {
+    target.spikes.push_back(t);
+  }
+  std::sort(target.spikes.begin(), target.spikes.end());
+}
+
+// Coste de spikes que se va acumulando según avanza la simulación
+class SpikeCost {
+public:
+  SpikeCost(const std::vector<double> &target, double penalty)
+      : m_target(target), m_penalty(penalty) {}
+
+  // Spike número i del candidato en t
+  void spike(std::size_t i, double t) {
+    if (i < m_resolved) {
+      return;  // Ya se cobró como perdido
+    }
+    m_sum += i < m_target.size() ? std::min(std::fabs(t - m_target[i]), m_penalty) : m_penalty;
+    m_resolved = i + 1;
+  }
+
+  // Los spikes del registro que en t ya no pueden emparejarse a menos de penalty
+  void advance(double t) {
+    while (m_resolved < m_target.size() && t > m_target[m_resolved] + m_penalty) {
+      m_sum += m_penalty;
+      ++m_resolved;
+    }
+  }
+
+  double value() const { return m_sum / std::max<std::size_t>(1, m_target.size()); }
+
+  double finish() {
+    advance(std::numeric_limits<double>::infinity());
+    return value();
+  }
+
+private:
+  const std::vector<double> &m_target;
+  double m_penalty;
+  double m_sum = 0.0;
+  std::size_t m_resolved = 0;
+};
+
+struct Settings {
+  std::vector<CGC::parameter> fit;
+  bool spike_cost = false;
+  double h = 0.01, time = NAN, penalty = 50.0;
+  double current = CGCNeuron<CGC>::I_inj;
+  double pulse_start = CGCNeuron<CGC>::t_pulse_start, pulse_end = CGCNeuron<CGC>::t_pulse_end;
+};
+
+// Simulación del candidato x; infinito en cuanto el coste pasa de bound
+double evaluate(const Settings &s, const Target &target, const Stimulus &stimulus,
+                const std::vector<double> &x, double bound) {
+  const double infinity = std::numeric_limits<double>::infinity();
+  CGC::ConstructorArgs args;
+  CGCNeuron<CGC>::args(args);
+  for (std::size_t j = 0; j < s.fit.size(); ++j) {
+    args.params[s.fit[j]] = x[j];
+  }
+  CGC n(args);
+  cgc_rest(n, args);
+  Stimulus pulse = stimulus;
+
+  const long steps = std::lround(s.time / s.h);
+  const double samples = static_cast<double>(target.steps.size());
+  std::size_t next = 0;
+  double squares = 0.0;
+  SpikeTimes spikes;
+  SpikeCost spike_cost(target.spikes, s.penalty);
+  for (long k = 0; k < steps; ++k) {
+    const double time = k * s.h;
+    n.add_synaptic_input(pulse.current(k));
+    n.step(s.h);
+    const double v = n.get(CGC::v);
+    if (!std::isfinite(v)) {
+      return infinity;
+    }
+
+    if (s.spike_cost) {
+      const std::size_t before = spikes.size();
+      spikes.add(time, v);
+      if (spikes.size() > before) {
+        spike_cost.spike(before, spikes.times.back());
+      }
+      spike_cost.advance(time);
+      if (spike_cost.value() > bound) {
+        return infinity;
+      }
+    } else {
+      // Mismas filas que CGC: la del instante k h lleva V tras el paso
+      while (next < target.steps.size() && target.steps[next] <= k) {
+        if (target.steps[next] == k) {
+          squares += (v - target.voltage[next]) * (v - target.voltage[next]);
+        }
+        ++next;
+      }
+      if (std::sqrt(squares / samples) > bound) {
+        return infinity;
+      }
+    }
+  }
+  return s.spike_cost ? spike_cost.finish() : std::sqrt(squares / samples);
+}
+
+std::vector<std::string> split(const std::string &list) {
+  std::vector<std::string> names;
+  std::stringstream in(list);
+  std::string name;
+  while (std::getline(in, name, ',')) {
+    if (!name.empty()) {
+      names.push_back(name);
+    }
+  }
+  return names;
+}
+
+int main(int argc, char **argv) {
+  Settings s;
+  DifferentialEvolutionOptions options;
+  options.threads = std::thread::hardware_concurrency();
+  std::string trace_path, spikes_path, cost;
+  std::vector<std::string> fit = {"Gnat", "Gnap", "Ga", "Gd", "Glva", "Ghva"};
+  std::map<std::string, std::pair<double, double>> ranges;
+  std::size_t report = 5;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--target" && i + 1 < argc) {
+      trace_path = argv[++i];
+    } else if (arg == "--target-spikes" && i + 1 < argc) {
+      spikes_path = argv[++i];
+    } else if (arg == "--cost" && i + 1 < argc) {
+      cost = argv[++i];
+    } else if (arg == "--fit" && i + 1 < argc) {
+      fit = split(argv[++i]);
+    } else if (arg == "--range" && i + 3 < argc) {
+      ranges[argv[i + 1]] = {std::atof(argv[i + 2]), std::atof(argv[i + 3])};
+      i += 3;
+    } else if (arg == "--population" && i + 1 < argc) {
+      options.population = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--generations" && i + 1 < argc) {
+      options.generations = std::atoi(argv[++i]);
+    } else if (arg == "--F" && i + 1 < argc) {
+      options.F = std::atof(argv[++i]);
+    } else if (arg == "--CR" && i + 1 < argc) {
+      options.CR = std::atof(argv[++i]);
+    } else if (arg == "--tolerance" && i + 1 < argc) {
+      options.tolerance = std::atof(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      options.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      options.threads = std::atoi(argv[++i]);
+    } else if (arg == "--report" && i + 1 < argc) {
+      report = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--current" && i + 1 < argc) {
+      s.current = std::atof(argv[++i]);
+    } else if (arg == "--pulse" && i + 2 < argc) {
+      s.pulse_start = std::atof(argv[i + 1]);
+      s.pulse_end = std::atof(argv[i + 2]);
+      i += 2;
+    } else if (arg == "--time" && i + 1 < argc) {
+      s.time = std::atof(argv[++i]);
+    } else if (arg == "--step" && i + 1 < argc) {
+      s.h = std::atof(argv[++i]);
+    } else if (arg == "--penalty" && i + 1 < argc) {
+      s.penalty = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr,
+                   "Uso: %s (--target traza.txt | --target-spikes spikes.txt) "
+                   "[--cost trace|spikes] [--fit p1,p2,...] [--range p min max] "
+                   "[--population n] [--generations n] [--F x] [--CR x] [--tolerance x] "
+                   "[--seed n] [--threads n] [--report n] [--current nA] "
+                   "[--pulse inicio final] [--time ms] [--step ms] [--penalty ms]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+  if (trace_path.empty() == spikes_path.empty()) {
+    std::fprintf(stderr, "Hace falta --target o --target-spikes (sólo uno)\n");
+    return 1;
+  }
+  if (cost.empty()) {
+    cost = trace_path.empty() ? "spikes" : "trace";
+  }
+  if (cost != "trace" && cost != "spikes") {
+    std::fprintf(stderr, "Coste no válido: %s\n", cost.c_str());
+    return 1;
+  }
+  if (cost == "trace" && trace_path.empty()) {
+    std::fprintf(stderr, "El coste trace necesita --target\n");
+    return 1;
+  }
+  s.spike_cost = cost == "spikes";
+
+  Target target;
+  try {
+    if (!trace_path.empty()) {
+      read_trace(trace_path, s.h, target);
+    } else {
+      read_spikes(spikes_path, target);
+    }
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+  if (std::isnan(s.time)) {
+    // Hasta la última fila de la traza o 500 ms tras el último spike
+    s.time = !target.steps.empty() ? (target.steps.back() + 1) * s.h
+             : !target.spikes.empty() ? target.spikes.back() + 500.0
+                                      : s.pulse_end + 500.0;
+  }
+
+  // Límites de búsqueda: --range o la Tabla 1 +-50%
+  CGC::ConstructorArgs table;
+  CGCNeuron<CGC>::args(table);
+  std::vector<double> lower, upper, published;
+  for (const std::string &name : fit) {
+    auto p = parameter_names.find(name);
+    if (p == parameter_names.end()) {
+      std::fprintf(stderr, "Parámetro no válido: %s\n", name.c_str());
+      return 1;
+    }
+    s.fit.push_back(p->second);
+    const double value = table.params[p->second];
+    auto r = ranges.find(name);
+    if (r != ranges.end()) {
+      lower.push_back(r->second.first);
+      upper.push_back(r->second.second);
+    } else {
+      lower.push_back(value - 0.5 * std::fabs(value));
+      upper.push_back(value + 0.5 * std::fabs(value));
+    }
+    published.push_back(value);
+  }
+
+  Stimulus stimulus =
+      StimulusProtocol().pulse(s.pulse_start, s.pulse_end, s.current).compile(s.h);
+  auto cost_function = [&](const std::vector<double> &x, double bound) {
+    return evaluate(s, target, stimulus, x, bound);
+  };
+
+  std::fprintf(stderr, "Coste de la Tabla 1: %g (%zu spikes en el registro)\n",
+               cost_function(published, std::numeric_limits<double>::infinity()),
+               target.spikes.size());
+  std::fprintf(stderr, "%10s %12s %12s %12s %10s %8s\n", "generación", "mejor", "mediana",
+               "evaluaciones", "cortados", "s");
+
+  const auto t0 = std::chrono::steady_clock::now();
+  DifferentialEvolution de(lower, upper, options);
+  de.add(published);
+  DifferentialEvolutionResult result;
+  try {
+    result = de.minimize(cost_function, [&](int g, const DifferentialEvolutionResult &r) {
+      const double seconds =
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      std::fprintf(stderr, "%10d %12.6g %12.6g %12ld %10ld %8.1f\n", g,
+                   *std::min_element(r.costs.begin(), r.costs.end()),
+                   DifferentialEvolution::median(r.costs), r.evaluations, r.cut_off, seconds);
+    });
+  } catch (const std::exception &e) {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  // Los mejores conjuntos de parámetros
+  std::printf("# coste");
+  for (const std::string &name : fit) {
+    std::printf(" %s", name.c_str());
+  }
+  std::printf("\n");
+  for (std::size_t k = 0; k < std::min(report, result.population.size()); ++k) {
+    std::printf("%.6g", result.costs[k]);
+    for (double x : result.population[k]) {
+      std::printf(" %.6g", x);
+    }
+    std::printf("\n");
+  }
+  return 0;
+}
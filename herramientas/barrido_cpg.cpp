@@ -0,0 +1,242 @@
+/*************************************************************
+ * barrido_cpg.cpp - Barrido de parámetros del CPG de Lymnaea
+ *
+ * Simula el CPG completo (LymnaeaCPG.h, misma red que
+ * cpg_completo.cpp) sobre una rejilla de parámetros. Cada punto de
+ * la rejilla es una instancia independiente con sus 4 neuronas y sus
+ * 8 sinapsis, y los puntos se reparten entre todos los núcleos con
+ * un pool de robo de tareas.
+ *
+ * Uso:
+ *   ./CPGSweep --grid <param> <min> <max> <n> [--grid ...]
+ *              [--time ms] [--step ms] [--threads n] [--binary f.ntr]
+ *              [--warm-start estado.ckp]
+ *              [--until-converged] [--cycle-tolerance x]
+ *
+ * <param> es I_drive_<so|n1m|n2v|n3t>, gsyn_<sinapsis> o
+ * tau_syn_<sinapsis>, con <sinapsis> en n1m_n2v, n2v_n1m, n1m_n3t,
+ * n3t_n1m, n2v_n3t, n2v_so, so_n1m, so_n2v.
+ *
+ * Se escribe un registro por punto, en el orden de la rejilla:
+ *   punto, valores de los parámetros, número de spikes de N1M, N2v,
+ *   N3t y SO, número de ciclos N1M -> N2v -> N3t y media y desviación
+ *   del periodo, de los intervalos N1M-N2v y N2v-N3t y de los delays
+ *   N1M-N2v y N2v-N3t. Spikes, ráfagas y ciclos se detectan durante
+ *   la simulación (BurstDetector.h), sin guardar el voltaje.
+ *
+ * Con --warm-start todos los puntos parten del estado guardado (por
+ * ejemplo con ./CPG --save-state) y se simulan desde su instante hasta
+ * --time, sin repetir el transitorio inicial; las medidas cubren sólo
+ * ese tramo. Sin --warm-start cada punto parte del reposo de su red
+ * (SteadyState.h).
+ *
+ * Con --until-converged cada punto para en cuanto su ritmo llega al
+ * ciclo límite (LimitCycle.h, mapa de retorno de N1M desde el inicio
+ * del estímulo) o si no oscila, y el registro añade el estado final
+ * (0 sin converger, 1 ciclo límite, 2 sin oscilación) y el instante de
+ * parada. Las medidas cubren entonces sólo lo simulado.
+ *
+ *************************************************************/
+
+#include <BurstDetector.h>
+#include <Checkpoint.h>
+#include <LimitCycle.h>
+#include <LymnaeaCPG.h>
+#include <Trace.h>
+#include <WorkStealingPool.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef LymnaeaCPG<RungeKutta4, double> CPG;
+
+struct GridAxis {
+  std::string name;
+  double min, max;
+  int n;
+
+  double value(int k) const {
+    return n > 1 ? min + (max - min) * k / (n - 1) : min;
+  }
+};
+
+int main(int argc, char **argv) {
+  std::vector<GridAxis> grid;
+  double simulation_time = 10000;  // ms
+  double step = 0.01;              // ms
+  unsigned threads = std::thread::hardware_concurrency();
+  TraceOptions output;
+  std::unique_ptr<Checkpoint> warm_start;
+  bool until_converged = false;
+  LimitCycleOptions cycle_options;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--grid" && i + 4 < argc) {
+      GridAxis axis{argv[i + 1], std::atof(argv[i + 2]), std::atof(argv[i + 3]),
+                    std::atoi(argv[i + 4])};
+      if (!CPGParameters().set(axis.name, 0.0) || axis.n < 1) {
+        std::fprintf(stderr, "Eje de barrido no válido: %s\n", axis.name.c_str());
+        return 1;
+      }
+      grid.push_back(axis);
+      i += 4;
+    } else if (arg == "--time" && i + 1 < argc) {
+      simulation_time = std::atof(argv[++i]);
+    } else if (arg == "--step" && i + 1 < argc) {
+      step = std::atof(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = std::atoi(argv[++i]);
+    } else if (arg == "--binary" && i + 1 < argc) {
+      output.binary_path = argv[++i];
+    } else if (arg == "--warm-start" && i + 1 < argc) {
+      const char *path = argv[++i];
+      try {
+        warm_start = std::make_unique<Checkpoint>(Checkpoint::read(path));
+        CPG probe;
+        probe.restore(*warm_start);  // Falla aquí y no dentro del pool
+      } catch (const std::runtime_error &e) {
+        std::fprintf(stderr, "--warm-start %s: %s\n", path, e.what());
+        return 1;
+      }
+    } else if (arg == "--until-converged") {
+      until_converged = true;
+    } else if (arg == "--cycle-tolerance" && i + 1 < argc) {
+      cycle_options.tolerance = cycle_options.period_tolerance = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr, "Argumento no reconocido: %s\n", arg.c_str());
+      return 1;
+    }
+  }
+
+  if (warm_start && warm_start->h() != step) {
+    std::fprintf(stderr, "--warm-start: paso %g distinto de %g\n", warm_start->h(), step);
+    return 1;
+  }
+  const long first = warm_start ? warm_start->step() : 0;
+  const long steps = std::lround(simulation_time / step);
+
+  std::size_t n_points = 1;
+  for (const GridAxis &axis : grid) {
+    n_points *= axis.n;
+  }
+
+  std::vector<std::string> columns = {"punto"};
+  for (const GridAxis &axis : grid) {
+    columns.push_back(axis.name);
+  }
+  const char *neurons[] = {"N1M", "N2v", "N3t", "SO"};
+  for (const char *name : neurons) {
+    columns.push_back(std::string("spikes_") + name);
+  }
+  columns.push_back("ciclos");
+  const char *measures[] = {"periodo", "intervalo_N1M_N2v", "intervalo_N2v_N3t",
+                            "delay_N1M_N2v", "delay_N2v_N3t"};
+  for (const char *name : measures) {
+    columns.push_back(std::string(name) + "_media");
+    columns.push_back(std::string(name) + "_std");
+  }
+  if (until_converged) {
+    columns.push_back("estado");
+    columns.push_back("t_final");
+  }
+
+  std::vector<std::vector<double>> results(n_points);
+
+  auto start = std::chrono::steady_clock::now();
+
+  WorkStealingPool pool(threads);
+  pool.parallel_for(n_points, [&](std::size_t point) {
+    // Índice del punto -> valor en cada eje (el primer eje varía más lento)
+    CPGParameters params;
+    std::vector<double> &record = results[point];
+    record.push_back(point);
+    std::size_t rest = point;
+    std::vector<double> values(grid.size());
+    for (std::size_t a = grid.size(); a-- > 0;) {
+      values[a] = grid[a].value(rest % grid[a].n);
+      rest /= grid[a].n;
+    }
+    for (std::size_t a = 0; a < grid.size(); ++a) {
+      params.set(grid[a].name, values[a]);
+      record.push_back(values[a]);
+    }
+
+    CPG cpg(params);
+    if (warm_start) {
+      cpg.restore(*warm_start);
+    } else {
+      cpg.steady_state();  // Reposo de la red con estos parámetros
+    }
+    PhaseIntervals<3> cycles;
+    BurstDetector so;
+    RunningStats stats[5];
+    auto accumulate = [&](bool cycle) {
+      if (cycle) {
+        const PhaseIntervals<3>::Cycle &c = cycles.cycle();
+        const double values[] = {c.period, c.interval[0], c.interval[1], c.delay[0],
+                                 c.delay[1]};
+        for (int m = 0; m < 5; ++m) {
+          stats[m].add(values[m]);
+        }
+      }
+    };
+
+    LimitCycleOptions options = cycle_options;
+    options.begin = params.t_stim_start;
+    LimitCycleMonitor monitor(CPG::n_state, options);
+    double state[CPG::n_state];
+    long last = steps;
+
+    for (long k = first; k < steps; ++k) {
+      const double time = k * step;
+      cpg.step(k, step);
+
+      const double v[] = {cpg.n1m.get(CPG::Neuron::v), cpg.n2v.get(CPG::Neuron::v),
+                          cpg.n3t.get(CPG::Neuron::v)};
+      accumulate(cycles.add(time, v));
+      so.add(time, cpg.so.get(CPG::Neuron::v));
+
+      if (until_converged) {
+        cpg.state(state);
+        // Estado tras el paso: tiempo (k + 1) h, como en LimitCycle.h
+        if (monitor.add((k + 1) * step, state) != LimitCycleMonitor::running) {
+          last = k + 1;
+          break;
+        }
+      }
+    }
+    accumulate(cycles.finish());
+
+    for (std::size_t p = 0; p < 3; ++p) {
+      record.push_back(cycles.detector(p).spikes());
+    }
+    record.push_back(so.spikes());
+    record.push_back(cycles.cycles());
+    for (const RunningStats &m : stats) {
+      record.push_back(m.n > 0 ? m.mean : NAN);
+      record.push_back(m.stddev());
+    }
+    if (until_converged) {
+      record.push_back(monitor.state());
+      record.push_back(std::max(first, last) * step);
+    }
+  });
+
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::fprintf(stderr, "%zu puntos en %.3f s con %zu hilos (%.2f puntos/s)\n",
+               n_points, elapsed, pool.size(), n_points / elapsed);
+
+  Trace trace(output, columns);
+  for (const std::vector<double> &record : results) {
+    trace.row(record.data(), record.size());
+  }
+
+  return 0;
+}
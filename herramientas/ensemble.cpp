@@ -0,0 +1,131 @@
+/*************************************************************
+ * ensemble.cpp - Integración por lotes SIMD frente a la escalar
+ *
+ * Crea un conjunto de variantes de N1M, N2v, N3t y SO (tau_p, g_eca
+ * y drive distintos en cada neurona) y lo integra dos veces con
+ * RungeKutta4: neurona a neurona con VavoulisModel<double> y por
+ * lotes con NeuronEnsemble (VavoulisModel<Lanes<double, W>>).
+ *
+ * Informa del rendimiento de cada ruta (pasos de neurona por
+ * segundo) y de la máxima diferencia de V entre ambas.
+ *
+ * Uso: ./Ensemble [neuronas] [tiempo_ms] [paso_ms]
+ *
+ *************************************************************/
+
+#include <NeuronEnsemble.h>
+#include <VavoulisModel.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+typedef NeuronEnsemble<VavoulisModel, RungeKutta4, double> Ensemble;
+typedef Ensemble::Neuron Neuron;
+
+// Reposo a -67 mV para cada tipo (mismas expresiones que neuronas/)
+template <typename N> void set_rest(N &n, int type, std::size_t i) {
+  double p = 0.0, q = 0.0;
+  switch (type) {
+  case 1: p = 1 / (1 + exp((-38.8 - (-67.0)) / 10.0)); break;
+  case 2: p = 1 / (1 + exp((-51 - (-67.0)) / 10.3));
+          q = 1 / (1 + exp((-45 - (-67.0)) / -3)); break;
+  case 3: p = 1 / (1 + exp((-61.6 - (-67)) / 5.6));
+          q = 1 / (1 + exp((-73.2 - (-67)) / -5.1)); break;
+  }
+  n.set(i, Neuron::v, -67);
+  n.set(i, Neuron::va, -67);
+  n.set(i, Neuron::p, p);
+  n.set(i, Neuron::q, q);
+  n.set(i, Neuron::h, 1 / (1 + exp((-55.2 - (-67.0)) / -7.1)));
+  n.set(i, Neuron::n, 1.0 / (1.0 + exp((-30.0 - (-67.0)) / 17.4)));
+}
+
+// Adaptador para usar set_rest con una neurona escalar
+struct Single {
+  Neuron &n;
+  void set(std::size_t, Neuron::variable var, double x) { n.set(var, x); }
+};
+
+int main(int argc, char **argv) {
+  const std::size_t n_neurons = argc > 1 ? std::atol(argv[1]) : 1024;
+  const double simulation_time = argc > 2 ? std::atof(argv[2]) : 500;  // ms
+  const double step = argc > 3 ? std::atof(argv[3]) : 0.01;            // ms
+
+  // Parámetros de la Tabla 1 con una variación aleatoria del 20%
+  std::mt19937 rng(2007);
+  std::uniform_real_distribution<double> jitter(0.8, 1.2);
+  const double tau_p[] = {1.0, 250.0, 1.0, 4.0};
+  const double tau_q[] = {1.0, 1.0, 1.0, 400.0};
+  const double g_eca[] = {8.0, 8.0, 0.06, 8.0};
+  const double g_ecs[] = {8.0, 8.0, 0.55, 8.0};
+  const double drive[] = {-10.0, -10.0, -5.0, 0.0};
+
+  std::vector<Neuron::ConstructorArgs> args(n_neurons);
+  std::vector<int> type(n_neurons);
+  std::vector<double> I(n_neurons);
+  for (std::size_t i = 0; i < n_neurons; ++i) {
+    type[i] = i % 4;
+    args[i].params[Neuron::n_type] = type[i];
+    args[i].params[Neuron::tau_p] = tau_p[type[i]] * jitter(rng);
+    args[i].params[Neuron::tau_q] = tau_q[type[i]];
+    args[i].params[Neuron::g_eca] = g_eca[type[i]] * jitter(rng);
+    args[i].params[Neuron::g_ecs] = g_ecs[type[i]];
+    I[i] = drive[type[i]] * jitter(rng);
+  }
+
+  const long steps = std::lround(simulation_time / step);
+
+  // Ruta escalar: una neurona de Neun por variante
+  std::vector<Neuron> scalar;
+  scalar.reserve(n_neurons);
+  for (std::size_t i = 0; i < n_neurons; ++i) {
+    scalar.emplace_back(args[i]);
+    Single s{scalar.back()};
+    set_rest(s, type[i], 0);
+  }
+
+  // Ruta por lotes
+  Ensemble ensemble(args, Neuron::n_type);
+  for (std::size_t i = 0; i < n_neurons; ++i) {
+    set_rest(ensemble, type[i], i);
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (long k = 0; k < steps; ++k) {
+    for (std::size_t i = 0; i < n_neurons; ++i) {
+      scalar[i].add_synaptic_input(I[i]);
+      scalar[i].step(step);
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (long k = 0; k < steps; ++k) {
+    for (std::size_t i = 0; i < n_neurons; ++i) {
+      ensemble.add_synaptic_input(i, I[i]);
+    }
+    ensemble.step(step);
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  double max_diff = 0.0;
+  for (std::size_t i = 0; i < n_neurons; ++i) {
+    max_diff = std::max(max_diff, std::fabs(scalar[i].get(Neuron::v) - ensemble.get(i, Neuron::v)));
+    max_diff = std::max(max_diff, std::fabs(scalar[i].get(Neuron::va) - ensemble.get(i, Neuron::va)));
+  }
+
+  double scalar_s = std::chrono::duration<double>(t1 - t0).count();
+  double batch_s = std::chrono::duration<double>(t2 - t1).count();
+  double neuron_steps = double(n_neurons) * steps;
+
+  std::printf("neuronas: %zu  lotes: %zu de %d carriles  pasos: %ld\n", n_neurons,
+              ensemble.batches(), Ensemble::width, steps);
+  std::printf("escalar: %.3f s  %.3g pasos-neurona/s\n", scalar_s, neuron_steps / scalar_s);
+  std::printf("lotes:   %.3f s  %.3g pasos-neurona/s  (x%.2f)\n", batch_s,
+              neuron_steps / batch_s, scalar_s / batch_s);
+  std::printf("max |V_escalar - V_lotes| al final: %.3g mV\n", max_diff);
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+/*************************************************************
+ * estimulo.cpp - Comprobación de los protocolos compilados
+ *
+ * Compila con StimulusProtocol los protocolos de los ejemplos
+ * (CPGNeurons::protocol y CGCNeuron::protocol) y dos trenes, uno con
+ * width == period, a varios pasos h y comprueba:
+ *
+ *   - la carga sum_k current(k) h frente a la integral pedida: con las
+ *     ventanas [start, end) es exacta si h divide los extremos; si no,
+ *     cada extremo puede desplazarse menos de un paso
+ *   - que breakpoints() devuelve los instantes pedidos y no los de la
+ *     rejilla
+ *
+ * Termina con código 1 si algún caso falla.
+ *
+ * Uso: ./StimulusGrid [--steps 0.001,0.01,0.03]
+ *
+ *************************************************************/
+
+#include <CGCNeuron.h>
+#include <LymnaeaCPG.h>
+#include <Stimulus.h>
+#include <VavoulisCGCModel.h>
+#include <VavoulisModel.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, RungeKutta4> Neuron;
+typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisCGCModel<double>>, RungeKutta4> CGC;
+
+struct Case {
+  std::string name;
+  StimulusProtocol protocol;
+  double duration;                  // ms
+  double charge;                    // Integral pedida (nA ms)
+  double current;                   // Mayor |I| de un extremo
+  std::vector<double> breakpoints;  // Instantes pedidos
+};
+
+std::vector<Case> cases() {
+  typedef CPGNeurons<Neuron> Setup;
+  typedef CPGParameters P;
+  return {
+      {"N1M", Setup::protocol(P::N1M), 2000, -10.0 * 1600, 10, {200, 1800}},
+      {"N2v", Setup::protocol(P::N2v), 3000, -5.0 * 2400, 5, {300, 2700}},
+      {"N3t", Setup::protocol(P::N3t), 4000, 8.0 * 800, 8, {1000, 1800}},
+      // -10 en [200, 2800) salvo tres ventanas de 100 ms a 15
+      {"SO", Setup::protocol(P::SO), 3000, -10.0 * 2600 + 3 * 100 * 25.0, 25,
+       {200, 800, 900, 1500, 1600, 2200, 2300, 2800}},
+      {"CGC", CGCNeuron<CGC>::protocol(), 3000, 0.2 * 2000, 0.2, {500, 2500}},
+      // Pulsos contiguos: ningún paso de la frontera cuenta dos veces
+      {"tren 50/50", StimulusProtocol().train(100, 600, 1.0, 50, 50), 1000, 500, 1, {100, 600}},
+      {"tren 20/50", StimulusProtocol().train(100, 600, 1.0, 20, 50), 1000, 10 * 20.0, 1,
+       {100, 120, 150, 170, 200, 220, 250, 270, 300, 320, 350, 370, 400, 420, 450, 470, 500,
+        520, 550, 570}},
+  };
+}
+
+// Si h divide t (con la tolerancia de compile)
+bool on_grid(double t, double h) { return std::fabs(t / h - std::round(t / h)) < 1e-9; }
+
+bool check(const Case &c, double h) {
+  Stimulus stimulus = c.protocol.compile(h);
+  const long steps = std::lround(c.duration / h);
+  double charge = 0.0;
+  for (long k = 0; k < steps; ++k) {
+    charge += stimulus.current(k) * h;
+  }
+
+  bool exact = std::all_of(c.breakpoints.begin(), c.breakpoints.end(),
+                           [h](double t) { return on_grid(t, h); });
+  double tolerance = 1e-9 * std::fabs(c.charge) + 1e-9;
+  if (!exact) {
+    tolerance += c.breakpoints.size() * c.current * h;
+  }
+  double error = std::fabs(charge - c.charge);
+
+  std::vector<double> times = stimulus.breakpoints().times();
+  bool breakpoints = times == c.breakpoints;
+
+  bool ok = error <= tolerance && breakpoints;
+  std::printf("  %-11s %7g  %12.6g  %12.6g  %10.3g  %-8s  %s\n", c.name.c_str(), h, charge,
+              c.charge, error, breakpoints ? "sí" : "no", ok ? "ok" : "FALLO");
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  std::vector<double> steps = {0.001, 0.01, 0.02, 0.05, 0.1, 0.03, 0.07};
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--steps" && i + 1 < argc) {
+      steps.clear();
+      std::stringstream list(argv[++i]);
+      for (std::string item; std::getline(list, item, ',');) {
+        steps.push_back(std::atof(item.c_str()));
+      }
+    } else {
+      std::fprintf(stderr, "Uso: %s [--steps h1,h2,...]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  std::printf("  %-11s %7s  %12s  %12s  %10s  %-8s\n", "protocolo", "h (ms)", "carga",
+              "pedida", "error", "cortes");
+  bool ok = true;
+  for (const Case &c : cases()) {
+    for (double h : steps) {
+      ok = check(c, h) && ok;
+    }
+  }
+  return ok ? 0 : 1;
+}
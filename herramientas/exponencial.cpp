@@ -0,0 +1,189 @@
+/*************************************************************
+ * exponencial.cpp - Precisión de RushLarsen frente a RungeKutta4
+ *
+ * Integra la CGC (estímulo de neuronas/CGC.cpp: 0.2 entre 500 y
+ * 2500 ms) y el plateau de N1M (neuronas/N1.cpp: -10 entre 200 y
+ * 1800 ms) con RungeKutta4 y con RushLarsen a varios pasos, y compara
+ * con RungeKutta4 a 0.001 ms como referencia:
+ *
+ *   - número de spikes y mayor desfase de sus instantes
+ *   - máximo |V - V_ref| en una rejilla de 0.1 ms
+ *   - evaluaciones del sistema y tiempo de cálculo
+ *
+ * Referencia y pruebas reciben el mismo pulso: las ventanas de
+ * Stimulus.h son semiabiertas [start, end), así que el pulso dura lo
+ * mismo con cualquier paso que divida sus extremos, y la diferencia es
+ * sólo error del integrador. Un paso que no los divide se rechaza.
+ *
+ * Un resultado con V no finito o fuera de [-200, 200] mV se marca
+ * como inestable.
+ *
+ * Uso: ./Exponential [--steps 0.01,0.05,0.1]
+ *
+ *************************************************************/
+
+#include <CGCNeuron.h>
+#include <DifferentialNeuronWrapper.h>
+#include <LymnaeaCPG.h>
+#include <RungeKutta4.h>
+#include <RushLarsen.h>
+#include <SpikeTimes.h>
+#include <Stimulus.h>
+#include <SystemWrapper.h>
+#include <VavoulisCGCModel.h>
+#include <VavoulisModel.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+template <typename Integrator>
+using CGC = DifferentialNeuronWrapper<SystemWrapper<VavoulisCGCModel<double>>, Integrator>;
+template <typename Integrator>
+using N1M = DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, Integrator>;
+
+const double grid = 0.1;  // ms, rejilla de comparación
+
+struct Result {
+  SpikeTimes spikes;
+  std::vector<double> t, v;  // Muestras de V cada max(grid, h)
+  unsigned long evaluations = 0;
+  double seconds = 0;
+  bool stable = true;
+};
+
+// Integra con paso h y muestrea V cada grid ms (o cada paso si h es
+// mayor; grid y h deben ser múltiplo uno de otro). Los dos integradores
+// cuestan 4 evaluaciones por paso.
+template <typename Neuron>
+Result run(Neuron &n, double simulation_time, const StimulusProtocol &protocol, double h) {
+  Result result;
+  const long steps = std::lround(simulation_time / h);
+  const long per_sample = std::max(1L, std::lround(grid / h));
+  Stimulus stimulus = protocol.compile(h);
+
+  auto t0 = std::chrono::steady_clock::now();
+  result.spikes.add(0.0, n.get(Neuron::v));
+  result.t.push_back(0.0);
+  result.v.push_back(n.get(Neuron::v));
+  for (long k = 0; k < steps; ++k) {
+    n.add_synaptic_input(stimulus.current(k));
+    n.step(h);
+    if ((k + 1) % per_sample == 0) {
+      double v = n.get(Neuron::v);
+      if (!std::isfinite(v) || std::fabs(v) > 200.0) {
+        result.stable = false;
+        break;
+      }
+      result.spikes.add((k + 1) * h, v);
+      result.t.push_back((k + 1) * h);
+      result.v.push_back(v);
+    }
+  }
+  result.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  result.evaluations = 4 * steps;
+  return result;
+}
+
+void report(const char *name, double h, const Result &r, const Result &ref) {
+  if (!r.stable) {
+    std::printf("  %-12s %7g  inestable\n", name, h);
+    return;
+  }
+  // La referencia está en la rejilla; r puede estar en una más gruesa
+  double max_dv = 0.0;
+  for (std::size_t i = 0; i < r.v.size(); ++i) {
+    std::size_t k = std::lround(r.t[i] / grid);
+    if (k < ref.v.size()) {
+      max_dv = std::max(max_dv, std::fabs(r.v[i] - ref.v[k]));
+    }
+  }
+  std::printf("  %-12s %7g  %10lu  %8.3f  %6zu  %10.3g  %10.3g\n", name, h, r.evaluations,
+              r.seconds, r.spikes.size(), max_shift(r.spikes, ref.spikes), max_dv);
+}
+
+void header(const char *title, const Result &ref) {
+  std::printf("%s: referencia RungeKutta4 a 0.001 ms, %zu spikes\n", title, ref.spikes.size());
+  std::printf("  %-12s %7s  %10s  %8s  %6s  %10s  %10s\n", "integrador", "h (ms)",
+              "eval.", "s", "spikes", "desfase ms", "max |dV|");
+}
+
+template <typename Integrator> Result cgc(double h) {
+  typedef CGC<Integrator> Neuron;
+  typename Neuron::ConstructorArgs args;
+  CGCNeuron<Neuron>::args(args);
+  Neuron n(args);
+  CGCNeuron<Neuron>::rest(args.params,
+                          [&](typename Neuron::variable var, double x) { n.set(var, x); });
+  return run(n, CGCNeuron<Neuron>::simulation_time, CGCNeuron<Neuron>::protocol(), h);
+}
+
+template <typename Integrator> Result n1m(double h) {
+  typedef N1M<Integrator> Neuron;
+  typedef CPGNeurons<Neuron> Setup;
+  const int k = CPGParameters::N1M;
+  typename Neuron::ConstructorArgs args;
+  Setup::args(k, args);
+  Neuron n(args);
+  Setup::rest(k, [&](typename Neuron::variable var, double x) { n.set(var, x); });
+  return run(n, Setup::simulation_time(k), Setup::protocol(k), h);
+}
+
+// Si h divide todos los instantes en los que cambia el estímulo
+bool on_grid(const StimulusProtocol &protocol, double h) {
+  Breakpoints breaks = protocol.compile(h).breakpoints();
+  for (double t : breaks.times()) {
+    if (std::fabs(t / h - std::round(t / h)) > 1e-9) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  std::vector<double> steps = {0.01, 0.02, 0.05, 0.1};
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--steps" && i + 1 < argc) {
+      steps.clear();
+      std::stringstream list(argv[++i]);
+      for (std::string item; std::getline(list, item, ',');) {
+        steps.push_back(std::atof(item.c_str()));
+      }
+    } else {
+      std::fprintf(stderr, "Uso: %s [--steps h1,h2,...]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  typedef CGC<RungeKutta4> CGCSetup;
+  typedef CPGNeurons<N1M<RungeKutta4>> N1MSetup;
+  for (double h : steps) {
+    if (!on_grid(CGCNeuron<CGCSetup>::protocol(), h) ||
+        !on_grid(N1MSetup::protocol(CPGParameters::N1M), h)) {
+      std::fprintf(stderr, "El paso %g ms no divide los extremos de los pulsos\n", h);
+      return 1;
+    }
+  }
+
+  Result ref = cgc<RungeKutta4>(0.001);
+  header("CGC, 3000 ms", ref);
+  for (double h : steps) {
+    report("RungeKutta4", h, cgc<RungeKutta4>(h), ref);
+    report("RushLarsen", h, cgc<RushLarsen<1>>(h), ref);
+  }
+
+  ref = n1m<RungeKutta4>(0.001);
+  header("N1M plateau, 2000 ms", ref);
+  for (double h : steps) {
+    report("RungeKutta4", h, n1m<RungeKutta4>(h), ref);
+    report("RushLarsen", h, n1m<RushLarsen<2>>(h), ref);
+  }
+
+  return 0;
+}
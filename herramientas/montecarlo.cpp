@@ -0,0 +1,317 @@
+/*************************************************************
+ * montecarlo.cpp - Ensayos Monte Carlo con corriente ruidosa
+ *
+ * Repite la simulación del CPG (circuitos/cpg_completo.cpp) o de la
+ * CGC (neuronas/CGC.cpp) --trials veces sumando al drive constante
+ * (I_drive_* del CPG, I_inj de la CGC) una corriente de ruido blanco u
+ * Ornstein-Uhlenbeck (NoiseCurrent.h), independiente para cada neurona
+ * y cada ensayo, mientras dura el estímulo.
+ *
+ * El ruido sale de un Philox con clave --seed y flujo (ensayo,
+ * neurona): el ensayo i da el mismo resultado con cualquier --threads.
+ * Los ensayos se reparten entre los núcleos con WorkStealingPool y se
+ * agregan en orden de ensayo, así que la salida tampoco depende del
+ * número de hilos.
+ *
+ * Frente a lanzar --trials procesos de ./CPG: el reposo de la red se
+ * resuelve una vez y todos los ensayos parten de él, no se escribe la
+ * traza (spikes, ráfagas y ciclos se detectan al vuelo como en
+ * CPGSweep) y no hay arranque de procesos.
+ *
+ * Se escribe, para cada medida (periodo, intervalos y delays de los
+ * ciclos N1M -> N2v -> N3t del CPG; intervalo entre spikes de la
+ * CGC), el número de valores, la media, la desviación, el coeficiente
+ * de variación y los extremos de todos los ensayos juntos, y la
+ * desviación entre ensayos de la media de cada uno. Con --records se
+ * guarda además una fila por ensayo (Trace.h).
+ *
+ * Uso: ./MonteCarlo [--circuit cpg|cgc] [--trials n] [--threads n]
+ *                   [--noise white|ou] [--sd nA] [--tau ms] [--seed n]
+ *                   [--time ms] [--step ms] [--records f.ntr]
+ *
+ *************************************************************/
+
+#include <BurstDetector.h>
+#include <CGCNeuron.h>
+#include <Checkpoint.h>
+#include <LymnaeaCPG.h>
+#include <NoiseCurrent.h>
+#include <SpikeTimes.h>
+#include <Stimulus.h>
+#include <Trace.h>
+#include <VavoulisCGCModel.h>
+#include <WorkStealingPool.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+typedef LymnaeaCPG<RungeKutta4, double> CPG;
+typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisCGCModel<double>>, RungeKutta4> CGC;
+
+struct Setup {
+  NoiseCurrent::kind noise = NoiseCurrent::ou;
+  double sd = NAN, tau = 5.0;
+  std::uint64_t seed = 1;
+  double h = 0.01, time = NAN;
+};
+
+struct Trial {
+  std::vector<long> spikes;
+  std::vector<RunningStats> measures;
+};
+
+/* CPG */
+
+const std::vector<std::string> cpg_measures = {"periodo", "intervalo_N1M_N2v",
+                                               "intervalo_N2v_N3t", "delay_N1M_N2v",
+                                               "delay_N2v_N3t"};
+
+Trial cpg_trial(const Checkpoint &rest, const Setup &setup, std::uint32_t trial) {
+  CPG cpg;
+  cpg.restore(rest);
+  const CPGParameters &p = cpg.parameters();
+  CPG::Neuron *neurons[] = {&cpg.n1m, &cpg.n2v, &cpg.n3t, &cpg.so};
+  std::vector<NoiseCurrent> noise;
+  for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+    noise.emplace_back(setup.noise, setup.sd, setup.tau, setup.h, Philox(setup.seed, trial, n));
+  }
+
+  Trial result{std::vector<long>(CPGParameters::n_neurons), std::vector<RunningStats>(5)};
+  PhaseIntervals<3> cycles;
+  BurstDetector so;
+  auto accumulate = [&](bool cycle) {
+    if (cycle) {
+      const PhaseIntervals<3>::Cycle &c = cycles.cycle();
+      const double values[] = {c.period, c.interval[0], c.interval[1], c.delay[0], c.delay[1]};
+      for (int m = 0; m < 5; ++m) {
+        result.measures[m].add(values[m]);
+      }
+    }
+  };
+
+  // El ruido acompaña al drive tónico (misma ventana sobre la rejilla)
+  CPGDrive drive(p);
+  const long steps = std::lround(setup.time / setup.h);
+  for (long k = 0; k < steps; ++k) {
+    const double time = k * setup.h;
+    if (drive.on(k, setup.h) != 0.0) {
+      for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+        neurons[n]->add_synaptic_input(noise[n].current(k));
+      }
+    }
+    cpg.step(k, setup.h);
+
+    const double v[] = {cpg.n1m.get(CPG::Neuron::v), cpg.n2v.get(CPG::Neuron::v),
+                        cpg.n3t.get(CPG::Neuron::v)};
+    accumulate(cycles.add(time, v));
+    so.add(time, cpg.so.get(CPG::Neuron::v));
+  }
+  accumulate(cycles.finish());
+
+  for (int n = 0; n < 3; ++n) {
+    result.spikes[n] = cycles.detector(n).spikes();
+  }
+  result.spikes[CPGParameters::SO] = so.spikes();
+  return result;
+}
+
+/* CGC */
+
+const std::vector<std::string> cgc_measures = {"isi"};
+
+// Reposo sin estímulo, desde x_inf(-60 mV) de cada compuerta
+std::vector<double> cgc_rest() {
+  CGC::ConstructorArgs args;
+  CGCNeuron<CGC>::args(args);
+  CGC n(args);
+  CGCNeuron<CGC>::rest(args.params, [&](CGC::variable var, double x) { n.set(var, x); });
+  SteadyState::rest(n);
+  std::vector<double> rest(CGC::n_variables);
+  for (std::size_t k = 0; k < CGC::n_variables; ++k) {
+    rest[k] = n.get(CGC::variable(k));
+  }
+  return rest;
+}
+
+Trial cgc_trial(const std::vector<double> &rest, const Setup &setup, std::uint32_t trial) {
+  typedef CGCNeuron<CGC> Defaults;
+  CGC::ConstructorArgs args;
+  Defaults::args(args);
+  CGC n(args);
+  for (std::size_t k = 0; k < CGC::n_variables; ++k) {
+    n.set(CGC::variable(k), rest[k]);
+  }
+  Stimulus pulse = StimulusProtocol()
+                       .pulse(Defaults::t_pulse_start, Defaults::t_pulse_end, 1.0)
+                       .compile(setup.h);
+  NoiseCurrent noise(setup.noise, setup.sd, setup.tau, setup.h, Philox(setup.seed, trial, 0));
+
+  Trial result{std::vector<long>(1), std::vector<RunningStats>(1)};
+  SpikeTimes spikes;
+  const long steps = std::lround(setup.time / setup.h);
+  for (long k = 0; k < steps; ++k) {
+    const double on = pulse.current(k);
+    n.add_synaptic_input(on * (Defaults::I_inj + noise.current(k)));
+    n.step(setup.h);
+    spikes.add((k + 1) * setup.h, n.get(CGC::v));
+  }
+  for (std::size_t s = 1; s < spikes.size(); ++s) {
+    result.measures[0].add(spikes.times[s] - spikes.times[s - 1]);
+  }
+  result.spikes[0] = spikes.size();
+  return result;
+}
+
+int main(int argc, char **argv) {
+  std::string circuit = "cpg";
+  std::size_t trials = 100;
+  unsigned threads = std::thread::hardware_concurrency();
+  Setup setup;
+  std::string records;
+  auto usage = [&] {
+    std::fprintf(stderr,
+                 "Uso: %s [--circuit cpg|cgc] [--trials n] [--threads n] "
+                 "[--noise white|ou] [--sd nA] [--tau ms] [--seed n] [--time ms] "
+                 "[--step ms] [--records f.ntr]\n",
+                 argv[0]);
+    return 1;
+  };
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--circuit" && i + 1 < argc) {
+      circuit = argv[++i];
+    } else if (arg == "--trials" && i + 1 < argc) {
+      trials = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = std::atoi(argv[++i]);
+    } else if (arg == "--noise" && i + 1 < argc) {
+      try {
+        setup.noise = NoiseCurrent::parse(argv[++i]);
+      } catch (const std::invalid_argument &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return usage();
+      }
+    } else if (arg == "--sd" && i + 1 < argc) {
+      setup.sd = std::atof(argv[++i]);
+    } else if (arg == "--tau" && i + 1 < argc) {
+      setup.tau = std::atof(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      setup.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--time" && i + 1 < argc) {
+      setup.time = std::atof(argv[++i]);
+    } else if (arg == "--step" && i + 1 < argc) {
+      setup.h = std::atof(argv[++i]);
+    } else if (arg == "--records" && i + 1 < argc) {
+      records = argv[++i];
+    } else {
+      return usage();
+    }
+  }
+  const bool is_cpg = circuit == "cpg";
+  if (!is_cpg && circuit != "cgc") {
+    std::fprintf(stderr, "Circuito no válido: %s\n", circuit.c_str());
+    return 1;
+  }
+  // Por defecto, el tiempo de cada ejemplo y un ruido del orden del 10%
+  // de su drive
+  if (std::isnan(setup.time)) {
+    setup.time = is_cpg ? 10000 : 3000;
+  }
+  if (std::isnan(setup.sd)) {
+    setup.sd = is_cpg ? 0.5 : 0.02;
+  }
+
+  // Reposo, una vez para todos los ensayos
+  auto t0 = std::chrono::steady_clock::now();
+  Checkpoint cpg_rest;
+  std::vector<double> neuron_rest;
+  if (is_cpg) {
+    CPG cpg;
+    cpg.steady_state();
+    cpg.save(cpg_rest);
+  } else {
+    neuron_rest = cgc_rest();
+  }
+  auto t1 = std::chrono::steady_clock::now();
+
+  std::vector<Trial> results(trials);
+  WorkStealingPool pool(threads);
+  pool.parallel_for(trials, [&](std::size_t trial) {
+    results[trial] = is_cpg ? cpg_trial(cpg_rest, setup, trial)
+                            : cgc_trial(neuron_rest, setup, trial);
+  });
+  auto t2 = std::chrono::steady_clock::now();
+
+  // Agregado en orden de ensayo
+  const std::vector<std::string> &names = is_cpg ? cpg_measures : cgc_measures;
+  const std::size_t n_spikes = is_cpg ? CPGParameters::n_neurons : 1;
+  std::vector<RunningStats> pooled(names.size()), between(names.size()), spikes(n_spikes);
+  for (const Trial &t : results) {
+    for (std::size_t m = 0; m < names.size(); ++m) {
+      pooled[m].merge(t.measures[m]);
+      between[m].add(t.measures[m].n > 0 ? t.measures[m].mean : NAN);
+    }
+    for (std::size_t n = 0; n < n_spikes; ++n) {
+      spikes[n].add(t.spikes[n]);
+    }
+  }
+
+  const double setup_s = std::chrono::duration<double>(t1 - t0).count();
+  const double run_s = std::chrono::duration<double>(t2 - t1).count();
+  std::printf("%s, %zu ensayos de %g ms a %g ms, ruido %s (sd %g nA", is_cpg ? "CPG" : "CGC",
+              trials, setup.time, setup.h, setup.noise == NoiseCurrent::ou ? "ou" : "white",
+              setup.sd);
+  if (setup.noise == NoiseCurrent::ou) {
+    std::printf(", tau %g ms", setup.tau);
+  }
+  std::printf("), semilla %llu\n", static_cast<unsigned long long>(setup.seed));
+  std::printf("reposo: %.3f s (una vez)  ensayos: %.3f s con %zu hilos (%.2f ensayos/s)\n",
+              setup_s, run_s, pool.size(), trials / run_s);
+  std::printf("spikes por ensayo:");
+  for (std::size_t n = 0; n < n_spikes; ++n) {
+    std::printf("  %s %.1f +- %.1f", is_cpg ? CPGParameters::neuron_name(n) : "CGC",
+                spikes[n].mean, spikes[n].stddev());
+  }
+  std::printf("\n%-18s %8s %10s %10s %7s %10s %10s %10s\n", "medida", "n", "media", "sd", "CV",
+              "mín", "máx", "sd ensayos");
+  for (std::size_t m = 0; m < names.size(); ++m) {
+    const RunningStats &s = pooled[m];
+    std::printf("%-18s %8ld %10.3f %10.3f %7.4f %10.3f %10.3f %10.3f\n", names[m].c_str(), s.n,
+                s.n ? s.mean : NAN, s.stddev(), s.stddev() / s.mean, s.n ? s.min : NAN,
+                s.n ? s.max : NAN, between[m].stddev());
+  }
+
+  if (!records.empty()) {
+    std::vector<std::string> columns = {"ensayo"};
+    for (std::size_t n = 0; n < n_spikes; ++n) {
+      columns.push_back(std::string("spikes_") + (is_cpg ? CPGParameters::neuron_name(n) : "CGC"));
+    }
+    for (const std::string &name : names) {
+      columns.push_back(name + "_n");
+      columns.push_back(name + "_media");
+      columns.push_back(name + "_std");
+    }
+    TraceOptions output;
+    output.binary_path = records;
+    Trace trace(output, columns);
+    std::vector<double> record;
+    for (std::size_t trial = 0; trial < trials; ++trial) {
+      const Trial &t = results[trial];
+      record.assign(1, double(trial));
+      for (long s : t.spikes) {
+        record.push_back(s);
+      }
+      for (const RunningStats &s : t.measures) {
+        record.push_back(s.n);
+        record.push_back(s.n > 0 ? s.mean : NAN);
+        record.push_back(s.stddev());
+      }
+      trace.row(record.data(), record.size());
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,135 @@
+/*************************************************************
+ * multipaso.cpp - CPG con pasos distintos para los componentes lentos
+ *
+ * Integra el CPG de circuitos/cpg_completo.cpp con MultiRateCPG en
+ * varias configuraciones "SO:sinapsis", donde SO es el stride de la
+ * neurona SO y sinapsis el de las sinapsis con tau_syn = 200 ms
+ * (n1m_n2v, so_n1m, so_n2v); el resto avanza con el paso base. La
+ * referencia es la configuración 1:1 (todo al paso base, igual que
+ * LymnaeaCPG).
+ *
+ * Para cada una: trabajo (pasos de componente frente a la referencia),
+ * tiempo, spikes de las cuatro neuronas y su mayor desfase, ciclos N1M
+ * -> N2v -> N3t y mayor diferencia de periodo, y el mayor error de la
+ * corriente extrapolada de las sinapsis lentas con las violaciones de
+ * --tolerance.
+ *
+ * Uso: ./MultiRate [--configs so:sin,...] [--step ms] [--time ms]
+ *                  [--tolerance x]
+ *
+ *************************************************************/
+
+#include <BurstDetector.h>
+#include <MultiRateCPG.h>
+#include <SpikeTimes.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef MultiRateCPG<> Net;
+
+struct Run {
+  std::vector<SpikeTimes> spikes = std::vector<SpikeTimes>(CPGParameters::n_neurons);
+  std::vector<double> periods;
+  MultiRateStatistics statistics;
+  double seconds = 0;
+};
+
+Run simulate(const MultiRateOptions &options, double h, double time) {
+  Net net(CPGParameters(), options);
+  net.cpg.steady_state();
+  net.reset_coupling();
+
+  Run run;
+  PhaseIntervals<3> cycles;
+  const long steps = std::lround(time / h);
+  auto t0 = std::chrono::steady_clock::now();
+  for (long k = 0; k < steps; ++k) {
+    net.step(k, h);
+    const double t = (k + 1) * h;
+    const double v[] = {net.cpg.n1m.get(Net::Neuron::v), net.cpg.n2v.get(Net::Neuron::v),
+                        net.cpg.n3t.get(Net::Neuron::v), net.cpg.so.get(Net::Neuron::v)};
+    for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+      run.spikes[n].add(t, v[n]);
+    }
+    if (cycles.add(t, v)) {
+      run.periods.push_back(cycles.cycle().period);
+    }
+  }
+  run.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  run.statistics = net.statistics();
+  return run;
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::pair<int, int>> configs = {{1, 5}, {1, 10}, {2, 10}, {4, 20}};
+  double h = 0.01;
+  double simulation_time = 10000;
+  double tolerance = MultiRateOptions().tolerance;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--configs" && i + 1 < argc) {
+      configs.clear();
+      std::stringstream list(argv[++i]);
+      for (std::string item; std::getline(list, item, ',');) {
+        int so = 1, synapses = 1;
+        if (std::sscanf(item.c_str(), "%d:%d", &so, &synapses) != 2) {
+          std::fprintf(stderr, "Configuración no válida: %s\n", item.c_str());
+          return 1;
+        }
+        configs.push_back({so, synapses});
+      }
+    } else if (arg == "--step" && i + 1 < argc) {
+      h = std::atof(argv[++i]);
+    } else if (arg == "--time" && i + 1 < argc) {
+      simulation_time = std::atof(argv[++i]);
+    } else if (arg == "--tolerance" && i + 1 < argc) {
+      tolerance = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr,
+                   "Uso: %s [--configs so:sin,...] [--step ms] [--time ms] [--tolerance x]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  const CPGParameters params;
+  MultiRateOptions lockstep;
+  lockstep.tolerance = tolerance;
+  const Run ref = simulate(lockstep, h, simulation_time);
+
+  std::printf("CPG, %g ms a %g ms: referencia %.3f s, %zu ciclos\n", simulation_time, h,
+              ref.seconds, ref.periods.size());
+  std::printf("%-7s %8s %8s  %7s  %10s  %6s  %10s  %10s  %s\n", "config", "trabajo", "speedup",
+              "spikes", "desfase ms", "ciclos", "periodo ms", "error máx", "violaciones");
+  for (const std::pair<int, int> &config : configs) {
+    MultiRateOptions options = MultiRateOptions::slow(params, config.first, config.second);
+    options.tolerance = tolerance;
+    Run run = simulate(options, h, simulation_time);
+
+    long spikes = 0;
+    double shift = 0.0;
+    for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+      spikes += run.spikes[n].size();
+      shift = std::max(shift, max_shift(run.spikes[n], ref.spikes[n]));
+    }
+    double period = run.periods.size() == ref.periods.size() ? 0.0 : INFINITY;
+    for (std::size_t c = 0; std::isfinite(period) && c < run.periods.size(); ++c) {
+      period = std::max(period, std::fabs(run.periods[c] - ref.periods[c]));
+    }
+    double error = *std::max_element(std::begin(run.statistics.max_error),
+                                     std::end(run.statistics.max_error));
+
+    char label[16];
+    std::snprintf(label, sizeof(label), "%d:%d", config.first, config.second);
+    std::printf("%-7s %8.3f %7.2fx  %7ld  %10.3g  %6zu  %10.3g  %10.3g  %ld\n", label,
+                run.statistics.work(), ref.seconds / run.seconds, spikes, shift,
+                run.periods.size(), period, error, run.statistics.violations);
+  }
+  return 0;
+}
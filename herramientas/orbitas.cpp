@@ -0,0 +1,271 @@
+/*************************************************************
+ * orbitas.cpp - Órbitas periódicas del CPG y continuación
+ *
+ * Calcula la órbita periódica (periodo y multiplicadores de Floquet)
+ * del CPG completo con drive constante (FusedLymnaeaCPG, 48
+ * variables) o de N1M aislada con una corriente I, por disparo
+ * (PeriodicOrbit.h), para una serie de valores de un parámetro:
+ *
+ *   ./PeriodicOrbits --continue I_drive_so -10 -7 13
+ *   ./PeriodicOrbits --circuit n1m --continue I -8 -4 9
+ *
+ * Para el primer valor la estimación inicial sale de simular hasta que
+ * el mapa de retorno de N1M se asienta (LimitCycle.h, como mucho
+ * --transient ms). Para los siguientes se extrapola linealmente desde
+ * las órbitas de los dos valores anteriores (o se parte de la del
+ * anterior); si Newton no converge desde ahí se vuelve a simular.
+ *
+ * Se escribe una fila por valor: parámetro, resultado, iteraciones de
+ * Newton, periodo, residuo, mayor multiplicador no trivial, estabilidad
+ * y tiempo. La sección es el voltaje del soma de N1M en -20 mV.
+ *
+ * Uso: ./PeriodicOrbits [--circuit cpg|n1m] [--continue param min max n]
+ *                       [--step ms] [--transient ms] [--tolerance x]
+ *                       [--threads n]
+ *
+ * param es cualquiera de CPGSweep (I_drive_so, gsyn_<sinapsis>, ...)
+ * para cpg, o I para n1m.
+ *
+ *************************************************************/
+
+#include <LimitCycle.h>
+#include <LymnaeaCPG.h>
+#include <PeriodicOrbit.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, RungeKutta4> Neuron;
+
+// CPG completo con el drive del estímulo siempre activo
+class CPGCircuit {
+public:
+  typedef FusedLymnaeaCPG<double>::Network System;
+  static constexpr std::size_t section = Neuron::v;  // N1M es la neurona 0
+
+  CPGCircuit(const std::string &name, double value) {
+    CPGParameters params;
+    if (!params.set(name, value)) {
+      throw std::invalid_argument("Parámetro no válido: " + name);
+    }
+    m_cpg = std::make_unique<FusedLymnaeaCPG<double>>(params);
+    m_cpg->set_drive(true);
+  }
+
+  System &system() { return m_cpg->network; }
+  double *parameters() { return m_cpg->network.parameters(); }
+  void step(double h) { m_cpg->network.step<RungeKutta4>(h); }
+  const double *state() { return m_cpg->network.variables(); }
+
+  PeriodicOrbitResult solve(const std::vector<double> &x0, double period,
+                            const PeriodicOrbitOptions &options) {
+    return PeriodicOrbit::solve(system(), parameters(), x0, period, options);
+  }
+
+private:
+  std::unique_ptr<FusedLymnaeaCPG<double>> m_cpg;
+};
+
+// N1M aislada con corriente constante I
+class N1MCircuit {
+public:
+  typedef Neuron System;
+  static constexpr std::size_t section = Neuron::v;
+
+  N1MCircuit(const std::string &name, double value) : m_I(value) {
+    if (name != "I") {
+      throw std::invalid_argument("Parámetro no válido para n1m: " + name);
+    }
+    Neuron::ConstructorArgs args;
+    CPGNeurons<Neuron>::args(CPGParameters::N1M, args);
+    m_neuron = std::make_unique<Neuron>(args);
+    CPGNeurons<Neuron>::rest(CPGParameters::N1M,
+                             [&](Neuron::variable var, double x) { m_neuron->set(var, x); });
+    for (std::size_t k = 0; k < Neuron::n_parameters; ++k) {
+      m_params[k] = m_neuron->get(static_cast<Neuron::parameter>(k));
+    }
+  }
+
+  void step(double h) {
+    m_neuron->add_synaptic_input(m_I);
+    m_neuron->step(h);
+  }
+  const double *state() {
+    state_variables(*m_neuron, m_state);
+    return m_state;
+  }
+
+  // La entrada pendiente entra en eval, como en SteadyState::rest
+  PeriodicOrbitResult solve(const std::vector<double> &x0, double period,
+                            const PeriodicOrbitOptions &options) {
+    m_neuron->add_synaptic_input(m_I);
+    PeriodicOrbitResult result = PeriodicOrbit::solve(*m_neuron, m_params, x0, period, options);
+    m_neuron->add_synaptic_input(-m_I);
+    return result;
+  }
+
+private:
+  double m_I;
+  std::unique_ptr<Neuron> m_neuron;
+  double m_params[Neuron::n_parameters];
+  double m_state[Neuron::n_variables];
+};
+
+struct Settings {
+  std::string name;
+  std::vector<double> values;
+  double h = 0.01, transient = 60000;
+  PeriodicOrbitOptions options;
+};
+
+// Punto de la sección y periodo tras simular hasta que el ritmo se asienta
+template <typename Circuit>
+bool simulate(Circuit &circuit, const Settings &s, std::vector<double> &x0, double &period) {
+  LimitCycleOptions options;
+  options.variable = Circuit::section;
+  options.tolerance = options.period_tolerance = 1e-2;
+  options.cycles = 1;
+  LimitCycleMonitor monitor(Circuit::System::n_variables, options);
+  const long steps = std::lround(s.transient / s.h);
+  for (long k = 0; k < steps; ++k) {
+    circuit.step(s.h);
+    if (monitor.add((k + 1) * s.h, circuit.state()) != LimitCycleMonitor::running) {
+      break;
+    }
+  }
+  if (monitor.returns() < 3) {
+    return false;
+  }
+  x0 = monitor.section_state();
+  period = monitor.period();
+  return true;
+}
+
+template <typename Circuit> void run(const Settings &s) {
+  std::printf("%12s  %-15s %4s %12s %10s %10s  %s  %8s\n", s.name.c_str(), "resultado", "it",
+              "periodo ms", "residuo", "|mu| máx", "estable", "s");
+  std::vector<double> x1, x2;  // Órbitas de los dos valores anteriores
+  double T1 = NAN, T2 = NAN, v1 = NAN, v2 = NAN;
+  for (double value : s.values) {
+    auto t0 = std::chrono::steady_clock::now();
+    Circuit circuit(s.name, value);
+
+    // Predicción desde las órbitas anteriores
+    std::vector<double> x0;
+    double period = NAN;
+    if (!x2.empty()) {
+      const double a = (value - v1) / (v1 - v2);
+      x0 = x1;
+      for (std::size_t i = 0; i < x0.size(); ++i) {
+        x0[i] += a * (x1[i] - x2[i]);
+      }
+      period = T1 + a * (T1 - T2);
+    } else if (!x1.empty()) {
+      x0 = x1;
+      period = T1;
+    }
+
+    PeriodicOrbitResult orbit;
+    bool guessed = !x0.empty();
+    if (guessed) {
+      orbit = circuit.solve(x0, period, s.options);
+    }
+    if (!orbit.converged) {
+      Circuit fresh(s.name, value);
+      guessed = simulate(fresh, s, x0, period);
+      if (guessed) {
+        orbit = circuit.solve(x0, period, s.options);
+      }
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const char *status = !guessed ? "sin oscilación" : orbit.converged ? "órbita" : "sin converger";
+    std::printf("%12g  %-15s %4d %12.4f %10.2g %10.4g  %-7s  %8.2f\n", value, status,
+                orbit.iterations, orbit.period, orbit.residual,
+                orbit.converged ? orbit.max_multiplier() : NAN,
+                orbit.converged ? (orbit.stable() ? "sí" : "no") : "-", seconds);
+    std::fflush(stdout);
+
+    if (orbit.converged) {
+      x2.swap(x1);
+      x1 = orbit.x0;
+      T2 = T1;
+      T1 = orbit.period;
+      v2 = v1;
+      v1 = value;
+    } else {
+      x1.clear();
+      x2.clear();
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  std::string circuit = "cpg";
+  Settings s;
+  double min = NAN, max = NAN;
+  int n = 1;
+  s.options.threads = std::thread::hardware_concurrency();
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--circuit" && i + 1 < argc) {
+      circuit = argv[++i];
+    } else if (arg == "--continue" && i + 4 < argc) {
+      s.name = argv[i + 1];
+      min = std::atof(argv[i + 2]);
+      max = std::atof(argv[i + 3]);
+      n = std::atoi(argv[i + 4]);
+      i += 4;
+    } else if (arg == "--step" && i + 1 < argc) {
+      s.h = s.options.h = std::atof(argv[++i]);
+    } else if (arg == "--transient" && i + 1 < argc) {
+      s.transient = std::atof(argv[++i]);
+    } else if (arg == "--tolerance" && i + 1 < argc) {
+      s.options.tolerance = std::atof(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      s.options.threads = std::atoi(argv[++i]);
+    } else {
+      std::fprintf(stderr,
+                   "Uso: %s [--circuit cpg|n1m] [--continue param min max n] [--step ms] "
+                   "[--transient ms] [--tolerance x] [--threads n]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+  if (circuit != "cpg" && circuit != "n1m") {
+    std::fprintf(stderr, "Circuito no válido: %s\n", circuit.c_str());
+    return 1;
+  }
+
+  // Sin --continue, el valor por defecto del drive
+  const CPGParameters defaults;
+  if (s.name.empty()) {
+    s.name = circuit == "cpg" ? "I_drive_so" : "I";
+    min = max = circuit == "cpg" ? defaults.I_drive_so : defaults.I_drive_n1m;
+    n = 1;
+  }
+  // Los constructores de los circuitos lanzan con un parámetro no válido
+  CPGParameters check = defaults;
+  if (circuit == "cpg" ? !check.set(s.name, min) : s.name != "I") {
+    std::fprintf(stderr, "Parámetro no válido para %s: %s\n", circuit.c_str(), s.name.c_str());
+    return 1;
+  }
+  for (int k = 0; k < n; ++k) {
+    s.values.push_back(n > 1 ? min + (max - min) * k / (n - 1) : min);
+  }
+  s.options.section = Neuron::v;
+
+  if (circuit == "cpg") {
+    run<CPGCircuit>(s);
+  } else {
+    run<N1MCircuit>(s);
+  }
+  return 0;
+}
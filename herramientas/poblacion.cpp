@@ -0,0 +1,153 @@
+/*************************************************************
+ * poblacion.cpp - CPG de Lymnaea a escala de poblaciones
+ *
+ * Cada neurona del CPG (N1M, N2v, N3t, SO) pasa a ser una clase de
+ * --per-class neuronas con tau_p, g_eca y drive variados un 20%, y
+ * cada una de las 8 sinapsis de la Tabla 2 un tipo de sinapsis con
+ * conexiones aleatorias entre las dos clases: cada par se conecta con
+ * probabilidad --in-degree / --per-class y con g_syn / --in-degree, de
+ * modo que la conductancia que recibe una neurona es en media la del
+ * CPG de cuatro neuronas cuando su clase presináptica se sincroniza.
+ *
+ * Se integra con Population (neuronas por lotes SIMD, sinapsis en CSR)
+ * y se informa del tamaño, la memoria de las sinapsis, el tiempo de
+ * construcción y por paso, y los spikes (cruces de -20 mV) y la
+ * frecuencia media de cada clase.
+ *
+ * Uso: ./Population [--per-class n] [--in-degree k] [--time ms]
+ *                   [--step ms] [--seed n]
+ *
+ * Los valores por defecto (2500 por clase, 50 conexiones por tipo)
+ * dan 1e4 neuronas y 1e6 sinapsis.
+ *
+ *************************************************************/
+
+#include <LymnaeaCPG.h>
+#include <Population.h>
+#include <Stimulus.h>
+#include <VavoulisModel.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef Population<VavoulisModel> Network;
+typedef Network::Neuron Neuron;
+typedef CPGParameters P;
+
+int main(int argc, char **argv) {
+  std::uint32_t per_class = 2500;
+  double in_degree = 50;
+  double simulation_time = 1000;
+  double step = 0.01;
+  std::uint64_t seed = 2007;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--per-class" && i + 1 < argc) {
+      per_class = std::atol(argv[++i]);
+    } else if (arg == "--in-degree" && i + 1 < argc) {
+      in_degree = std::atof(argv[++i]);
+    } else if (arg == "--time" && i + 1 < argc) {
+      simulation_time = std::atof(argv[++i]);
+    } else if (arg == "--step" && i + 1 < argc) {
+      step = std::atof(argv[++i]);
+    } else if (arg == "--seed" && i + 1 < argc) {
+      seed = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      std::fprintf(stderr,
+                   "Uso: %s [--per-class n] [--in-degree k] [--time ms] [--step ms] "
+                   "[--seed n]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+  if (per_class == 0 || !(in_degree > 0)) {
+    std::fprintf(stderr, "--per-class y --in-degree deben ser > 0\n");
+    return 1;
+  }
+
+  const P params;
+  const std::uint32_t n_neurons = per_class * P::n_neurons;
+  auto first = [&](int c) { return static_cast<std::uint32_t>(c) * per_class; };
+  auto type_of = [&](std::uint32_t i) { return static_cast<int>(i / per_class); };
+
+  // Neuronas: clase c en [c per_class, (c + 1) per_class)
+  std::mt19937_64 rng(seed);
+  std::uniform_real_distribution<double> jitter(0.8, 1.2);
+  std::vector<Neuron::ConstructorArgs> args(n_neurons);
+  std::vector<double> drive(n_neurons);
+  for (std::uint32_t i = 0; i < n_neurons; ++i) {
+    CPGNeurons<Neuron>::args(type_of(i), args[i]);
+    args[i].params[Neuron::tau_p] *= jitter(rng);
+    args[i].params[Neuron::g_eca] *= jitter(rng);
+    drive[i] = params.drive(type_of(i)) * jitter(rng);
+  }
+
+  auto t0 = std::chrono::steady_clock::now();
+  Network net(args, Neuron::n_type);
+  for (std::uint32_t i = 0; i < n_neurons; ++i) {
+    CPGNeurons<Neuron>::rest(type_of(i), [&](Neuron::variable var, double x) {
+      net.set(i, var, x);
+    });
+  }
+
+  // Un tipo de sinapsis por cada sinapsis del CPG
+  const double p = std::min(1.0, in_degree / per_class);
+  std::vector<Connection> connections;
+  for (int s = 0; s < P::n_synapses; ++s) {
+    connections.clear();
+    const int pre = P::synapse_pre(s), post = P::synapse_post(s);
+    connect_random(connections, first(pre), first(pre + 1), first(post), first(post + 1), p,
+                   params.gsyn[s] / (p * per_class), rng);
+    net.connect({params.esyn[s], params.tau_syn[s]}, connections);
+  }
+  auto t1 = std::chrono::steady_clock::now();
+
+  // Drive de cada clase entre t_stim_start y t_stim_end
+  Stimulus window = StimulusProtocol().pulse(params.t_stim_start, params.t_stim_end, 1.0).compile(step);
+  double on = -1.0;
+
+  std::vector<long> spikes(P::n_neurons, 0);
+  std::vector<double> v_prev(net.voltages().size(), 0.0);
+  for (std::uint32_t i = 0; i < n_neurons; ++i) {
+    v_prev[i] = net.get(i, Neuron::v);
+  }
+
+  const long steps = std::lround(simulation_time / step);
+  for (long k = 0; k < steps; ++k) {
+    double level = window.current(k);
+    if (level != on) {
+      for (std::uint32_t i = 0; i < n_neurons; ++i) {
+        net.set_input(i, level * drive[i]);
+      }
+      on = level;
+    }
+
+    net.step(step);
+
+    const std::vector<double> &v = net.voltages();
+    for (std::uint32_t i = 0; i < n_neurons; ++i) {
+      spikes[type_of(i)] += v_prev[i] < -20.0 && v[i] >= -20.0;
+      v_prev[i] = v[i];
+    }
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  const double build_s = std::chrono::duration<double>(t1 - t0).count();
+  const double run_s = std::chrono::duration<double>(t2 - t1).count();
+  std::printf("neuronas: %u (%u por clase, %zu lotes)  sinapsis: %zu en %d tipos (%.1f MB)\n",
+              n_neurons, per_class, net.neurons().batches(), net.synapses(),
+              static_cast<int>(P::n_synapses), net.synapse_bytes() / 1048576.0);
+  std::printf("construcción: %.3f s  simulación: %.3f s, %ld pasos (%.1f us/paso, "
+              "%.3g sinapsis-paso/s)\n",
+              build_s, run_s, steps, run_s / steps * 1e6, double(net.synapses()) * steps / run_s);
+  for (int c = 0; c < P::n_neurons; ++c) {
+    std::printf("  %-4s %10ld spikes  %8.2f Hz por neurona\n", P::neuron_name(c), spikes[c],
+                spikes[c] / (double(per_class) * simulation_time * 1e-3));
+  }
+  return 0;
+}
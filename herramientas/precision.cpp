@@ -0,0 +1,335 @@
+/*************************************************************
+ * precision.cpp - Validación de float y precisión mixta frente a double
+ *
+ * Integra los modelos de los ejemplos en tres precisiones:
+ *
+ *   double   RungeKutta4 con VavoulisModel<double> (referencia)
+ *   float    RungeKutta4 con VavoulisModel<float>
+ *   mixta    MixedRungeKutta4: estado en float, suma en double
+ *
+ * sobre estos casos:
+ *
+ *   N1M ... SO   neuronas/N1.cpp ... SO.cpp con su estímulo
+ *   CGC          neuronas/CGC.cpp (VavoulisCGCModel)
+ *   CPG          el CPG de circuitos/cpg_completo.cpp como red
+ *                fusionada (FusedLymnaeaCPG, con las 8 sinapsis en la
+ *                misma precisión)
+ *
+ * y compara con la referencia los instantes de spike (número y mayor
+ * desfase, de todas las neuronas), el voltaje paso a paso (máximo y
+ * RMS de |V - V_double|) y, en el CPG, los ciclos N1M -> N2v -> N3t
+ * de PhaseIntervals (número de ciclos y mayor diferencia en periodo,
+ * duraciones e intervalos). Una configuración es segura si tiene los
+ * mismos spikes y ciclos que double y las diferencias no pasan de
+ * --spike-tol, --burst-tol y --v-tol (RMS). Si la referencia no tiene
+ * spikes (o el CPG no tiene ciclos) no hay nada que comparar salvo el
+ * voltaje y el veredicto es "no concluye".
+ *
+ * Todos los casos se integran como FusedNetwork (las neuronas, como
+ * redes de una neurona), que es donde MixedRungeKutta4 guarda su
+ * estado en double.
+ *
+ * Uso: ./Precision [--step ms,ms,...] [--time ms] [--spike-tol ms]
+ *                  [--burst-tol ms] [--v-tol mV]
+ *
+ * --time es la duración del CPG; las neuronas usan la de su ejemplo.
+ * Sale con 2 si alguna configuración no es segura y con 3 si ninguna
+ * falla pero alguna no concluye.
+ *
+ *************************************************************/
+
+#include <BurstDetector.h>
+#include <CGCNeuron.h>
+#include <DifferentialNeuronWrapper.h>
+#include <FusedNetwork.h>
+#include <LymnaeaCPG.h>
+#include <MixedRungeKutta4.h>
+#include <RungeKutta4.h>
+#include <SpikeTimes.h>
+#include <SteadyState.h>
+#include <Stimulus.h>
+#include <SystemWrapper.h>
+#include <VavoulisCGCModel.h>
+#include <VavoulisModel.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Resultado de una simulación: voltaje en cada paso y spikes de cada
+// neurona, y ciclos del CPG
+struct Run {
+  std::vector<std::vector<double>> v;
+  std::vector<SpikeTimes> spikes;
+  std::vector<PhaseIntervals<3>::Cycle> cycles;
+  double ns_per_step = 0;
+};
+
+struct Case {
+  std::string name;
+  double time;  // ms; 0 para usar --time
+  std::function<Run(double h, double time)> precision[3];
+  bool cycles = false;  // El veredicto necesita ciclos en la referencia
+};
+
+const char *const precision_names[3] = {"double", "float", "mixta"};
+
+template <typename Loop> double timed(Loop loop, long steps) {
+  auto t0 = std::chrono::steady_clock::now();
+  loop();
+  return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0)
+             .count() / steps;
+}
+
+// Los modelos se evalúan en la precisión T; el integrador lo pone
+// FusedNetwork
+template <typename T>
+using Vavoulis = DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<T>>, RungeKutta4>;
+template <typename T>
+using CGC = DifferentialNeuronWrapper<SystemWrapper<VavoulisCGCModel<T>>, RungeKutta4>;
+
+/* Neuronas del CPG (neuronas/) */
+
+// Cada neurona se integra como una red fusionada de una neurona, que
+// es donde MixedRungeKutta4 guarda su estado en double
+template <typename Integrator, typename Network, typename Variable>
+Run single(Network &net, Variable v, Stimulus stimulus, double h, double time) {
+  Run run;
+  run.spikes.resize(1);
+  const long steps = std::lround(time / h);
+  run.v.assign(1, std::vector<double>(steps));
+  run.ns_per_step = timed([&] {
+    for (long k = 0; k < steps; ++k) {
+      net.set_input(0, stimulus.current(k));
+      net.template step<Integrator>(h);
+      run.v[0][k] = net.get(0, v);
+      run.spikes[0].add((k + 1) * h, run.v[0][k]);
+    }
+  }, steps);
+  return run;
+}
+
+template <typename Integrator, typename T>
+Run cpg_neuron(int k, double h, double time) {
+  typedef Vavoulis<T> Neuron;
+  std::array<typename Neuron::ConstructorArgs, 1> args;
+  CPGNeurons<Neuron>::args(k, args[0]);
+  FusedNetwork<Neuron, 1, 0> n(args, {});
+  CPGNeurons<Neuron>::rest(k, [&](typename Neuron::variable var, double x) { n.set(0, var, x); });
+  SteadyState::solve(n, n.variables(), n.parameters());
+  return single<Integrator>(n, Neuron::v, CPGNeurons<Neuron>::protocol(k).compile(h), h, time);
+}
+
+/* CGC (neuronas/CGC.cpp) */
+
+template <typename Integrator, typename T> Run cgc(double h, double time) {
+  typedef CGC<T> Neuron;
+  typedef typename Neuron::variable variable;
+  std::array<typename Neuron::ConstructorArgs, 1> args;
+  CGCNeuron<Neuron>::args(args[0]);
+  FusedNetwork<Neuron, 1, 0> n(args, {}, variable(VavoulisCGCModel<double>::v));
+  CGCNeuron<Neuron>::rest(args[0].params, [&](variable var, double x) { n.set(0, var, x); });
+  return single<Integrator>(n, variable(VavoulisCGCModel<double>::v),
+                            CGCNeuron<Neuron>::protocol().compile(h), h, time);
+}
+
+/* CPG (circuitos/cpg_completo.cpp) */
+
+template <typename Integrator, typename T> Run cpg(double h, double time) {
+  FusedLymnaeaCPG<T> net;
+  net.steady_state();
+
+  Run run;
+  run.spikes.resize(CPGParameters::n_neurons);
+  PhaseIntervals<3> cycles;
+  const long steps = std::lround(time / h);
+  run.v.assign(CPGParameters::n_neurons, std::vector<double>(steps));
+  run.ns_per_step = timed([&] {
+    for (long k = 0; k < steps; ++k) {
+      net.template step<Integrator>(k, h);
+      const double t = (k + 1) * h;
+      const double v[] = {net.v(CPGParameters::N1M), net.v(CPGParameters::N2v),
+                          net.v(CPGParameters::N3t), net.v(CPGParameters::SO)};
+      for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+        run.v[n][k] = v[n];
+        run.spikes[n].add(t, v[n]);
+      }
+      if (cycles.add(t, v)) {
+        run.cycles.push_back(cycles.cycle());
+      }
+    }
+    if (cycles.finish()) {
+      run.cycles.push_back(cycles.cycle());
+    }
+  }, steps);
+  return run;
+}
+
+/* Comparación con la referencia */
+
+struct Difference {
+  long spikes = 0;         // Spikes de la configuración
+  bool same_spikes = true; // Mismo número en cada neurona
+  double spike_shift = 0;  // ms
+  bool same_cycles = true;
+  double burst_shift = 0;  // ms
+  double v_max = 0;        // max |V - V_double|, mV
+  double v_rms = 0;        // RMS de |V - V_double|, mV
+};
+
+// |a - b|, con NaN igual a NaN y distinto de cualquier número
+double distance(double a, double b) {
+  if (std::isnan(a) || std::isnan(b)) {
+    return std::isnan(a) && std::isnan(b) ? 0.0 : std::numeric_limits<double>::infinity();
+  }
+  return std::fabs(a - b);
+}
+
+Difference compare(const Run &run, const Run &ref) {
+  Difference d;
+  for (std::size_t n = 0; n < run.spikes.size(); ++n) {
+    d.spikes += run.spikes[n].size();
+    double shift = max_shift(run.spikes[n], ref.spikes[n]);
+    d.same_spikes = d.same_spikes && std::isfinite(shift);
+    if (std::isfinite(shift)) {
+      d.spike_shift = std::max(d.spike_shift, shift);
+    }
+  }
+
+  double sum = 0;
+  std::size_t count = 0;
+  for (std::size_t n = 0; n < run.v.size(); ++n) {
+    for (std::size_t k = 0; k < run.v[n].size(); ++k) {
+      const double e = distance(run.v[n][k], ref.v[n][k]);
+      d.v_max = std::max(d.v_max, e);
+      sum += e * e;
+    }
+    count += run.v[n].size();
+  }
+  d.v_rms = count ? std::sqrt(sum / count) : 0.0;
+
+  d.same_cycles = run.cycles.size() == ref.cycles.size();
+  for (std::size_t c = 0; d.same_cycles && c < run.cycles.size(); ++c) {
+    const PhaseIntervals<3>::Cycle &a = run.cycles[c], &b = ref.cycles[c];
+    double shift = distance(a.period, b.period);
+    for (std::size_t p = 0; p < 3; ++p) {
+      shift = std::max(shift, distance(a.duration[p], b.duration[p]));
+    }
+    for (std::size_t p = 0; p < 2; ++p) {
+      shift = std::max(shift, distance(a.interval[p], b.interval[p]));
+    }
+    d.same_cycles = std::isfinite(shift);
+    d.burst_shift = std::max(d.burst_shift, shift);
+  }
+  return d;
+}
+
+// Las tres precisiones de un caso: run<Integrator, T>(h, time)
+#define PRECISIONS(run)                                                                        \
+  {[=](double h, double t) { return run<RungeKutta4, double>(h, t); },                      \
+   [=](double h, double t) { return run<RungeKutta4, float>(h, t); },                       \
+   [=](double h, double t) { return run<MixedRungeKutta4, float>(h, t); }}
+
+Case neuron_case(int k) {
+  auto run = [=]<typename Integrator, typename T>(double h, double t) {
+    return cpg_neuron<Integrator, T>(k, h, t);
+  };
+  return {CPGParameters::neuron_name(k), CPGNeurons<Vavoulis<double>>::simulation_time(k),
+          {[=](double h, double t) { return run.template operator()<RungeKutta4, double>(h, t); },
+           [=](double h, double t) { return run.template operator()<RungeKutta4, float>(h, t); },
+           [=](double h, double t) {
+             return run.template operator()<MixedRungeKutta4, float>(h, t);
+           }}};
+}
+
+int main(int argc, char **argv) {
+  std::vector<double> steps = {0.01, 0.05};
+  double cpg_time = 10000;
+  double spike_tol = 1.0, burst_tol = 5.0, v_tol = 2.0;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--step" && i + 1 < argc) {
+      steps.clear();
+      std::stringstream list(argv[++i]);
+      for (std::string item; std::getline(list, item, ',');) {
+        steps.push_back(std::atof(item.c_str()));
+      }
+    } else if (arg == "--time" && i + 1 < argc) {
+      cpg_time = std::atof(argv[++i]);
+    } else if (arg == "--spike-tol" && i + 1 < argc) {
+      spike_tol = std::atof(argv[++i]);
+    } else if (arg == "--burst-tol" && i + 1 < argc) {
+      burst_tol = std::atof(argv[++i]);
+    } else if (arg == "--v-tol" && i + 1 < argc) {
+      v_tol = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr,
+                   "Uso: %s [--step ms,ms,...] [--time ms] [--spike-tol ms] [--burst-tol ms] "
+                   "[--v-tol mV]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  typedef CPGParameters P;
+  const std::vector<Case> cases = {
+      neuron_case(P::N1M),
+      neuron_case(P::N2v),
+      neuron_case(P::N3t),
+      neuron_case(P::SO),
+      {"CGC", CGCNeuron<CGC<double>>::simulation_time, PRECISIONS(cgc)},
+      {"CPG", 0, PRECISIONS(cpg), true},
+  };
+
+  std::printf("Tolerancias: spikes %g ms, ráfagas %g ms, voltaje %g mV RMS\n", spike_tol,
+              burst_tol, v_tol);
+  std::printf("%-5s %6s  %-7s %8s  %7s  %10s  %9s  %9s  %6s  %10s  %s\n", "caso", "paso",
+              "prec.", "ns/paso", "spikes", "desfase ms", "|dV| máx", "|dV| RMS", "ciclos",
+              "ráfagas ms", "veredicto");
+  int unsafe = 0, inconclusive = 0;
+  for (const Case &c : cases) {
+    const double time = c.time > 0 ? c.time : cpg_time;
+    for (double h : steps) {
+      Run ref = c.precision[0](h, time);
+      for (int p = 0; p < 3; ++p) {
+        Run run = p == 0 ? ref : c.precision[p](h, time);
+        Difference d = compare(run, ref);
+        bool safe = d.same_spikes && d.spike_shift <= spike_tol && d.same_cycles &&
+                    d.burst_shift <= burst_tol && d.v_rms <= v_tol;
+        long ref_spikes = 0;
+        for (const SpikeTimes &spikes : ref.spikes) {
+          ref_spikes += spikes.size();
+        }
+        // Sin spikes o sin ciclos en la referencia los criterios de
+        // tiempos no comprueban nada
+        bool conclusive = ref_spikes > 0 && (!c.cycles || !ref.cycles.empty());
+        const char *verdict = p == 0         ? "referencia"
+                              : !safe        ? "NO"
+                              : !conclusive  ? "no concluye"
+                                             : "segura";
+        if (p > 0) {
+          unsafe += !safe;
+          inconclusive += safe && !conclusive;
+        }
+
+        char cycles[16] = "-", burst[16] = "-";
+        if (!run.cycles.empty() || !ref.cycles.empty()) {
+          std::snprintf(cycles, sizeof(cycles), "%zu", run.cycles.size());
+          std::snprintf(burst, sizeof(burst), "%.3g", d.same_cycles ? d.burst_shift : INFINITY);
+        }
+        std::printf("%-5s %6g  %-7s %8.1f  %7ld  %10.3g  %9.3g  %9.3g  %6s  %10s  %s\n",
+                    c.name.c_str(), h, precision_names[p], run.ns_per_step, d.spikes,
+                    d.same_spikes ? d.spike_shift : INFINITY, d.v_max, d.v_rms, cycles, burst,
+                    verdict);
+      }
+    }
+  }
+  return unsafe ? 2 : inconclusive ? 3 : 0;
+}
@@ -0,0 +1,181 @@
+/*************************************************************
+ * red_fusionada.cpp - CPG con integradores por objeto o fusionado
+ *
+ * Simula el CPG completo durante --time ms de tres formas:
+ *
+ *   - LymnaeaCPG: un RungeKutta4 por neurona y por sinapsis, como
+ *     cpg_completo.cpp, con acoplamiento fijo durante cada paso
+ *   - FusedLymnaeaCPG con RungeKutta4: toda la red en un vector y el
+ *     acoplamiento recalculado en cada etapa
+ *   - FusedLymnaeaCPG con DormandPrince54::Solver, por tramos entre
+ *     t_stim_start y t_stim_end y con salida densa cada 0.1 ms
+ *
+ * y compara con FusedLymnaeaCPG + RungeKutta4 a --reference ms:
+ * número de spikes de cada neurona, mayor desfase de sus instantes,
+ * evaluaciones de la red (una evaluación = derivada de las 4 neuronas
+ * y las 8 sinapsis) y tiempo de cálculo.
+ *
+ * Uso: ./FusedCPG [--time ms] [--reference ms] [--steps h1,h2,...]
+ *                 [--atol x] [--rtol x]
+ *
+ *************************************************************/
+
+#include <Breakpoints.h>
+#include <DormandPrince54.h>
+#include <LymnaeaCPG.h>
+#include <SpikeTimes.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const double grid = 0.1;  // ms, muestreo de los voltajes
+
+struct Result {
+  SpikeTimes spikes[CPGParameters::n_neurons];
+  unsigned long evaluations = 0;
+  double seconds = 0;
+  bool stable = true;
+};
+
+// Paso fijo h con cualquiera de las dos versiones del CPG
+template <typename Step, typename Voltage>
+Result fixed_step(double simulation_time, double h, Step step, Voltage v) {
+  Result result;
+  const long steps = std::lround(simulation_time / h);
+  const long per_sample = std::max(1L, std::lround(grid / h));
+  auto t0 = std::chrono::steady_clock::now();
+  for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+    result.spikes[k].add(0.0, v(k));
+  }
+  for (long i = 0; i < steps; ++i) {
+    step(i, h);
+    if ((i + 1) % per_sample == 0) {
+      for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+        double x = v(k);
+        if (!std::isfinite(x) || std::fabs(x) > 200.0) {
+          result.stable = false;
+          return result;
+        }
+        result.spikes[k].add((i + 1) * h, x);
+      }
+    }
+  }
+  result.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  result.evaluations = 4 * steps;
+  return result;
+}
+
+Result per_object(double simulation_time, double h) {
+  LymnaeaCPG<RungeKutta4> cpg;
+  typedef LymnaeaCPG<RungeKutta4>::Neuron Neuron;
+  const Neuron *neurons[CPGParameters::n_neurons] = {&cpg.n1m, &cpg.n2v, &cpg.n3t, &cpg.so};
+  return fixed_step(
+      simulation_time, h, [&](long k, double h) { cpg.step(k, h); },
+      [&](int k) { return neurons[k]->get(Neuron::v); });
+}
+
+Result fused(double simulation_time, double h) {
+  FusedLymnaeaCPG<> cpg;
+  return fixed_step(
+      simulation_time, h, [&](long k, double h) { cpg.step(k, h); },
+      [&](int k) { return cpg.v(k); });
+}
+
+Result adaptive(double simulation_time, double atol, double rtol) {
+  typedef FusedLymnaeaCPG<>::Network Network;
+  FusedLymnaeaCPG<> cpg;
+  Result result;
+  Breakpoints breaks{cpg.parameters().t_stim_start, cpg.parameters().t_stim_end,
+                     simulation_time};
+  DormandPrince54::Solver<Network> solver(atol, rtol);
+
+  auto t0 = std::chrono::steady_clock::now();
+  for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+    result.spikes[k].add(0.0, cpg.v(k));
+  }
+  for (double t = 0; t < simulation_time; t = breaks.next(t)) {
+    double t_end = breaks.next(t);
+    // El drive es constante dentro del tramo: el de su punto medio en
+    // la rejilla de muestreo
+    cpg.stimulate(std::lround(0.5 * (t + t_end) / grid), grid);
+    solver.integrate(cpg.network, cpg.network.variables(), cpg.network.parameters(), t,
+                     t_end, grid, [&](double t_k, const double *y) {
+                       for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+                         result.spikes[k].add(t_k, y[k * Network::neuron_variables +
+                                                     FusedLymnaeaCPG<>::Neuron::v]);
+                       }
+                     });
+  }
+  result.seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  result.evaluations = solver.statistics().evaluations;
+  return result;
+}
+
+void report(const char *name, const char *step, const Result &r, const Result &ref) {
+  if (!r.stable) {
+    std::printf("  %-24s %8s  inestable\n", name, step);
+    return;
+  }
+  std::printf("  %-24s %8s  %10lu  %8.2f", name, step, r.evaluations, r.seconds);
+  for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+    std::printf("  %4zu %9.3g", r.spikes[k].size(), max_shift(r.spikes[k], ref.spikes[k]));
+  }
+  std::printf("\n");
+}
+
+int main(int argc, char **argv) {
+  double simulation_time = 10000, reference = 0.001;
+  double atol = 1e-6, rtol = 1e-6;
+  std::vector<double> steps = {0.01, 0.02, 0.05, 0.1};
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "Falta el valor de %s\n", arg.c_str());
+      return 1;
+    }
+    std::string value = argv[++i];
+    if (arg == "--time") simulation_time = std::atof(value.c_str());
+    else if (arg == "--reference") reference = std::atof(value.c_str());
+    else if (arg == "--atol") atol = std::atof(value.c_str());
+    else if (arg == "--rtol") rtol = std::atof(value.c_str());
+    else if (arg == "--steps") {
+      steps.clear();
+      std::stringstream list(value);
+      for (std::string item; std::getline(list, item, ',');) {
+        steps.push_back(std::atof(item.c_str()));
+      }
+    } else {
+      std::fprintf(stderr, "Argumento no reconocido: %s\n", arg.c_str());
+      return 1;
+    }
+  }
+
+  Result ref = fused(simulation_time, reference);
+  std::printf("CPG completo, %g ms. Referencia: red fusionada con RungeKutta4 a %g ms "
+              "(%.1f s)\n",
+              simulation_time, reference, ref.seconds);
+  std::printf("  %-24s %8s  %10s  %8s", "", "h (ms)", "eval.", "s");
+  const char *names[CPGParameters::n_neurons] = {"N1M", "N2v", "N3t", "SO"};
+  for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+    std::printf("  %4s %9s", names[k], "desfase");
+  }
+  std::printf("\n");
+  report("referencia", "", ref, ref);
+
+  for (double h : steps) {
+    char label[32];
+    std::snprintf(label, sizeof(label), "%g", h);
+    report("por objeto, RungeKutta4", label, per_object(simulation_time, h), ref);
+    report("fusionada, RungeKutta4", label, fused(simulation_time, h), ref);
+  }
+  report("fusionada, DormandPrince54", "adapt.", adaptive(simulation_time, atol, rtol), ref);
+
+  return 0;
+}
@@ -0,0 +1,464 @@
+/*************************************************************
+ * rendimiento.cpp - Velocidad de integración de cada configuración
+ *
+ * Mide pasos por segundo y ns por evaluación del sistema, sin
+ * ninguna salida en el bucle, para los modelos y circuitos de los
+ * ejemplos:
+ *
+ *   HH            previo/basic.cpp (h = 0.001 ms)
+ *   HH-HH         previo/synapsis.cpp, acoplamiento eléctrico
+ *   N1M ... SO    neuronas/N1.cpp ... SO.cpp con su pulso
+ *   CGC           neuronas/CGC.cpp (y TabulatedCGC)
+ *   N1-2, N1-2-3  circuitos/n1-2.cpp y n1-2-3.cpp
+ *   CPG           circuitos/cpg_completo.cpp (LymnaeaCPG) y la red
+ *                 fusionada (FusedLymnaeaCPG)
+ *
+ * con varios integradores y precisiones. Cada caso se repite --trials
+ * veces, cada vez con una instancia nueva y tras una repetición de
+ * calentamiento, y se resume con media, desviación, mínimo, mediana y
+ * máximo. Una evaluación es una llamada a eval de un sistema: un paso
+ * de RungeKutta4 del CPG por objetos son 4 x (4 neuronas + 8
+ * sinapsis), y uno de la red fusionada, 4.
+ *
+ * Uso: ./Benchmark [--time ms] [--trials n] [--filter texto] [--json f]
+ *
+ * El JSON incluye el compilador y las opciones de compilación para
+ * comparar builds (por ejemplo con y sin -DNATIVE_ARCH=ON).
+ *
+ *************************************************************/
+
+#include <CGCNeuron.h>
+#include <DifferentialNeuronWrapper.h>
+#include <DormandPrince54.h>
+#include <ElectricalSynapsis.h>
+#include <GradualActivationSynapsis.h>
+#include <HodgkinHuxleyModel.h>
+#include <LymnaeaCPG.h>
+#include <MixedRungeKutta4.h>
+#include <RungeKutta4.h>
+#include <RushLarsen.h>
+#include <Stimulus.h>
+#include <SystemWrapper.h>
+#include <TabulatedCGC.h>
+#include <VavoulisCGCModel.h>
+#include <VavoulisModel.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifndef BENCHMARK_FLAGS
+#define BENCHMARK_FLAGS ""
+#endif
+
+// Simulación lista para correr: run(steps) avanza steps pasos y
+// devuelve las evaluaciones hechas; checksum evita que el compilador
+// descarte el cálculo
+struct Simulation {
+  std::function<unsigned long(long)> run;
+  std::function<double()> checksum;
+};
+
+struct Case {
+  std::string name, integrator, precision;
+  double step;  // ms
+  std::function<Simulation()> make;
+};
+
+struct Summary {
+  double mean, std, min, median, max;
+};
+
+Summary summarize(std::vector<double> x) {
+  std::sort(x.begin(), x.end());
+  Summary s{0, 0, x.front(), 0, x.back()};
+  for (double v : x) {
+    s.mean += v / x.size();
+  }
+  for (double v : x) {
+    s.std += (v - s.mean) * (v - s.mean);
+  }
+  s.std = x.size() > 1 ? std::sqrt(s.std / (x.size() - 1)) : 0.0;
+  std::size_t m = x.size() / 2;
+  s.median = x.size() % 2 ? x[m] : 0.5 * (x[m - 1] + x[m]);
+  return s;
+}
+
+/* Hodgkin-Huxley (previo/) */
+
+template <typename Integrator, typename T>
+using HH = DifferentialNeuronWrapper<SystemWrapper<HodgkinHuxleyModel<T>>, Integrator>;
+
+template <typename Neuron> void hh_setup(typename Neuron::ConstructorArgs &args) {
+  args.params[Neuron::cm] = 1 * 7.854e-3;
+  args.params[Neuron::vna] = 50;
+  args.params[Neuron::vk] = -77;
+  args.params[Neuron::vl] = -54.387;
+  args.params[Neuron::gna] = 120 * 7.854e-3;
+  args.params[Neuron::gk] = 36 * 7.854e-3;
+  args.params[Neuron::gl] = 0.3 * 7.854e-3;
+}
+
+template <typename Integrator, typename T> Simulation hh() {
+  typedef HH<Integrator, T> Neuron;
+  typename Neuron::ConstructorArgs args;
+  hh_setup<Neuron>(args);
+  auto n = std::make_shared<Neuron>(args);
+  n->set(Neuron::v, -80);
+  n->set(Neuron::m, 0.1);
+  n->set(Neuron::n, 0.7);
+  n->set(Neuron::h, 0.01);
+  return {[n](long steps) {
+            for (long k = 0; k < steps; ++k) {
+              n->step(0.001);
+            }
+            return 4ul * steps;
+          },
+          [n] { return double(n->get(Neuron::v)); }};
+}
+
+template <typename Integrator, typename T> Simulation hh_electrical() {
+  typedef HH<Integrator, T> Neuron;
+  typedef ElectricalSynapsis<Neuron, Neuron> Synapsis;
+  struct Net {
+    typename Neuron::ConstructorArgs args;
+    Neuron h1, h2;
+    Synapsis s;
+    Net() : h1((hh_setup<Neuron>(args), args)), h2(args),
+            s(h1, Neuron::v, h2, Neuron::v, -0.002, -0.002) {
+      h1.set(Neuron::v, -75);
+    }
+  };
+  auto net = std::make_shared<Net>();
+  return {[net](long steps) {
+            for (long k = 0; k < steps; ++k) {
+              net->s.step(0.001);
+              net->h1.add_synaptic_input(0.5);
+              net->h2.add_synaptic_input(0.5);
+              net->h1.step(0.001);
+              net->h2.step(0.001);
+            }
+            return 8ul * steps;
+          },
+          [net] { return double(net->h1.get(Neuron::v) + net->h2.get(Neuron::v)); }};
+}
+
+/* Neuronas del CPG (neuronas/) */
+
+template <typename Integrator, typename T>
+using Vavoulis = DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<T>>, Integrator>;
+
+template <typename Integrator, typename T> Simulation cpg_neuron(int k) {
+  typedef Vavoulis<Integrator, T> Neuron;
+  typename Neuron::ConstructorArgs args;
+  CPGNeurons<Neuron>::args(k, args);
+  auto n = std::make_shared<Neuron>(args);
+  CPGNeurons<Neuron>::rest(k, [&](typename Neuron::variable var, double x) { n->set(var, x); });
+  Stimulus stimulus = CPGNeurons<Neuron>::protocol(k).compile(0.01);
+  return {[n, stimulus](long steps) mutable {
+            for (long k = 0; k < steps; ++k) {
+              double I = stimulus.current(k);
+              if (I != 0.0) {
+                n->add_synaptic_input(I);
+              }
+              n->step(0.01);
+            }
+            return 4ul * steps;
+          },
+          [n] { return double(n->get(Neuron::v)); }};
+}
+
+/* CGC (neuronas/CGC.cpp) */
+
+template <typename Integrator, typename T> Simulation cgc() {
+  typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisCGCModel<T>>, Integrator> Neuron;
+  typename Neuron::ConstructorArgs args;
+  CGCNeuron<Neuron>::args(args);
+  auto n = std::make_shared<Neuron>(args);
+  CGCNeuron<Neuron>::rest(args.params,
+                          [&](typename Neuron::variable var, double x) { n->set(var, x); });
+  Stimulus pulse = CGCNeuron<Neuron>::protocol().compile(0.01);
+  return {[n, pulse](long steps) mutable {
+            unsigned long before = DormandPrince54::statistics().evaluations;
+            for (long k = 0; k < steps; ++k) {
+              double I = pulse.current(k);
+              if (I != 0.0) {
+                n->add_synaptic_input(I);
+              }
+              n->step(0.01);
+            }
+            // DormandPrince54 cuenta sus evaluaciones; los fijos hacen 4
+            unsigned long adaptive = DormandPrince54::statistics().evaluations - before;
+            return adaptive ? adaptive : 4ul * steps;
+          },
+          [n] { return double(n->get(Neuron::v)); }};
+}
+
+Simulation cgc_tabulated() {
+  typedef TabulatedCGC<double> Neuron;
+  typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisCGCModel<double>>, RungeKutta4> Args;
+  Args::ConstructorArgs args;
+  CGCNeuron<Args>::args(args);
+  auto n = std::make_shared<Neuron>(args.params);
+  CGCNeuron<Args>::rest(args.params, [&](Args::variable var, double x) { n->set(var, x); });
+  Stimulus pulse = CGCNeuron<Args>::protocol().compile(0.01);
+  return {[n, pulse](long steps) mutable {
+            for (long k = 0; k < steps; ++k) {
+              double I = pulse.current(k);
+              if (I != 0.0) {
+                n->add_synaptic_input(I);
+              }
+              n->step<RungeKutta4>(0.01);
+            }
+            return 4ul * steps;
+          },
+          [n] { return double(n->get(Neuron::Model::v)); }};
+}
+
+/* Circuitos (circuitos/) */
+
+// Subred del CPG por objetos, como n1-2.cpp y n1-2-3.cpp: neuronas y
+// sinapsis de la Tabla 2 elegidas por índice, drive en la ventana de
+// CPGDrive ([100, 9500) ms), como LymnaeaCPG
+template <typename Integrator, typename T> class SubCPG {
+public:
+  typedef Vavoulis<Integrator, T> Neuron;
+  typedef GradualActivationSynapsis<Neuron, Neuron, Integrator, T> Synapse;
+
+  SubCPG(const std::vector<int> &neurons, const std::vector<int> &synapses,
+         const std::vector<double> &drive)
+      : m_drive(drive), m_window(CPGParameters()) {
+    int index[CPGParameters::n_neurons];
+    for (int k : neurons) {
+      index[k] = m_neurons.size();
+      CPGNeurons<Neuron>::args(k, m_neuron_args.emplace_back());
+      Neuron &n = m_neurons.emplace_back(m_neuron_args.back());
+      CPGNeurons<Neuron>::rest(k, [&](typename Neuron::variable var, double x) { n.set(var, x); });
+    }
+    CPGParameters p;
+    for (int s : synapses) {
+      typename Synapse::ConstructorArgs &args = m_synapse_args.emplace_back();
+      args.params[Synapse::esyn] = p.esyn[s];
+      args.params[Synapse::gsyn] = p.gsyn[s];
+      args.params[Synapse::tau_syn] = p.tau_syn[s];
+      args.params[Synapse::v_pre] = -67.0;
+      args.params[Synapse::v_r] = -40.0;
+      args.params[Synapse::dec_slope] = 2.5;
+      m_synapses.emplace_back(m_neurons[index[CPGParameters::synapse_pre(s)]], Neuron::v,
+                              m_neurons[index[CPGParameters::synapse_post(s)]], Neuron::v,
+                              args, 1);
+    }
+  }
+
+  unsigned long run(long steps) {
+    for (long k = 0; k < steps; ++k) {
+      for (Synapse &s : m_synapses) {
+        s.step(0.01);
+      }
+      if (m_window.on(k, 0.01) != 0.0) {
+        for (std::size_t i = 0; i < m_neurons.size(); ++i) {
+          m_neurons[i].add_synaptic_input(m_drive[i]);
+        }
+      }
+      for (Neuron &n : m_neurons) {
+        n.step(0.01);
+      }
+    }
+    return 4ul * steps * (m_neurons.size() + m_synapses.size());
+  }
+
+  double checksum() const {
+    double sum = 0;
+    for (const Neuron &n : m_neurons) {
+      sum += n.get(Neuron::v);
+    }
+    return sum;
+  }
+
+private:
+  std::vector<double> m_drive;
+  CPGDrive m_window;
+  // deque: las sinapsis guardan referencias a las neuronas
+  std::deque<typename Neuron::ConstructorArgs> m_neuron_args;
+  std::deque<Neuron> m_neurons;
+  std::deque<typename Synapse::ConstructorArgs> m_synapse_args;
+  std::deque<Synapse> m_synapses;
+};
+
+template <typename Integrator, typename T>
+Simulation sub_cpg(std::vector<int> neurons, std::vector<int> synapses, std::vector<double> drive) {
+  auto net = std::make_shared<SubCPG<Integrator, T>>(neurons, synapses, drive);
+  return {[net](long steps) { return net->run(steps); }, [net] { return net->checksum(); }};
+}
+
+template <typename Integrator, typename T> Simulation cpg() {
+  auto net = std::make_shared<LymnaeaCPG<Integrator, T>>();
+  return {[net](long steps) {
+            for (long k = 0; k < steps; ++k) {
+              net->step(k, 0.01);
+            }
+            return 4ul * steps * (int(CPGParameters::n_neurons) + int(CPGParameters::n_synapses));
+          },
+          [net] { return double(net->n1m.get(LymnaeaCPG<Integrator, T>::Neuron::v)); }};
+}
+
+template <typename Integrator, typename T> Simulation cpg_fused() {
+  auto net = std::make_shared<FusedLymnaeaCPG<T>>();
+  return {[net](long steps) {
+            for (long k = 0; k < steps; ++k) {
+              net->template step<Integrator>(k, 0.01);
+            }
+            return 4ul * steps;
+          },
+          [net] { return double(net->v(CPGParameters::N1M)); }};
+}
+
+std::vector<Case> cases() {
+  typedef CPGParameters P;
+  const std::vector<int> n12 = {P::N1M, P::N2v};
+  const std::vector<int> n123 = {P::N1M, P::N2v, P::N3t};
+  const std::vector<int> s12 = {P::n1m_n2v, P::n2v_n1m};
+  const std::vector<int> s123 = {P::n1m_n2v, P::n2v_n1m, P::n1m_n3t, P::n3t_n1m, P::n2v_n3t};
+
+
+  return {
+      {"HH", "RungeKutta4", "double", 0.001, hh<RungeKutta4, double>},
+      {"HH", "RungeKutta4", "float", 0.001, hh<RungeKutta4, float>},
+      {"HH-HH", "RungeKutta4", "double", 0.001, hh_electrical<RungeKutta4, double>},
+      {"HH-HH", "RungeKutta4", "float", 0.001, hh_electrical<RungeKutta4, float>},
+      {"N1M", "RungeKutta4", "double", 0.01, [] { return cpg_neuron<RungeKutta4, double>(P::N1M); }},
+      {"N1M", "RungeKutta4", "float", 0.01, [] { return cpg_neuron<RungeKutta4, float>(P::N1M); }},
+      {"N1M", "RushLarsen", "double", 0.01, [] { return cpg_neuron<RushLarsen<2>, double>(P::N1M); }},
+      {"N2v", "RungeKutta4", "double", 0.01, [] { return cpg_neuron<RungeKutta4, double>(P::N2v); }},
+      {"N3t", "RungeKutta4", "double", 0.01, [] { return cpg_neuron<RungeKutta4, double>(P::N3t); }},
+      {"SO", "RungeKutta4", "double", 0.01, [] { return cpg_neuron<RungeKutta4, double>(P::SO); }},
+      {"CGC", "RungeKutta4", "double", 0.01, cgc<RungeKutta4, double>},
+      {"CGC", "RungeKutta4", "float", 0.01, cgc<RungeKutta4, float>},
+      {"CGC", "RushLarsen", "double", 0.01, cgc<RushLarsen<1>, double>},
+      {"CGC", "DormandPrince54", "double", 0.01, cgc<DormandPrince54, double>},
+      {"CGC tabulada", "RungeKutta4", "double", 0.01, cgc_tabulated},
+      {"N1-2", "RungeKutta4", "double", 0.01,
+       [=] { return sub_cpg<RungeKutta4, double>(n12, s12, {-6.0, -1.5}); }},
+      {"N1-2", "RungeKutta4", "float", 0.01,
+       [=] { return sub_cpg<RungeKutta4, float>(n12, s12, {-6.0, -1.5}); }},
+      {"N1-2-3", "RungeKutta4", "double", 0.01,
+       [=] { return sub_cpg<RungeKutta4, double>(n123, s123, {-6.0, -1.0, -3.0}); }},
+      {"CPG", "RungeKutta4", "double", 0.01, cpg<RungeKutta4, double>},
+      {"CPG", "RungeKutta4", "float", 0.01, cpg<RungeKutta4, float>},
+      {"CPG fusionado", "RungeKutta4", "double", 0.01, cpg_fused<RungeKutta4, double>},
+      {"CPG fusionado", "RungeKutta4", "float", 0.01, cpg_fused<RungeKutta4, float>},
+      {"CPG fusionado", "MixedRungeKutta4", "float", 0.01, cpg_fused<MixedRungeKutta4, float>},
+  };
+}
+
+struct Result {
+  const Case *c;
+  long steps;
+  double evaluations_per_step;
+  Summary steps_per_second, ns_per_step, ns_per_evaluation;
+  double checksum;
+};
+
+void json_summary(std::FILE *f, const char *name, const Summary &s, bool last = false) {
+  std::fprintf(f,
+               "      \"%s\": {\"mean\": %.6g, \"std\": %.6g, \"min\": %.6g, "
+               "\"median\": %.6g, \"max\": %.6g}%s\n",
+               name, s.mean, s.std, s.min, s.median, s.max, last ? "" : ",");
+}
+
+void write_json(const char *path, const std::vector<Result> &results, double time, int trials) {
+  std::FILE *f = std::fopen(path, "w");
+  if (!f) {
+    std::perror(path);
+    return;
+  }
+  std::fprintf(f, "{\n  \"compiler\": \"%s\",\n  \"flags\": \"%s\",\n", __VERSION__,
+               BENCHMARK_FLAGS);
+  std::fprintf(f, "  \"simulated_ms\": %g,\n  \"trials\": %d,\n  \"cases\": [\n", time, trials);
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const Result &r = results[i];
+    std::fprintf(f,
+                 "    {\n      \"name\": \"%s\",\n      \"integrator\": \"%s\",\n"
+                 "      \"precision\": \"%s\",\n      \"step_ms\": %g,\n      \"steps\": %ld,\n"
+                 "      \"evaluations_per_step\": %.6g,\n",
+                 r.c->name.c_str(), r.c->integrator.c_str(), r.c->precision.c_str(), r.c->step,
+                 r.steps, r.evaluations_per_step);
+    json_summary(f, "steps_per_second", r.steps_per_second);
+    json_summary(f, "ns_per_step", r.ns_per_step);
+    json_summary(f, "ns_per_evaluation", r.ns_per_evaluation);
+    std::fprintf(f, "      \"checksum\": %.17g\n    }%s\n", r.checksum,
+                 i + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(f, "  ]\n}\n");
+  std::fclose(f);
+}
+
+int main(int argc, char **argv) {
+  double time = 1000;  // ms simulados por repetición
+  int trials = 5;
+  std::string filter, json;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--time" && i + 1 < argc) {
+      time = std::atof(argv[++i]);
+    } else if (arg == "--trials" && i + 1 < argc) {
+      trials = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--filter" && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (arg == "--json" && i + 1 < argc) {
+      json = argv[++i];
+    } else {
+      std::fprintf(stderr, "Uso: %s [--time ms] [--trials n] [--filter texto] [--json f]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<Case> all = cases();
+  std::vector<Result> results;
+  std::printf("%-14s %-16s %-7s %12s %8s %10s %8s %10s\n", "caso", "integrador", "tipo",
+              "pasos/s", "+-%", "ns/paso", "eval/p", "ns/eval");
+  for (const Case &c : all) {
+    std::string label = c.name + " " + c.integrator + " " + c.precision;
+    if (!filter.empty() && label.find(filter) == std::string::npos) {
+      continue;
+    }
+    const long steps = std::max(1L, std::lround(time / c.step));
+
+    c.make().run(steps);  // Calentamiento
+
+    std::vector<double> rate, ns_step, ns_eval;
+    unsigned long evaluations = 0;
+    double checksum = 0;
+    for (int t = 0; t < trials; ++t) {
+      Simulation sim = c.make();
+      auto t0 = std::chrono::steady_clock::now();
+      evaluations = sim.run(steps);
+      double seconds =
+          std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+      checksum = sim.checksum();
+      rate.push_back(steps / seconds);
+      ns_step.push_back(seconds * 1e9 / steps);
+      ns_eval.push_back(evaluations ? seconds * 1e9 / evaluations : 0.0);
+    }
+
+    Result r{&c, steps, double(evaluations) / steps, summarize(rate), summarize(ns_step),
+             summarize(ns_eval), checksum};
+    std::printf("%-14s %-16s %-7s %12.4g %8.1f %10.1f %8.3g %10.2f\n", c.name.c_str(),
+                c.integrator.c_str(), c.precision.c_str(), r.steps_per_second.median,
+                100.0 * r.steps_per_second.std / r.steps_per_second.mean, r.ns_per_step.median,
+                r.evaluations_per_step, r.ns_per_evaluation.median);
+    results.push_back(r);
+  }
+
+  if (!json.empty()) {
+    write_json(json.c_str(), results, time, trials);
+  }
+  return 0;
+}
@@ -0,0 +1,196 @@
+/*************************************************************
+ * sensibilidad.cpp - Sensibilidad del CPG a las 8 gsyn en una pasada
+ *
+ * Integra LymnaeaCPG con precisión Dual<double, 8> (Dual.h) y la gsyn
+ * de cada sinapsis sembrada como parámetro independiente, así que en
+ * una sola simulación se obtiene la trayectoria y sus derivadas
+ * respecto a las 8 conductancias sinápticas:
+ *
+ *   ./Sensitivity --time 10000 --decimate 100 > sensibilidad.txt
+ *   ./Sensitivity --time 2000 --no-trace --check 1e-6
+ *
+ * La traza tiene 37 columnas: tiempo, el voltaje del soma de N1M, N2v,
+ * N3t y SO, y para cada una de esas neuronas (en ese orden) la
+ * derivada de su voltaje respecto a gsyn de cada sinapsis en el orden
+ * de CPGParameters (n1m_n2v, ..., so_n2v). El resto de argumentos son
+ * los de Trace.h.
+ *
+ * El estado inicial es el reposo de la red sin drive (como CPG) o el
+ * de --load-state (que sigue desde su instante); las derivadas son con
+ * ese estado inicial fijo.
+ *
+ * --check eps compara las derivadas del voltaje final con diferencias
+ * centradas (gsyn (1 +- eps), 16 simulaciones en double repartidas
+ * entre --threads hilos) y escribe por stderr ambas, la diferencia
+ * relativa mayor de las 4 neuronas y el tiempo de cada método.
+ *
+ * Uso: ./Sensitivity [--time ms] [--step ms] [--load-state fichero]
+ *                    [--check eps] [--threads n] [opciones de Trace.h]
+ *
+ *************************************************************/
+
+#include <Checkpoint.h>
+#include <Dual.h>
+#include <LymnaeaCPG.h>
+#include <Trace.h>
+#include <WorkStealingPool.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+typedef Dual<double, CPGParameters::n_synapses> D;
+typedef LymnaeaCPG<RungeKutta4, double> CPG;
+typedef LymnaeaCPG<RungeKutta4, D> DualCPG;
+
+// Voltaje del soma de cada neurona
+template <typename Network> auto voltages(const Network &cpg) {
+  typedef typename Network::Neuron Neuron;
+  return std::array<typename Network::Neuron::precission_t, CPGParameters::n_neurons>{
+      cpg.n1m.get(Neuron::v), cpg.n2v.get(Neuron::v), cpg.n3t.get(Neuron::v),
+      cpg.so.get(Neuron::v)};
+}
+
+// Voltajes finales de la red en double desde el estado inicial
+std::array<double, CPGParameters::n_neurons> simulate(const CPGParameters &params,
+                                                      const Checkpoint &initial, long steps,
+                                                      double h) {
+  CPG cpg(params);
+  cpg.restore(initial);
+  for (long k = initial.step(); k < steps; ++k) {
+    cpg.step(k, h);
+  }
+  return voltages(cpg);
+}
+
+int main(int argc, char **argv) {
+  double simulation_time = 10000, step = 0.01, eps = 0;
+  unsigned threads = std::thread::hardware_concurrency();
+  std::string load_path;
+  std::vector<char *> trace_args = {argv[0]};
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--time" && i + 1 < argc) {
+      simulation_time = std::atof(argv[++i]);
+    } else if (arg == "--step" && i + 1 < argc) {
+      step = std::atof(argv[++i]);
+    } else if (arg == "--load-state" && i + 1 < argc) {
+      load_path = argv[++i];
+    } else if (arg == "--check" && i + 1 < argc) {
+      eps = std::atof(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      threads = std::atoi(argv[++i]);
+    } else {
+      trace_args.push_back(argv[i]);
+    }
+  }
+
+  const CPGParameters params;
+  const long steps = std::lround(simulation_time / step);
+
+  // Estado inicial común a la red dual y a las diferencias finitas
+  Checkpoint initial;
+  if (!load_path.empty()) {
+    try {
+      initial = Checkpoint::read(load_path);
+      CPG probe(params);
+      probe.restore(initial);  // Falla aquí y no dentro del pool
+    } catch (const std::runtime_error &e) {
+      std::fprintf(stderr, "--load-state %s: %s\n", load_path.c_str(), e.what());
+      return 1;
+    }
+    if (initial.h() != step) {
+      std::fprintf(stderr, "%s: paso %g distinto de %g\n", load_path.c_str(), initial.h(), step);
+      return 1;
+    }
+  } else {
+    CPG cpg(params);
+    SteadyStateResult rest = cpg.steady_state();
+    if (!rest.converged) {
+      std::fprintf(stderr, "Reposo sin converger (residuo %g); se parte de -67 mV\n",
+                   rest.residual);
+    }
+    cpg.save(initial);
+  }
+
+  std::vector<std::string> columns = {"tiempo"};
+  for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+    columns.push_back(std::string("V_") + CPGParameters::neuron_name(n) + "_s");
+  }
+  for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      columns.push_back(std::string("dV_") + CPGParameters::neuron_name(n) + "_dgsyn_" +
+                        CPGParameters::synapse_name(s));
+    }
+  }
+  Trace trace(static_cast<int>(trace_args.size()), trace_args.data(), columns,
+              "[--time ms] [--step ms] [--load-state f.ckp] [--check eps] [--threads n]");
+
+  // Una pasada con las 8 tangentes
+  auto t0 = std::chrono::steady_clock::now();
+  DualCPG cpg(params, [&](int s, DualCPG::Synapse::ConstructorArgs &args) {
+    args.params[DualCPG::Synapse::gsyn] = D::variable(params.gsyn[s], s);
+  });
+  cpg.restore(initial);
+  std::vector<double> row(columns.size());
+  for (long k = initial.step(); k < steps; ++k) {
+    const double time = k * step;
+    cpg.step(k, step);
+    const auto v = voltages(cpg);
+    row[0] = time;
+    for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+      row[1 + n] = v[n].value();
+      for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+        row[1 + CPGParameters::n_neurons + n * CPGParameters::n_synapses + s] =
+            v[n].derivative(s);
+      }
+    }
+    trace.row(row.data(), row.size());
+  }
+  const double dual_seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  if (eps > 0) {
+    // Diferencias centradas: simulación 2 s + 0 con gsyn_s (1 + eps), 2 s + 1 con (1 - eps)
+    t0 = std::chrono::steady_clock::now();
+    std::vector<std::array<double, CPGParameters::n_neurons>> ends(2 * CPGParameters::n_synapses);
+    WorkStealingPool pool(std::max(1u, threads));
+    pool.parallel_for(ends.size(), [&](std::size_t j) {
+      CPGParameters p = params;
+      p.gsyn[j / 2] *= j % 2 == 0 ? 1 + eps : 1 - eps;
+      ends[j] = simulate(p, initial, steps, step);
+    });
+    const double fd_seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const auto v = voltages(cpg);
+    std::fprintf(stderr, "%-8s %14s %14s %10s\n", "gsyn", "dV_N1M dual", "dV_N1M dif.",
+                 "dif. rel.");
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      const double dg = 2 * eps * params.gsyn[s];
+      double worst = 0;
+      std::array<double, CPGParameters::n_neurons> fd;
+      for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+        fd[n] = (ends[2 * s][n] - ends[2 * s + 1][n]) / dg;
+        const double ad = v[n].derivative(s);
+        // Por debajo del redondeo de la diferencia no hay nada que comparar
+        const double noise = 8 * std::numeric_limits<double>::epsilon() *
+                             std::fabs(v[n].value()) / dg;
+        worst = std::max(worst, std::fabs(ad - fd[n]) /
+                                    std::max({std::fabs(ad), std::fabs(fd[n]), noise}));
+      }
+      std::fprintf(stderr, "%-8s %14.6g %14.6g %10.2g\n", CPGParameters::synapse_name(s),
+                   v[CPGParameters::N1M].derivative(s), fd[CPGParameters::N1M], worst);
+    }
+    std::fprintf(stderr, "dual: %.2f s, diferencias centradas: %.2f s (%u hilos)\n",
+                 dual_seconds, fd_seconds, std::max(1u, threads));
+  }
+  return 0;
+}
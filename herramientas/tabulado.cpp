@@ -0,0 +1,149 @@
+/*************************************************************
+ * tabulado.cpp - Precisión y coste de la CGC tabulada
+ *
+ * Integra la CGC de neuronas/CGC.cpp (0.2 entre 500 y 2500 ms) con
+ * RungeKutta4 y compara VavoulisCGCModel de Neun con TabulatedCGC:
+ *
+ *   exacta   TabulatedCGC sin tabla: comprueba que sus ecuaciones son
+ *            las de VavoulisCGCModel
+ *   lineal   tabla con interpolación lineal
+ *   cúbica   tabla con interpolación de Hermite
+ *
+ * Para cada una: error relativo máximo de la tabla frente a las
+ * expresiones exactas, tamaño de la tabla, tiempo por paso, spikes,
+ * mayor desfase de sus instantes y máximo |V - V_Neun|.
+ *
+ * Uso: ./Tabulated [--dv mV,mV,...] [--step ms] [--time ms]
+ *
+ *************************************************************/
+
+#include <CGCNeuron.h>
+#include <DifferentialNeuronWrapper.h>
+#include <RungeKutta4.h>
+#include <SpikeTimes.h>
+#include <Stimulus.h>
+#include <SystemWrapper.h>
+#include <TabulatedCGC.h>
+#include <VavoulisCGCModel.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisCGCModel<double>>, RungeKutta4> CGC;
+typedef TabulatedCGC<double> Tabulated;
+
+struct Result {
+  SpikeTimes spikes;
+  std::vector<double> v;
+  double seconds = 0;
+};
+
+// Reposo de neuronas/CGC.cpp en cualquiera de las dos neuronas
+template <typename Neuron> void cgc_rest(Neuron &n, const double *p) {
+  CGCNeuron<CGC>::rest(p, [&](CGC::variable var, double x) { n.set(var, x); });
+}
+
+template <typename Step, typename Get>
+Result run(Step step, Get get, double simulation_time, double h) {
+  Result result;
+  const long steps = std::lround(simulation_time / h);
+  Stimulus pulse = CGCNeuron<CGC>::protocol().compile(h);
+  result.v.reserve(steps);
+  auto t0 = std::chrono::steady_clock::now();
+  for (long k = 0; k < steps; ++k) {
+    step(pulse.current(k));
+    result.v.push_back(get());
+  }
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  for (long k = 0; k < steps; ++k) {
+    result.spikes.add((k + 1) * h, result.v[k]);
+  }
+  return result;
+}
+
+void report(const char *name, const char *dv, double error, std::size_t bytes,
+            const Result &r, const Result &ref) {
+  double max_dv = 0.0;
+  for (std::size_t k = 0; k < r.v.size(); ++k) {
+    max_dv = std::max(max_dv, std::fabs(r.v[k] - ref.v[k]));
+  }
+  std::printf("  %-8s %6s  %10.2g  %8zu  %8.1f  %7.2fx  %6zu  %10.3g  %10.3g\n", name, dv,
+              error, bytes, r.seconds / r.v.size() * 1e9, ref.seconds / r.seconds,
+              r.spikes.size(), max_shift(r.spikes, ref.spikes), max_dv);
+}
+
+int main(int argc, char **argv) {
+  std::vector<double> dvs = {0.01, 0.05, 0.2};
+  double h = 0.01;
+  double simulation_time = CGCNeuron<CGC>::simulation_time;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--dv" && i + 1 < argc) {
+      dvs.clear();
+      std::stringstream list(argv[++i]);
+      for (std::string item; std::getline(list, item, ',');) {
+        dvs.push_back(std::atof(item.c_str()));
+      }
+    } else if (arg == "--step" && i + 1 < argc) {
+      h = std::atof(argv[++i]);
+    } else if (arg == "--time" && i + 1 < argc) {
+      simulation_time = std::atof(argv[++i]);
+    } else {
+      std::fprintf(stderr, "Uso: %s [--dv mV,mV,...] [--step ms] [--time ms]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  CGC::ConstructorArgs args;
+  CGCNeuron<CGC>::args(args);
+
+  CGC neun(args);
+  cgc_rest(neun, args.params);
+  Result ref = run(
+      [&](double I) {
+        neun.add_synaptic_input(I);
+        neun.step(h);
+      },
+      [&] { return neun.get(CGC::v); }, simulation_time, h);
+
+  std::printf("CGC, %g ms con RungeKutta4 a %g ms: VavoulisCGCModel %.1f ns/paso, %zu spikes\n",
+              simulation_time, h, ref.seconds / ref.v.size() * 1e9, ref.spikes.size());
+  std::printf("  %-8s %6s  %10s  %8s  %8s  %8s  %6s  %10s  %10s\n", "tabla", "dv", "error",
+              "bytes", "ns/paso", "speedup", "spikes", "desfase ms", "max |dV|");
+
+  auto simulate = [&](const Tabulated::Options &options, const char *name, const char *dv) {
+    Tabulated n(args.params, options);
+    cgc_rest(n, args.params);
+    Result r = run(
+        [&](double I) {
+          n.add_synaptic_input(I);
+          n.template step<RungeKutta4>(h);
+        },
+        [&] { return n.get(CGC::v); }, simulation_time, h);
+    double error = *std::max_element(n.error().begin(), n.error().end());
+    report(name, dv, error, n.table() ? n.table()->bytes() : 0, r, ref);
+  };
+
+  Tabulated::Options exact;
+  exact.mode = Interpolation::none;
+  simulate(exact, "exacta", "-");
+
+  for (Interpolation mode : {Interpolation::linear, Interpolation::cubic}) {
+    for (double dv : dvs) {
+      Tabulated::Options options;
+      options.mode = mode;
+      options.dv = dv;
+      options.tolerance = 1.0;  // Aquí sólo se informa del error
+      char label[32];
+      std::snprintf(label, sizeof(label), "%g", dv);
+      simulate(options, mode == Interpolation::linear ? "lineal" : "cúbica", label);
+    }
+  }
+
+  return 0;
+}
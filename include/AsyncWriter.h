@@ -0,0 +1,178 @@
+/*************************************************************
+ * AsyncWriter.h - Salida de trazas en un hilo aparte
+ *
+ * Aunque TraceWriter y BinaryTraceWriter formatean en un buffer, el
+ * bucle de simulación sigue parándose cada vez que el buffer se vuelca
+ * a stdout o al disco. AsyncWriter separa las dos cosas: el bucle
+ * copia cada fila, sin formatear, en un anillo de bloques de tamaño
+ * fijo y un hilo de fondo formatea y escribe los bloques llenos:
+ *
+ *   simulación  --row()-->  [bloque][bloque][bloque]...  --> hilo: sink(fila)
+ *
+ * El anillo es de un productor y un consumidor y sin cerrojos: cada
+ * lado sólo escribe su propio contador de bloques (atómicos con
+ * acquire/release) y espera con std::atomic::wait sólo cuando el
+ * anillo está lleno (productor) o vacío (consumidor). Toda la memoria
+ * se reserva al construir: row() no reserva memoria dinámica y sólo
+ * espera si el hilo de escritura va más de blocks bloques por detrás.
+ *
+ * statistics() mide esa contrapresión: bloques y filas escritos,
+ * veces y tiempo que el productor ha esperado con el anillo lleno y
+ * mayor ocupación del anillo.
+ *
+ * Trace.h lo usa con --async (y --async-blocks N).
+ *
+ *************************************************************/
+
+#ifndef ASYNCWRITER_H_
+#define ASYNCWRITER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+struct AsyncStatistics {
+  std::uint64_t rows = 0;
+  std::uint64_t blocks = 0;
+  std::uint64_t stalls = 0;    // Veces que row() encontró el anillo lleno
+  double stall_seconds = 0;    // Tiempo esperando al hilo de escritura
+  std::size_t high_water = 0;  // Mayor número de bloques pendientes
+};
+
+class AsyncWriter {
+public:
+  // sink(fila, columnas) se llama desde el hilo de escritura
+  typedef std::function<void(const double *, std::size_t)> Sink;
+
+  AsyncWriter(std::size_t columns, Sink sink, std::size_t blocks = 16,
+              std::size_t rows_per_block = 1024)
+      : m_columns(columns), m_rows_per_block(std::max<std::size_t>(rows_per_block, 1)),
+        m_blocks(std::max<std::size_t>(blocks, 2)),
+        m_data(m_blocks * m_rows_per_block * columns), m_rows(m_blocks, 0),
+        m_sink(std::move(sink)), m_used(0) {
+    m_thread = std::thread([this] { consume(); });
+  }
+
+  AsyncWriter(const AsyncWriter &) = delete;
+  AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+  ~AsyncWriter() { close(); }
+
+  // Publica el bloque a medias y espera a que se escriba todo. Después
+  // ya no se pueden añadir filas
+  void close() {
+    if (!m_thread.joinable()) {
+      return;
+    }
+    if (m_used > 0) {
+      publish();
+    }
+    m_closed.store(true, std::memory_order_release);
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_one();
+    m_thread.join();
+  }
+
+  template <typename T> void row(const T *values, std::size_t n) {
+    if (!m_thread.joinable()) {
+      throw std::logic_error("AsyncWriter: fila después de close()");
+    }
+    if (n != m_columns) {
+      throw std::invalid_argument("AsyncWriter: número de columnas incorrecto");
+    }
+    if (m_used == 0) {
+      acquire();
+    }
+    double *out = block(m_head.load(std::memory_order_relaxed)) + m_used * m_columns;
+    for (std::size_t i = 0; i < n; ++i) {
+      out[i] = static_cast<double>(values[i]);
+    }
+    if (++m_used == m_rows_per_block) {
+      publish();
+    }
+  }
+
+  // Sólo desde el hilo de la simulación
+  const AsyncStatistics &statistics() const { return m_statistics; }
+
+private:
+  double *block(std::size_t k) {
+    return m_data.data() + (k % m_blocks) * m_rows_per_block * m_columns;
+  }
+
+  // Espera a que haya un bloque libre para el productor
+  void acquire() {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    std::size_t tail = m_tail.load(std::memory_order_acquire);
+    if (head - tail < m_blocks) {
+      return;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    while (head - tail >= m_blocks) {
+      m_tail.wait(tail, std::memory_order_acquire);
+      tail = m_tail.load(std::memory_order_acquire);
+    }
+    ++m_statistics.stalls;
+    m_statistics.stall_seconds +=
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+
+  void publish() {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    m_rows[head % m_blocks] = m_used;
+    m_statistics.rows += m_used;
+    ++m_statistics.blocks;
+    m_statistics.high_water = std::max(
+        m_statistics.high_water, head + 1 - m_tail.load(std::memory_order_relaxed));
+    m_used = 0;
+    m_head.store(head + 1, std::memory_order_release);
+    m_signal.fetch_add(1, std::memory_order_release);
+    m_signal.notify_one();
+  }
+
+  void consume() {
+    std::size_t tail = 0;
+    for (;;) {
+      // La señal se lee antes que head para no perder un aviso
+      const std::uint32_t signal = m_signal.load(std::memory_order_acquire);
+      if (tail == m_head.load(std::memory_order_acquire)) {
+        if (m_closed.load(std::memory_order_acquire)) {
+          return;
+        }
+        m_signal.wait(signal, std::memory_order_acquire);
+        continue;
+      }
+      const double *data = block(tail);
+      for (std::size_t r = 0; r < m_rows[tail % m_blocks]; ++r) {
+        m_sink(data + r * m_columns, m_columns);
+      }
+      m_tail.store(++tail, std::memory_order_release);
+      m_tail.notify_one();
+    }
+  }
+
+  const std::size_t m_columns, m_rows_per_block, m_blocks;
+  std::vector<double> m_data;
+  std::vector<std::size_t> m_rows;  // Filas de cada bloque
+  Sink m_sink;
+
+  // Productor
+  std::size_t m_used;  // Filas en el bloque actual
+  AsyncStatistics m_statistics;
+
+  // Contadores de bloques: head lo escribe el productor, tail el consumidor
+  alignas(64) std::atomic<std::size_t> m_head{0};
+  alignas(64) std::atomic<std::size_t> m_tail{0};
+  alignas(64) std::atomic<std::uint32_t> m_signal{0};
+  std::atomic<bool> m_closed{false};
+
+  std::thread m_thread;
+};
+
+#endif /* ASYNCWRITER_H_ */
@@ -0,0 +1,157 @@
+/*************************************************************
+ * BinaryTraceWriter.h - Trazas binarias en columnas de paso fijo
+ *
+ * Alternativa binaria a TraceWriter. El fichero es autodescriptivo
+ * y se puede abrir con np.memmap sin parsear (ver previo/plot.py):
+ *
+ *   offset  tamaño  contenido
+ *        0       8  magic "NEUNTRC1"
+ *        8       4  uint32 versión (1)
+ *       12       4  uint32 tamaño de la cabecera (múltiplo de 64)
+ *       16       4  uint32 número de columnas
+ *       20       4  uint32 bytes por valor (4 = float32, 8 = float64)
+ *       24       8  uint64 número de filas (0 si no se cerró bien)
+ *       32     ...  nombres de columna terminados en '\0'
+ *
+ * Tras la cabecera van las filas, una detrás de otra, con paso fijo
+ * de n_columnas * bytes_por_valor. Todo en little-endian: en una
+ * máquina big-endian store() invierte los bytes al copiarlos.
+ *
+ *************************************************************/
+
+#ifndef BINARYTRACEWRITER_H_
+#define BINARYTRACEWRITER_H_
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+class BinaryTraceWriter {
+public:
+  enum dtype { float32 = 4, float64 = 8 };
+
+  BinaryTraceWriter(const std::string &path,
+                    const std::vector<std::string> &columns,
+                    dtype type = float64, std::size_t buffer_size = 1 << 20)
+      : m_columns(columns.size()), m_itemsize(type), m_rows(0), m_used(0) {
+    m_file = std::fopen(path.c_str(), "wb");
+    if (m_file == nullptr) {
+      throw std::runtime_error("BinaryTraceWriter: no se puede abrir " + path);
+    }
+
+    std::size_t row_size = m_columns * m_itemsize;
+    m_buffer.resize(buffer_size < row_size ? row_size : buffer_size);
+    write_header(columns);
+  }
+
+  BinaryTraceWriter(const BinaryTraceWriter &) = delete;
+  BinaryTraceWriter &operator=(const BinaryTraceWriter &) = delete;
+
+  ~BinaryTraceWriter() {
+    flush();
+    // Se anota el número de filas definitivo en la cabecera
+    if (std::fseek(m_file, rows_offset, SEEK_SET) == 0) {
+      char rows[sizeof(std::uint64_t)];
+      store(rows, std::uint64_t(m_rows));
+      std::fwrite(rows, sizeof(rows), 1, m_file);
+    }
+    std::fclose(m_file);
+  }
+
+  template <typename... Values>
+    requires(std::is_arithmetic_v<Values> && ...)
+  void row(Values... values) {
+    static_assert(sizeof...(Values) > 0, "una fila necesita al menos un valor");
+    const double data[] = {static_cast<double>(values)...};
+    row(data, sizeof...(Values));
+  }
+
+  template <typename T> void row(const T *values, std::size_t n) {
+    if (n != m_columns) {
+      throw std::invalid_argument("BinaryTraceWriter: número de columnas incorrecto");
+    }
+    if (m_buffer.size() - m_used < n * m_itemsize) {
+      drain();
+    }
+    char *out = m_buffer.data() + m_used;
+    if (m_itemsize == float32) {
+      for (std::size_t i = 0; i < n; ++i, out += sizeof(float)) {
+        store(out, static_cast<float>(values[i]));
+      }
+    } else {
+      for (std::size_t i = 0; i < n; ++i, out += sizeof(double)) {
+        store(out, static_cast<double>(values[i]));
+      }
+    }
+    m_used += n * m_itemsize;
+    ++m_rows;
+  }
+
+  void flush() {
+    drain();
+    std::fflush(m_file);
+  }
+
+  std::size_t columns() const { return m_columns; }
+
+private:
+  static constexpr char magic[8] = {'N', 'E', 'U', 'N', 'T', 'R', 'C', '1'};
+  static constexpr std::uint32_t version = 1;
+  static constexpr long rows_offset = 24;
+  static constexpr std::size_t header_alignment = 64;
+
+  // Copia x en out en little-endian
+  template <typename T> static void store(char *out, T x) {
+    std::memcpy(out, &x, sizeof(x));
+    if constexpr (std::endian::native == std::endian::big) {
+      std::reverse(out, out + sizeof(x));
+    }
+  }
+
+  void write_header(const std::vector<std::string> &columns) {
+    std::vector<char> names;
+    for (const std::string &name : columns) {
+      names.insert(names.end(), name.begin(), name.end());
+      names.push_back('\0');
+    }
+
+    std::size_t size = 32 + names.size();
+    size = (size + header_alignment - 1) / header_alignment * header_alignment;
+
+    std::vector<char> header(size, '\0');
+    std::uint32_t fields[4] = {version, static_cast<std::uint32_t>(size),
+                               static_cast<std::uint32_t>(m_columns),
+                               static_cast<std::uint32_t>(m_itemsize)};
+    std::memcpy(header.data(), magic, sizeof(magic));
+    for (int i = 0; i < 4; ++i) {
+      store(header.data() + 8 + 4 * i, fields[i]);
+    }
+    store(header.data() + rows_offset, std::uint64_t(0));
+    std::memcpy(header.data() + 32, names.data(), names.size());
+
+    std::fwrite(header.data(), 1, header.size(), m_file);
+  }
+
+  void drain() {
+    if (m_used > 0) {
+      std::fwrite(m_buffer.data(), 1, m_used, m_file);
+      m_used = 0;
+    }
+  }
+
+  std::FILE *m_file;
+  std::size_t m_columns;
+  std::size_t m_itemsize;
+  std::uint64_t m_rows;
+  std::vector<char> m_buffer;
+  std::size_t m_used;
+};
+
+#endif /* BINARYTRACEWRITER_H_ */
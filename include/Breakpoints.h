@@ -0,0 +1,64 @@
+/*************************************************************
+ * Breakpoints.h - Instantes en los que cambia el estímulo
+ *
+ * Los estímulos de los ejemplos son constantes a trozos (t_pulse_start,
+ * t_pulse_end, t_stim_start, t_stim_end...). Un integrador que da un
+ * paso por encima de uno de esos instantes mezcla las dos corrientes
+ * y, si es adaptativo, además lo ve como un error grande y reduce el
+ * paso sin necesidad. Breakpoints acorta el paso para que caiga
+ * exactamente en el siguiente cambio:
+ *
+ *   Breakpoints breaks{t_pulse_start, t_pulse_end};
+ *   double h = breaks.clip(time, step);   // no cruza ningún cambio
+ *
+ *************************************************************/
+
+#ifndef BREAKPOINTS_H_
+#define BREAKPOINTS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <initializer_list>
+#include <limits>
+#include <utility>
+#include <vector>
+
+class Breakpoints {
+public:
+  Breakpoints() {}
+  Breakpoints(std::initializer_list<double> times) : m_times(times) { sort(); }
+  explicit Breakpoints(std::vector<double> times) : m_times(std::move(times)) { sort(); }
+
+  void add(double time) {
+    m_times.push_back(time);
+    sort();
+  }
+
+  const std::vector<double> &times() const { return m_times; }
+
+  // Primer cambio estrictamente posterior a time (infinito si no hay)
+  double next(double time) const {
+    auto it = std::upper_bound(m_times.begin(), m_times.end(), time + tolerance(time));
+    return it == m_times.end() ? std::numeric_limits<double>::infinity() : *it;
+  }
+
+  // Paso h recortado para no pasar del siguiente cambio
+  double clip(double time, double h) const {
+    return std::min(h, next(time) - time);
+  }
+
+private:
+  // Dos instantes más cercanos que esto se consideran el mismo
+  static double tolerance(double time) {
+    return 1e-12 * std::max(1.0, std::fabs(time));
+  }
+
+  void sort() {
+    std::sort(m_times.begin(), m_times.end());
+    m_times.erase(std::unique(m_times.begin(), m_times.end()), m_times.end());
+  }
+
+  std::vector<double> m_times;
+};
+
+#endif /* BREAKPOINTS_H_ */
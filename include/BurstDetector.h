@@ -0,0 +1,274 @@
+/*************************************************************
+ * BurstDetector.h - Detección de spikes, ráfagas e intervalos en línea
+ *
+ * Análisis que se hace dentro del bucle de simulación, muestra a
+ * muestra y con memoria constante, para no tener que guardar la traza
+ * de voltaje y releerla después.
+ *
+ * BurstDetector detecta spikes con histéresis: un spike es un cruce
+ * ascendente de threshold (instante interpolado entre las dos
+ * muestras) y no se cuenta otro hasta que el voltaje baja de reset.
+ * Los spikes separados menos de max_isi forman una ráfaga, que se da
+ * por cerrada cuando pasan max_isi ms sin spikes:
+ *
+ *   BurstDetector n1m;
+ *   if (n1m.add(time, v)) { n1m.burst().start ... }
+ *
+ * PhaseIntervals agrupa las ráfagas de Phases neuronas que se activan
+ * en secuencia (N1M -> N2v -> N3t) en ciclos que empiezan en cada
+ * ráfaga de la primera y mide, como en Garrido-Peña et al. (2020):
+ *
+ *   period        inicio de la ráfaga de la fase 0 hasta la siguiente
+ *   duration[p]   duración de la ráfaga de la fase p
+ *   interval[p]   inicio de la fase p -> inicio de la fase p + 1
+ *   delay[p]      final de la fase p -> inicio de la fase p + 1
+ *
+ * Un ciclo sin ráfaga en alguna fase deja NaN en sus medidas. Las
+ * ráfagas de las fases 1.. esperan a su ciclo como mucho max_period ms
+ * (20 s por defecto): si la fase 0 deja de disparar no se acumulan, y
+ * un ciclo más largo que max_period queda con NaN en esas fases.
+ * RunningStats resume una columna (media, desviación, extremos) sin
+ * guardar los valores; merge() junta dos resúmenes.
+ *
+ *************************************************************/
+
+#ifndef BURSTDETECTOR_H_
+#define BURSTDETECTOR_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+struct Burst {
+  double start, end;  // Primer y último spike (ms)
+  int spikes;
+
+  double duration() const { return end - start; }
+};
+
+class BurstDetector {
+public:
+  explicit BurstDetector(double threshold = -20.0, double reset = -40.0,
+                         double max_isi = 250.0, int min_spikes = 1)
+      : m_threshold(threshold), m_reset(reset), m_max_isi(max_isi),
+        m_min_spikes(min_spikes) {}
+
+  // Añade una muestra. Devuelve true si con ella se cierra una ráfaga
+  bool add(double t, double v) {
+    bool closed = false;
+    if (m_open && t - m_current.end > m_max_isi) {
+      closed = close();
+    }
+
+    if (m_armed && !m_first && m_v_prev < m_threshold && v >= m_threshold) {
+      double spike = m_t_prev + (t - m_t_prev) * (m_threshold - m_v_prev) / (v - m_v_prev);
+      ++m_spikes;
+      m_armed = false;
+      if (m_open) {
+        m_current.end = spike;
+        ++m_current.spikes;
+      } else {
+        m_current = {spike, spike, 1};
+        m_open = true;
+      }
+    } else if (v < m_reset) {
+      m_armed = true;
+    }
+
+    m_t_prev = t;
+    m_v_prev = v;
+    m_first = false;
+    return closed;
+  }
+
+  // Cierra la ráfaga abierta, si la hay (al final de la simulación)
+  bool finish() { return m_open && close(); }
+
+  const Burst &burst() const { return m_last; }  // Última ráfaga cerrada
+  long spikes() const { return m_spikes; }
+  long bursts() const { return m_bursts; }
+  double max_isi() const { return m_max_isi; }
+
+private:
+  bool close() {
+    m_open = false;
+    if (m_current.spikes < m_min_spikes) {
+      return false;
+    }
+    m_last = m_current;
+    ++m_bursts;
+    return true;
+  }
+
+  double m_threshold, m_reset, m_max_isi;
+  int m_min_spikes;
+
+  double m_t_prev = 0, m_v_prev = 0;
+  bool m_first = true, m_armed = true, m_open = false;
+  Burst m_current{}, m_last{};
+  long m_spikes = 0, m_bursts = 0;
+};
+
+template <std::size_t Phases> class PhaseIntervals {
+public:
+  static_assert(Phases >= 2, "PhaseIntervals: hacen falta al menos dos fases");
+
+  struct Cycle {
+    long index;
+    double start, period;
+    std::array<double, Phases> duration;
+    std::array<double, Phases - 1> interval, delay;
+  };
+
+  explicit PhaseIntervals(const BurstDetector &detector = BurstDetector(),
+                          double max_period = 20000.0)
+      : m_max_period(max_period) {
+    m_detectors.fill(detector);
+  }
+
+  // Una muestra con los voltajes de las Phases neuronas, en el orden de
+  // la secuencia. Devuelve true si se ha completado un ciclo (cycle()).
+  bool add(double t, const double *v) {
+    for (std::size_t p = 0; p < Phases; ++p) {
+      m_closed[p] = m_detectors[p].add(t, v[p]);
+    }
+    return collect();
+  }
+
+  // Cierra las ráfagas abiertas al final de la simulación. Devuelve
+  // true si eso completa un ciclo; el de la última ráfaga de la fase 0
+  // no tiene periodo y no se emite.
+  bool finish() {
+    for (std::size_t p = 0; p < Phases; ++p) {
+      m_closed[p] = m_detectors[p].finish();
+    }
+    return collect();
+  }
+
+  // Si la fase p ha cerrado una ráfaga en la última muestra
+  bool closed(std::size_t p) const { return m_closed[p]; }
+  const BurstDetector &detector(std::size_t p) const { return m_detectors[p]; }
+  const Cycle &cycle() const { return m_cycle; }
+  long cycles() const { return m_cycles; }
+
+private:
+  // Las ráfagas de la fase 0 se procesan las últimas: una ráfaga de otra
+  // fase que acaba antes de que empiece la de la fase 0 se ha cerrado,
+  // como muy tarde, en la misma muestra.
+  bool collect() {
+    for (std::size_t p = 1; p < Phases; ++p) {
+      if (m_closed[p]) {
+        const Burst &b = m_detectors[p].burst();
+        discard(p, b.start - m_max_period);
+        m_pending[p].push_back(b);
+      }
+    }
+    if (!m_closed[0]) {
+      return false;
+    }
+
+    const Burst next = m_detectors[0].burst();
+    bool complete = m_has_leader;
+    if (complete) {
+      build(next.start);
+    }
+    m_leader = next;
+    m_has_leader = true;
+    for (std::size_t p = 1; p < Phases; ++p) {
+      discard(p, next.start);
+    }
+    return complete;
+  }
+
+  // Quita las ráfagas pendientes de la fase p que empiezan antes de t
+  void discard(std::size_t p, double t) {
+    std::vector<Burst> &pending = m_pending[p];
+    pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                 [&](const Burst &b) { return b.start < t; }),
+                  pending.end());
+  }
+
+  void build(double next_start) {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    m_cycle.index = m_cycles++;
+    m_cycle.start = m_leader.start;
+    m_cycle.period = next_start - m_leader.start;
+
+    std::array<const Burst *, Phases> bursts{};
+    bursts[0] = &m_leader;
+    for (std::size_t p = 1; p < Phases; ++p) {
+      if (!bursts[p - 1]) {
+        break;
+      }
+      // Primera ráfaga de la fase p después del inicio de la anterior
+      for (const Burst &b : m_pending[p]) {
+        if (b.start >= bursts[p - 1]->start && b.start < next_start) {
+          bursts[p] = &b;
+          break;
+        }
+      }
+    }
+
+    for (std::size_t p = 0; p < Phases; ++p) {
+      m_cycle.duration[p] = bursts[p] ? bursts[p]->duration() : nan;
+    }
+    for (std::size_t p = 0; p + 1 < Phases; ++p) {
+      bool both = bursts[p] && bursts[p + 1];
+      m_cycle.interval[p] = both ? bursts[p + 1]->start - bursts[p]->start : nan;
+      m_cycle.delay[p] = both ? bursts[p + 1]->start - bursts[p]->end : nan;
+    }
+  }
+
+  std::array<BurstDetector, Phases> m_detectors;
+  double m_max_period;
+  std::array<bool, Phases> m_closed{};
+  std::array<std::vector<Burst>, Phases> m_pending;
+
+  Burst m_leader{};
+  bool m_has_leader = false;
+  Cycle m_cycle{};
+  long m_cycles = 0;
+};
+
+// Media, desviación típica y extremos de una columna, ignorando NaN
+struct RunningStats {
+  long n = 0;
+  double mean = 0, m2 = 0;
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+
+  void add(double x) {
+    if (std::isnan(x)) {
+      return;
+    }
+    ++n;
+    double d = x - mean;
+    mean += d / n;
+    m2 += d * (x - mean);
+    min = std::min(min, x);
+    max = std::max(max, x);
+  }
+
+  // Suma los valores resumidos en other, como si se hubieran añadido aquí
+  void merge(const RunningStats &other) {
+    if (other.n == 0) {
+      return;
+    }
+    const long total = n + other.n;
+    const double d = other.mean - mean;
+    mean += d * other.n / total;
+    m2 += other.m2 + d * d * (double(n) * other.n / total);
+    n = total;
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+  }
+
+  double stddev() const {
+    return n > 1 ? std::sqrt(m2 / (n - 1)) : std::numeric_limits<double>::quiet_NaN();
+  }
+};
+
+#endif /* BURSTDETECTOR_H_ */
@@ -0,0 +1,67 @@
+/*************************************************************
+ * CGCNeuron.h - Parámetros de la Tabla 1, reposo y pulso de la CGC
+ *
+ * Los valores de neuronas/CGC.cpp (VavoulisCGCModel) en un solo sitio
+ * para las herramientas que simulan la CGC, como CPGNeurons hace con
+ * las neuronas del CPG (LymnaeaCPG.h):
+ *
+ *   CGC::ConstructorArgs args;
+ *   CGCNeuron<CGC>::args(args);
+ *   CGC n(args);
+ *   CGCNeuron<CGC>::rest(args.params, [&](CGC::variable var, double x) { n.set(var, x); });
+ *   Stimulus pulse = CGCNeuron<CGC>::protocol().compile(step);
+ *
+ * rest() toma los parámetros para que un ajuste (ajuste_cgc.cpp) parta
+ * del reposo de sus propios valores y no de los de la Tabla 1.
+ *
+ *************************************************************/
+
+#ifndef CGCNEURON_H_
+#define CGCNEURON_H_
+
+#include <Stimulus.h>
+#include <VavoulisCGCModel.h>
+#include <cmath>
+
+template <typename Neuron> struct CGCNeuron {
+  // Pulso y duración de neuronas/CGC.cpp (ms, nA)
+  static constexpr double t_pulse_start = 500.0;
+  static constexpr double t_pulse_end = 2500.0;
+  static constexpr double I_inj = 0.2;
+  static constexpr double simulation_time = 3000.0;
+
+  static void args(typename Neuron::ConstructorArgs &args) {
+    auto *p = args.params;
+    p[Neuron::cm] = 1.0;    p[Neuron::vna] = 55.0;   p[Neuron::vk] = -90.0;  p[Neuron::vca] = 80.0;
+    p[Neuron::Gnat] = 1.68; p[Neuron::Gnap] = 0.44;  p[Neuron::Ga] = 18.82;  p[Neuron::Gd] = 1.20;
+    p[Neuron::Glva] = 0.01; p[Neuron::Ghva] = 1.03;
+    p[Neuron::vh_h] = -56.43; p[Neuron::vs_h] = -8.41; p[Neuron::tau0_h] = 778.82; p[Neuron::delta_h] = 0.03;
+    p[Neuron::vh_r] = -47.03; p[Neuron::vs_r] = 20.55; p[Neuron::tau0_r] = 4.01;   p[Neuron::delta_r] = 1.00;
+    p[Neuron::vh_a] = -36.37; p[Neuron::vs_a] = 8.72;  p[Neuron::tau0_a] = 13.28;  p[Neuron::delta_a] = 0.39;
+    p[Neuron::vh_b] = -83.00; p[Neuron::vs_b] = -6.20; p[Neuron::tau0_b] = 266.75; p[Neuron::delta_b] = 0.83;
+    p[Neuron::vh_n] = -59.43; p[Neuron::vs_n] = 34.79; p[Neuron::tau0_n] = 14.52;  p[Neuron::delta_n] = 0.18;
+    p[Neuron::vh_e] = -14.25; p[Neuron::vs_e] = 6.96;  p[Neuron::tau0_e] = 3.81;   p[Neuron::delta_e] = 0.84;
+    p[Neuron::vh_f] = -21.44; p[Neuron::vs_f] = -5.78; p[Neuron::tau0_f] = 34.68;  p[Neuron::delta_f] = 0.97;
+    p[Neuron::Vh_m] = -35.20; p[Neuron::Vs_m] = 9.66;
+    p[Neuron::Vh_c] = -41.35; p[Neuron::Vs_c] = 5.05;  p[Neuron::Vh_d] = -64.13; p[Neuron::Vs_d] = -4.03;
+  }
+
+  // Reposo a -60 mV: x_inf(V) = 1/(1+exp((vh-V)/vs)) de cada compuerta
+  // con los parámetros p. set(variable, valor) como en CPGNeurons::rest
+  template <typename Params, typename Set> static void rest(const Params *p, Set set) {
+    typedef VavoulisCGCModel<double> M;
+    typedef typename Neuron::variable variable;
+    const M::parameter vh[] = {M::vh_h, M::vh_r, M::vh_a, M::vh_b, M::vh_n, M::vh_e, M::vh_f};
+    const M::parameter vs[] = {M::vs_h, M::vs_r, M::vs_a, M::vs_b, M::vs_n, M::vs_e, M::vs_f};
+    set(variable(M::v), -60.0);
+    for (int g = 0; g < 7; ++g) {
+      set(variable(M::h + g), 1.0 / (1.0 + std::exp((double(p[vh[g]]) + 60.0) / p[vs[g]])));
+    }
+  }
+
+  static StimulusProtocol protocol() {
+    return StimulusProtocol().pulse(t_pulse_start, t_pulse_end, I_inj);
+  }
+};
+
+#endif /* CGCNEURON_H_ */
@@ -0,0 +1,192 @@
+/*************************************************************
+ * Checkpoint.h - Estado completo de una simulación en binario
+ *
+ * Guarda las variables de estado de neuronas y sinapsis (incluidas
+ * r, s, i de GradualActivationSynapsis) junto con el paso k y el paso
+ * de integración h, para continuar más tarde exactamente desde ese
+ * punto en lugar de repetir el transitorio:
+ *
+ *   Checkpoint state(k, step);
+ *   state.save("n1m", n1m);
+ *   state.save("s_n2v_n1m", s_n2v_n1m);
+ *   state.write("cpg.ckp");
+ *
+ *   Checkpoint state = Checkpoint::read("cpg.ckp");
+ *   state.restore("n1m", n1m);
+ *   for (long k = state.step(); k < steps; ++k) ...
+ *
+ * Sirve cualquier objeto con n_variables, get(variable) y
+ * set(variable, x). Los valores se guardan en float64, así que la
+ * restauración es exacta también en simulaciones con float.
+ * state_variables() copia esas mismas variables en un array.
+ *
+ * Formato (orden de bytes de la máquina):
+ *   "NCKP", uint32 versión, int64 k, float64 h, uint32 entradas,
+ *   y por entrada: uint16 longitud del nombre, nombre,
+ *   uint32 n, n x float64
+ *
+ *************************************************************/
+
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Copia en x las variables de system (en el orden de Checkpoint::save)
+// y devuelve el final de lo escrito
+template <typename System> double *state_variables(const System &system, double *x) {
+  for (std::size_t k = 0; k < System::n_variables; ++k) {
+    *x++ = double(system.get(static_cast<typename System::variable>(k)));
+  }
+  return x;
+}
+
+class Checkpoint {
+public:
+  struct Entry {
+    std::string name;
+    std::vector<double> values;
+  };
+
+  explicit Checkpoint(long step = 0, double h = 0.0) : m_step(step), m_h(h) {}
+
+  long step() const { return m_step; }
+  double h() const { return m_h; }
+  double time() const { return m_step * m_h; }
+  const std::vector<Entry> &entries() const { return m_entries; }
+
+  template <typename System> void save(const std::string &name, const System &system) {
+    Entry entry{name, std::vector<double>(System::n_variables)};
+    for (std::size_t k = 0; k < System::n_variables; ++k) {
+      entry.values[k] = double(system.get(static_cast<typename System::variable>(k)));
+    }
+    m_entries.push_back(std::move(entry));
+  }
+
+  // Valores ya ordenados como las variables del objeto que los restaurará
+  void save(const std::string &name, std::vector<double> values) {
+    m_entries.push_back({name, std::move(values)});
+  }
+
+  template <typename System> void restore(const std::string &name, System &system) const {
+    const Entry &entry = find(name);
+    if (entry.values.size() != System::n_variables) {
+      throw std::runtime_error("Checkpoint: " + name + " tiene " +
+                               std::to_string(entry.values.size()) + " variables, se esperaban " +
+                               std::to_string(System::n_variables));
+    }
+    for (std::size_t k = 0; k < System::n_variables; ++k) {
+      system.set(static_cast<typename System::variable>(k), entry.values[k]);
+    }
+  }
+
+  void write(const std::string &path) const {
+    std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "wb"),
+                                                          std::fclose);
+    if (!file) {
+      throw std::runtime_error("Checkpoint: no se puede escribir " + path);
+    }
+    std::FILE *f = file.get();
+    const std::int64_t step = m_step;
+    const std::uint32_t entries = m_entries.size();
+    std::fwrite(magic, 1, 4, f);
+    std::fwrite(&version, sizeof(version), 1, f);
+    std::fwrite(&step, sizeof(step), 1, f);
+    std::fwrite(&m_h, sizeof(m_h), 1, f);
+    std::fwrite(&entries, sizeof(entries), 1, f);
+    for (const Entry &e : m_entries) {
+      const std::uint16_t length = e.name.size();
+      const std::uint32_t n = e.values.size();
+      std::fwrite(&length, sizeof(length), 1, f);
+      std::fwrite(e.name.data(), 1, length, f);
+      std::fwrite(&n, sizeof(n), 1, f);
+      std::fwrite(e.values.data(), sizeof(double), n, f);
+    }
+    if (std::ferror(f)) {
+      throw std::runtime_error("Checkpoint: error al escribir " + path);
+    }
+  }
+
+  static Checkpoint read(const std::string &path) {
+    std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(std::fopen(path.c_str(), "rb"),
+                                                          std::fclose);
+    if (!file) {
+      throw std::runtime_error("Checkpoint: no se puede leer " + path);
+    }
+    std::FILE *f = file.get();
+    // Los contadores del fichero se comparan con los bytes que quedan
+    // antes de reservar memoria para ellos
+    std::fseek(f, 0, SEEK_END);
+    long left = std::ftell(f);
+    std::rewind(f);
+    auto get = [&](void *data, std::size_t size, std::size_t n) {
+      if (std::fread(data, size, n, f) != n) {
+        throw std::runtime_error("Checkpoint: " + path + " está truncado");
+      }
+      left -= size * n;
+    };
+    auto check = [&](std::uint64_t count, std::size_t size, const char *what) {
+      if (count * size > static_cast<std::uint64_t>(left)) {
+        throw std::runtime_error("Checkpoint: " + path + " está truncado o dañado (" +
+                                 std::to_string(count) + " " + what + " en " +
+                                 std::to_string(left) + " bytes)");
+      }
+    };
+
+    char header[4];
+    std::uint32_t file_version, entries;
+    std::int64_t step;
+    double h;
+    get(header, 1, 4);
+    get(&file_version, sizeof(file_version), 1);
+    if (std::string(header, 4) != std::string(magic, 4) || file_version != version) {
+      throw std::runtime_error("Checkpoint: " + path + " no es un checkpoint válido");
+    }
+    get(&step, sizeof(step), 1);
+    get(&h, sizeof(h), 1);
+    get(&entries, sizeof(entries), 1);
+    // Cada entrada ocupa al menos su longitud y su n
+    check(entries, sizeof(std::uint16_t) + sizeof(std::uint32_t), "entradas");
+
+    Checkpoint checkpoint(step, h);
+    for (std::uint32_t i = 0; i < entries; ++i) {
+      std::uint16_t length;
+      std::uint32_t n;
+      Entry e;
+      get(&length, sizeof(length), 1);
+      e.name.resize(length);
+      get(e.name.data(), 1, length);
+      get(&n, sizeof(n), 1);
+      check(n, sizeof(double), "valores");
+      e.values.resize(n);
+      get(e.values.data(), sizeof(double), n);
+      checkpoint.m_entries.push_back(std::move(e));
+    }
+    return checkpoint;
+  }
+
+private:
+  static constexpr char magic[4] = {'N', 'C', 'K', 'P'};
+  static constexpr std::uint32_t version = 1;
+
+  const Entry &find(const std::string &name) const {
+    for (const Entry &e : m_entries) {
+      if (e.name == name) {
+        return e;
+      }
+    }
+    throw std::runtime_error("Checkpoint: no hay estado de " + name);
+  }
+
+  long m_step;
+  double m_h;
+  std::vector<Entry> m_entries;
+};
+
+#endif /* CHECKPOINT_H_ */
@@ -0,0 +1,233 @@
+/*************************************************************
+ * DifferentialEvolution.h - Evolución diferencial en paralelo
+ *
+ * Minimiza una función de coste dentro de una caja [lower, upper] con
+ * evolución diferencial (Storn y Price 1997, DE/rand/1/bin): en cada
+ * generación, para cada individuo x_i se construye un candidato
+ *
+ *   v = x_r1 + F (x_r2 - x_r3),   u_j = v_j con probabilidad CR (y en
+ *                                 una coordenada al azar), x_ij si no
+ *
+ * que sustituye a x_i si su coste no es mayor. Los candidatos de una
+ * generación se evalúan en paralelo en un WorkStealingPool:
+ *
+ *   DifferentialEvolution de(lower, upper, options);
+ *   de.add(x0);                                // opcional: punto de partida
+ *   DifferentialEvolutionResult r = de.minimize(
+ *       [&](const std::vector<double> &x, double bound) { ... return cost; });
+ *
+ * Como la selección sólo pregunta si el candidato mejora a x_i, cost
+ * recibe el coste de x_i como cota: en cuanto sabe que la va a superar
+ * (el error acumulado de una simulación sólo crece) puede parar y
+ * devolver infinito. Esos candidatos cuentan como cortados. En la
+ * población inicial la cota es infinita. NaN cuenta como infinito.
+ *
+ * Los números aleatorios salen de un Philox (Philox.h) con la semilla
+ * como clave y el flujo (generación, individuo), así que el resultado
+ * no depende del número de hilos.
+ *
+ * Un candidato fuera de la caja se lleva a medio camino entre x_i y el
+ * límite que se sale.
+ *
+ *************************************************************/
+
+#ifndef DIFFERENTIALEVOLUTION_H_
+#define DIFFERENTIALEVOLUTION_H_
+
+#include <Philox.h>
+#include <WorkStealingPool.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+struct DifferentialEvolutionOptions {
+  std::size_t population = 0;  // 0: 10 por parámetro (al menos 8)
+  double F = 0.5;              // Peso de la diferencia
+  double CR = 0.9;             // Probabilidad de cruce por coordenada
+  int generations = 100;
+  double tolerance = 0.0;      // Para si mediana - mejor <= tolerance
+  std::uint64_t seed = 1;
+  unsigned threads = 1;
+};
+
+struct DifferentialEvolutionResult {
+  std::vector<std::vector<double>> population;  // De menor a mayor coste
+  std::vector<double> costs;
+  int generations = 0;
+  long evaluations = 0;
+  long cut_off = 0;  // Candidatos que pararon al superar la cota
+
+  const std::vector<double> &best() const { return population.front(); }
+  double best_cost() const { return costs.front(); }
+};
+
+class DifferentialEvolution {
+public:
+  typedef DifferentialEvolutionOptions Options;
+  typedef DifferentialEvolutionResult Result;
+
+  DifferentialEvolution(std::vector<double> lower, std::vector<double> upper,
+                        const Options &options = Options())
+      : m_lower(std::move(lower)), m_upper(std::move(upper)), m_options(options) {
+    if (m_lower.empty() || m_lower.size() != m_upper.size()) {
+      throw std::invalid_argument("DifferentialEvolution: límites no válidos");
+    }
+    for (std::size_t j = 0; j < m_lower.size(); ++j) {
+      if (!(m_lower[j] <= m_upper[j])) {
+        throw std::invalid_argument("DifferentialEvolution: límite inferior mayor que el superior");
+      }
+    }
+    if (m_options.population == 0) {
+      m_options.population = std::max<std::size_t>(8, 10 * m_lower.size());
+    }
+    if (m_options.population < 4) {
+      throw std::invalid_argument("DifferentialEvolution: hacen falta al menos 4 individuos");
+    }
+  }
+
+  // Individuo de la población inicial en lugar de uno aleatorio
+  void add(const std::vector<double> &x) {
+    if (x.size() != m_lower.size()) {
+      throw std::invalid_argument("DifferentialEvolution: dimensión no válida");
+    }
+    if (m_initial.size() < m_options.population) {
+      m_initial.push_back(clamp(x));
+    }
+  }
+
+  // cost(x, bound); progress(generación, resultado) tras cada generación
+  template <typename Cost, typename Progress> Result minimize(Cost cost, Progress progress) {
+    const std::size_t n = m_lower.size(), np = m_options.population;
+    WorkStealingPool pool(std::max(1u, m_options.threads));
+    auto evaluate = [&](const std::vector<double> &x, double bound) {
+      const double c = cost(x, bound);
+      return std::isnan(c) ? std::numeric_limits<double>::infinity() : c;
+    };
+
+    Result result;
+    std::vector<std::vector<double>> &x = result.population;
+    std::vector<double> &f = result.costs;
+    x = m_initial;
+    for (std::size_t i = x.size(); i < np; ++i) {
+      const Philox rng(m_options.seed, 0, static_cast<std::uint32_t>(i));
+      std::vector<double> xi(n);
+      for (std::size_t j = 0; j < n; ++j) {
+        xi[j] = m_lower[j] + rng.uniform(j) * (m_upper[j] - m_lower[j]);
+      }
+      x.push_back(std::move(xi));
+    }
+    f.assign(np, 0.0);
+    pool.parallel_for(np, [&](std::size_t i) {
+      f[i] = evaluate(x[i], std::numeric_limits<double>::infinity());
+    });
+    result.evaluations = static_cast<long>(np);
+    progress(0, static_cast<const Result &>(result));
+
+    std::vector<std::vector<double>> trial(np, std::vector<double>(n));
+    std::vector<double> trial_cost(np);
+    std::vector<char> cut(np);
+    for (int g = 1; g <= m_options.generations && !converged(f); ++g) {
+      for (std::size_t i = 0; i < np; ++i) {
+        mutate(x, i, g, trial[i]);
+      }
+      pool.parallel_for(np, [&](std::size_t i) {
+        trial_cost[i] = evaluate(trial[i], f[i]);
+        cut[i] = std::isinf(trial_cost[i]) && std::isfinite(f[i]);
+      });
+      for (std::size_t i = 0; i < np; ++i) {
+        if (trial_cost[i] <= f[i]) {
+          x[i].swap(trial[i]);
+          f[i] = trial_cost[i];
+        }
+        result.cut_off += cut[i];
+      }
+      result.evaluations += static_cast<long>(np);
+      result.generations = g;
+      progress(g, static_cast<const Result &>(result));
+    }
+
+    // Población ordenada por coste
+    std::vector<std::size_t> order(np);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) { return f[a] < f[b]; });
+    std::vector<std::vector<double>> sorted_x(np);
+    std::vector<double> sorted_f(np);
+    for (std::size_t k = 0; k < np; ++k) {
+      sorted_x[k].swap(x[order[k]]);
+      sorted_f[k] = f[order[k]];
+    }
+    x.swap(sorted_x);
+    f.swap(sorted_f);
+    return result;
+  }
+
+  template <typename Cost> Result minimize(Cost cost) {
+    return minimize(cost, [](int, const Result &) {});
+  }
+
+  // Mediana de los costes de la población
+  static double median(std::vector<double> costs) {
+    std::nth_element(costs.begin(), costs.begin() + costs.size() / 2, costs.end());
+    return costs[costs.size() / 2];
+  }
+
+private:
+  std::vector<double> clamp(std::vector<double> x) const {
+    for (std::size_t j = 0; j < x.size(); ++j) {
+      x[j] = std::min(std::max(x[j], m_lower[j]), m_upper[j]);
+    }
+    return x;
+  }
+
+  bool converged(const std::vector<double> &f) const {
+    const double best = *std::min_element(f.begin(), f.end());
+    return std::isfinite(best) && median(f) - best <= m_options.tolerance;
+  }
+
+  // DE/rand/1/bin para el individuo i en la generación g
+  void mutate(const std::vector<std::vector<double>> &x, std::size_t i, int g,
+              std::vector<double> &u) const {
+    const std::size_t n = m_lower.size(), np = x.size();
+    const Philox rng(m_options.seed, static_cast<std::uint32_t>(g), static_cast<std::uint32_t>(i));
+    std::uint64_t k = 0;
+    auto pick = [&](std::size_t bound) {
+      return std::min(bound - 1, static_cast<std::size_t>(rng.uniform(k++) * bound));
+    };
+    std::size_t r1, r2, r3;
+    do {
+      r1 = pick(np);
+    } while (r1 == i);
+    do {
+      r2 = pick(np);
+    } while (r2 == i || r2 == r1);
+    do {
+      r3 = pick(np);
+    } while (r3 == i || r3 == r1 || r3 == r2);
+    const std::size_t forced = pick(n);
+    for (std::size_t j = 0; j < n; ++j) {
+      if (j == forced || rng.uniform(k++) < m_options.CR) {
+        u[j] = x[r1][j] + m_options.F * (x[r2][j] - x[r3][j]);
+        if (u[j] < m_lower[j]) {
+          u[j] = 0.5 * (x[i][j] + m_lower[j]);
+        } else if (u[j] > m_upper[j]) {
+          u[j] = 0.5 * (x[i][j] + m_upper[j]);
+        }
+      } else {
+        u[j] = x[i][j];
+      }
+    }
+  }
+
+  std::vector<double> m_lower, m_upper;
+  Options m_options;
+  std::vector<std::vector<double>> m_initial;
+};
+
+#endif /* DIFFERENTIALEVOLUTION_H_ */
@@ -0,0 +1,326 @@
+/*************************************************************
+ * DormandPrince54.h - Integrador adaptativo Dormand-Prince 5(4)
+ *
+ * Par encajado de Runge-Kutta de orden 5 con estimador de orden 4
+ * (Dormand y Prince 1980; control del paso y salida densa como en
+ * DOPRI5 de Hairer, Nørsett y Wanner). Cada paso cuesta 6
+ * evaluaciones del sistema, porque la última etapa de un paso es la
+ * primera del siguiente (FSAL), y el paso crece en las fases lentas
+ * (plateau de N1M con tau_p = 250 ms, reposo) y se reduce en los
+ * spikes para mantener
+ *
+ *   |error_i| <= atol + rtol * max(|y_i|, |y_i nuevo|)
+ *
+ * Se puede usar de dos formas:
+ *
+ * 1) Como Integrator de Neun, igual que RungeKutta4:
+ *
+ *      DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>,
+ *                                DormandPrince54> n(args);
+ *      n.step(0.1);   // avanza 0.1 ms con los subpasos que hagan falta
+ *
+ *    Las tolerancias se fijan con DormandPrince54::set_tolerances. El
+ *    wrapper de Neun no tiene dónde guardar el paso aceptado, así que
+ *    cada step(h) empieza probando el tramo entero h; para conservarlo
+ *    entre llamadas hay que usar un Solver.
+ *
+ * 2) Con DormandPrince54::Solver sobre un estado propio, que permite
+ *    pasos más largos que la rejilla de salida e interpola en ella
+ *    (salida densa de orden 4):
+ *
+ *      DormandPrince54::Solver<Neuron> solver(1e-6, 1e-6);
+ *      solver.integrate(n, vars, params, t, t_end, 0.1,
+ *                       [&](double t, const double *y) { ... });
+ *
+ *    integrate termina exactamente en t_end, así que llamándolo por
+ *    tramos entre los cambios del estímulo (Breakpoints.h) ningún paso
+ *    cruza una discontinuidad. El solver recuerda el último paso
+ *    aceptado y lo usa en el siguiente integrate.
+ *
+ *************************************************************/
+
+#ifndef DORMANDPRINCE54_H_
+#define DORMANDPRINCE54_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+class DormandPrince54 {
+public:
+  struct Statistics {
+    unsigned long evaluations = 0;  // Llamadas a eval del sistema
+    unsigned long accepted = 0;
+    unsigned long rejected = 0;
+
+    Statistics &operator+=(const Statistics &o) {
+      evaluations += o.evaluations;
+      accepted += o.accepted;
+      rejected += o.rejected;
+      return *this;
+    }
+  };
+
+  // Tolerancias usadas por step(). Fijarlas antes de lanzar hilos.
+  static void set_tolerances(double atol, double rtol) {
+    tolerances().atol = atol;
+    tolerances().rtol = rtol;
+  }
+
+  // Estadísticas acumuladas por step() en el hilo actual
+  static Statistics &statistics() {
+    static thread_local Statistics stats;
+    return stats;
+  }
+
+  template <typename System> class Solver;
+
+  template <typename System>
+  static void step(System &system, typename System::precission_t h,
+                   typename System::precission_t *const vars,
+                   typename System::precission_t *const params) {
+    Solver<System> solver(tolerances().atol, tolerances().rtol);
+    solver.set_step(static_cast<double>(h));
+    solver.integrate(system, vars, params, 0.0, static_cast<double>(h));
+    statistics() += solver.statistics();
+  }
+
+private:
+  struct Tolerances {
+    double atol = 1e-6;
+    double rtol = 1e-6;
+  };
+
+  static Tolerances &tolerances() {
+    static Tolerances tol;
+    return tol;
+  }
+
+  // Coeficientes del tablero de Butcher
+  static constexpr double a21 = 1.0 / 5;
+  static constexpr double a31 = 3.0 / 40, a32 = 9.0 / 40;
+  static constexpr double a41 = 44.0 / 45, a42 = -56.0 / 15, a43 = 32.0 / 9;
+  static constexpr double a51 = 19372.0 / 6561, a52 = -25360.0 / 2187,
+                          a53 = 64448.0 / 6561, a54 = -212.0 / 729;
+  static constexpr double a61 = 9017.0 / 3168, a62 = -355.0 / 33, a63 = 46732.0 / 5247,
+                          a64 = 49.0 / 176, a65 = -5103.0 / 18656;
+  static constexpr double a71 = 35.0 / 384, a73 = 500.0 / 1113, a74 = 125.0 / 192,
+                          a75 = -2187.0 / 6784, a76 = 11.0 / 84;
+  // Diferencia entre la solución de orden 5 y la de orden 4
+  static constexpr double e1 = 71.0 / 57600, e3 = -71.0 / 16695, e4 = 71.0 / 1920,
+                          e5 = -17253.0 / 339200, e6 = 22.0 / 525, e7 = -1.0 / 40;
+  // Salida densa
+  static constexpr double d1 = -12715105075.0 / 11282082432.0,
+                          d3 = 87487479700.0 / 32700410799.0,
+                          d4 = -10690763975.0 / 1880347072.0,
+                          d5 = 701980252875.0 / 199316789632.0,
+                          d6 = -1453857185.0 / 822651844.0,
+                          d7 = 69997945.0 / 29380423.0;
+};
+
+template <typename System> class DormandPrince54::Solver {
+public:
+  typedef typename System::precission_t precission_t;
+  static constexpr std::size_t n = System::n_variables;
+
+  Solver(double atol = 1e-6, double rtol = 1e-6,
+         double h_max = std::numeric_limits<double>::infinity())
+      : m_atol(atol), m_rtol(rtol), m_h_max(h_max), m_h(0) {}
+
+  // Paso de prueba para el siguiente integrate (por defecto todo el tramo)
+  void set_step(double h) { m_h = std::min(h, m_h_max); }
+  double step_size() const { return m_h; }
+
+  const Statistics &statistics() const { return m_stats; }
+
+  // Integra vars desde t hasta t_end. sample(t_k, y) se llama para
+  // cada t_k = k * dt_out en (t, t_end], interpolando dentro del paso.
+  template <typename Sample>
+  void integrate(System &system, precission_t *vars, precission_t *params, double t,
+                 double t_end, double dt_out, Sample &&sample) {
+    run<true>(system, vars, params, t, t_end, dt_out, sample);
+  }
+
+  void integrate(System &system, precission_t *vars, precission_t *params, double t,
+                 double t_end) {
+    auto none = [](double, const precission_t *) {};
+    run<false>(system, vars, params, t, t_end, 0.0, none);
+  }
+
+private:
+  typedef DormandPrince54 DP;
+
+  template <bool dense, typename Sample>
+  void run(System &system, precission_t *vars, precission_t *params, double t,
+           double t_end, double dt_out, Sample &sample) {
+    using std::fabs;
+
+    if (!(t_end > t)) {
+      return;
+    }
+    const double eps = 1e-12 * std::max(1.0, std::fabs(t_end));
+    long next_k = 0;
+    if (dense) {
+      next_k = static_cast<long>(std::floor((t + 1e-9 * dt_out) / dt_out)) + 1;
+    }
+
+    precission_t k1[n], k2[n], k3[n], k4[n], k5[n], k6[n], k7[n], y[n], aux[n];
+    precission_t r1[n], r2[n], r3[n], r4[n], r5[n];
+
+    eval(system, vars, params, k1);
+    double h = m_h > 0 ? m_h : initial_step(system, vars, params, k1, aux, k2);
+    h = std::min(h, m_h_max);
+    bool rejected = false;
+
+    while (t < t_end - eps) {
+      bool last = t + h >= t_end - eps;
+      if (last) {
+        h = t_end - t;
+      }
+      if (h < eps) {
+        throw std::runtime_error("DormandPrince54: paso demasiado pequeño");
+      }
+      const precission_t H(h);
+
+      for (std::size_t i = 0; i < n; ++i) {
+        aux[i] = vars[i] + H * (DP::a21 * k1[i]);
+      }
+      eval(system, aux, params, k2);
+      for (std::size_t i = 0; i < n; ++i) {
+        aux[i] = vars[i] + H * (DP::a31 * k1[i] + DP::a32 * k2[i]);
+      }
+      eval(system, aux, params, k3);
+      for (std::size_t i = 0; i < n; ++i) {
+        aux[i] = vars[i] + H * (DP::a41 * k1[i] + DP::a42 * k2[i] + DP::a43 * k3[i]);
+      }
+      eval(system, aux, params, k4);
+      for (std::size_t i = 0; i < n; ++i) {
+        aux[i] = vars[i] + H * (DP::a51 * k1[i] + DP::a52 * k2[i] + DP::a53 * k3[i] +
+                                DP::a54 * k4[i]);
+      }
+      eval(system, aux, params, k5);
+      for (std::size_t i = 0; i < n; ++i) {
+        aux[i] = vars[i] + H * (DP::a61 * k1[i] + DP::a62 * k2[i] + DP::a63 * k3[i] +
+                                DP::a64 * k4[i] + DP::a65 * k5[i]);
+      }
+      eval(system, aux, params, k6);
+      for (std::size_t i = 0; i < n; ++i) {
+        y[i] = vars[i] + H * (DP::a71 * k1[i] + DP::a73 * k3[i] + DP::a74 * k4[i] +
+                              DP::a75 * k5[i] + DP::a76 * k6[i]);
+      }
+      eval(system, y, params, k7);
+
+      // Norma RMS del error relativa a las tolerancias
+      double err = 0.0;
+      for (std::size_t i = 0; i < n; ++i) {
+        double e = h * static_cast<double>(DP::e1 * k1[i] + DP::e3 * k3[i] + DP::e4 * k4[i] +
+                                           DP::e5 * k5[i] + DP::e6 * k6[i] + DP::e7 * k7[i]);
+        double scale = m_atol + m_rtol * std::max(static_cast<double>(fabs(vars[i])),
+                                                  static_cast<double>(fabs(y[i])));
+        err += (e / scale) * (e / scale);
+      }
+      err = std::sqrt(err / n);
+
+      // Factor de cambio del paso: 0.9 err^(-1/5), entre 0.2 y 5. Un
+      // error no finito (exp desbordado con un paso enorme) se trata
+      // como muy grande.
+      double factor = err > 0 ? 0.9 * std::pow(err, -0.2) : 5.0;
+      factor = std::isfinite(err) ? std::clamp(factor, 0.2, 5.0) : 0.2;
+
+      if (!(err <= 1.0)) {
+        // Rechazado: se repite desde t con un paso menor
+        ++m_stats.rejected;
+        h *= std::min(factor, 1.0);
+        rejected = true;
+        continue;
+      }
+      ++m_stats.accepted;
+
+      if (dense) {
+        for (std::size_t i = 0; i < n; ++i) {
+          precission_t diff = y[i] - vars[i];
+          precission_t bspl = H * k1[i] - diff;
+          r1[i] = vars[i];
+          r2[i] = diff;
+          r3[i] = bspl;
+          r4[i] = diff - H * k7[i] - bspl;
+          r5[i] = H * (DP::d1 * k1[i] + DP::d3 * k3[i] + DP::d4 * k4[i] + DP::d5 * k5[i] +
+                       DP::d6 * k6[i] + DP::d7 * k7[i]);
+        }
+      }
+
+      double t_new = last ? t_end : t + h;
+      for (std::size_t i = 0; i < n; ++i) {
+        vars[i] = y[i];
+        k1[i] = k7[i];
+      }
+
+      if (dense) {
+        for (double t_k = next_k * dt_out; t_k <= t_new + 1e-9 * dt_out; t_k = ++next_k * dt_out) {
+          const precission_t theta(std::min(1.0, (t_k - t) / h));
+          const precission_t theta1 = precission_t(1) - theta;
+          for (std::size_t i = 0; i < n; ++i) {
+            aux[i] = r1[i] + theta * (r2[i] + theta1 * (r3[i] + theta * (r4[i] + theta1 * r5[i])));
+          }
+          sample(t_k, static_cast<const precission_t *>(aux));
+        }
+      }
+
+      // Tras un rechazo no se deja crecer el paso
+      double h_new = h * (rejected ? std::min(factor, 1.0) : factor);
+      // Un paso recortado para acabar en t_end no limita el siguiente
+      m_h = std::min(last ? std::max(h_new, m_h) : h_new, m_h_max);
+      h = m_h;
+      t = t_new;
+      rejected = false;
+    }
+  }
+
+  // Norma RMS de x escalada con las tolerancias respecto a y
+  double norm(const precission_t *x, const precission_t *y) const {
+    using std::fabs;
+    double sum = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+      double scaled = static_cast<double>(x[i]) /
+                      (m_atol + m_rtol * static_cast<double>(fabs(y[i])));
+      sum += scaled * scaled;
+    }
+    return std::sqrt(sum / n);
+  }
+
+  // Paso inicial cuando no hay uno previo (Hairer, Nørsett y Wanner,
+  // sección II.4): un paso de Euler de prueba estima la segunda derivada
+  double initial_step(System &system, precission_t *vars, precission_t *params,
+                      const precission_t *f0, precission_t *y1, precission_t *f1) {
+    double d0 = norm(vars, vars);
+    double d1 = norm(f0, vars);
+    double h0 = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01 * d0 / d1;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      y1[i] = vars[i] + precission_t(h0) * f0[i];
+    }
+    eval(system, y1, params, f1);
+    for (std::size_t i = 0; i < n; ++i) {
+      y1[i] = f1[i] - f0[i];
+    }
+    double d2 = norm(y1, vars) / h0;
+
+    double d = std::max(d1, d2);
+    double h1 = d <= 1e-15 ? std::max(1e-6, h0 * 1e-3) : std::pow(0.01 / d, 0.2);
+    return std::min(100 * h0, h1);
+  }
+
+  void eval(System &system, const precission_t *vars, precission_t *params,
+            precission_t *incs) {
+    system.eval(vars, params, incs);
+    ++m_stats.evaluations;
+  }
+
+  double m_atol, m_rtol, m_h_max;
+  double m_h;
+  Statistics m_stats;
+};
+
+#endif /* DORMANDPRINCE54_H_ */
@@ -0,0 +1,168 @@
+/*************************************************************
+ * Dual.h - Números duales para derivar respecto a K parámetros
+ *
+ * Dual<T, K> se comporta como un escalar de tipo T que además lleva K
+ * derivadas (tangentes) respecto a K parámetros elegidos: cada
+ * operación aplica la regla de la cadena (diferenciación automática
+ * en modo directo). Como los modelos de Neun están parametrizados por
+ * la precisión, igual que con Lanes (SimdLanes.h), instanciar por
+ * ejemplo
+ *
+ *   typedef Dual<double, 8> D;
+ *   DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<D>>, RungeKutta4>
+ *
+ * (o VavoulisCGCModel<D>, HodgkinHuxleyModel<D>, GradualActivationSynapsis
+ * con precisión D) integra la trayectoria y a la vez sus derivadas
+ * respecto a los parámetros sembrados con D::variable(valor, i). Una
+ * única simulación sustituye a las 2K de las diferencias centradas, y
+ * las derivadas son las de la trayectoria discreta del integrador, sin
+ * error de truncamiento ni de cancelación.
+ *
+ * Funciones: exp, log, pow, sqrt, fabs, tanh, sin, cos. Las
+ * comparaciones sólo miran el valor, así que las ramas del modelo
+ * siguen la trayectoria y la derivada es la de la rama tomada (en un
+ * spike que cruza un umbral justo en ese paso no existe).
+ *
+ * Las tangentes parten de cero en el estado inicial: son derivadas
+ * con las condiciones iniciales fijas.
+ *
+ *************************************************************/
+
+#ifndef DUAL_H_
+#define DUAL_H_
+
+#include <array>
+#include <cmath>
+#include <type_traits>
+
+template <typename T, int K> class Dual {
+  static_assert(std::is_floating_point_v<T>, "Dual necesita un tipo de coma flotante");
+  static_assert(K > 0, "K debe ser positivo");
+
+public:
+  typedef T value_type;
+  static constexpr int tangents = K;
+
+  Dual() : m_value(0), m_d{} {}
+  Dual(T x) : m_value(x), m_d{} {}
+
+  // Parámetro independiente número i (tangente e_i)
+  static Dual variable(T x, int i) {
+    Dual r(x);
+    r.m_d[i] = T(1);
+    return r;
+  }
+
+  T value() const { return m_value; }
+  T derivative(int i) const { return m_d[i]; }
+  void set_derivative(int i, T x) { m_d[i] = x; }
+
+  explicit operator T() const { return m_value; }
+
+  Dual &operator+=(const Dual &o) {
+    m_value += o.m_value;
+    for (int i = 0; i < K; ++i) {
+      m_d[i] += o.m_d[i];
+    }
+    return *this;
+  }
+  Dual &operator-=(const Dual &o) {
+    m_value -= o.m_value;
+    for (int i = 0; i < K; ++i) {
+      m_d[i] -= o.m_d[i];
+    }
+    return *this;
+  }
+  Dual &operator*=(const Dual &o) { return *this = *this * o; }
+  Dual &operator/=(const Dual &o) { return *this = *this / o; }
+
+  Dual operator-() const { return chain(-m_value, T(-1), *this); }
+  Dual operator+() const { return *this; }
+
+  friend Dual operator+(const Dual &a, const Dual &b) { return Dual(a) += b; }
+  friend Dual operator-(const Dual &a, const Dual &b) { return Dual(a) -= b; }
+  friend Dual operator*(const Dual &a, const Dual &b) {
+    Dual r(a.m_value * b.m_value);
+    for (int i = 0; i < K; ++i) {
+      r.m_d[i] = a.m_d[i] * b.m_value + a.m_value * b.m_d[i];
+    }
+    return r;
+  }
+  friend Dual operator/(const Dual &a, const Dual &b) {
+    const T q = a.m_value / b.m_value;
+    Dual r(q);
+    for (int i = 0; i < K; ++i) {
+      r.m_d[i] = (a.m_d[i] - q * b.m_d[i]) / b.m_value;
+    }
+    return r;
+  }
+  friend Dual operator+(T a, const Dual &b) { return chain(a + b.m_value, T(1), b); }
+  friend Dual operator-(T a, const Dual &b) { return chain(a - b.m_value, T(-1), b); }
+  friend Dual operator*(T a, const Dual &b) { return chain(a * b.m_value, a, b); }
+  friend Dual operator/(T a, const Dual &b) {
+    const T q = a / b.m_value;
+    return chain(q, -q / b.m_value, b);
+  }
+  friend Dual operator+(const Dual &a, T b) { return chain(a.m_value + b, T(1), a); }
+  friend Dual operator-(const Dual &a, T b) { return chain(a.m_value - b, T(1), a); }
+  friend Dual operator*(const Dual &a, T b) { return chain(a.m_value * b, b, a); }
+  friend Dual operator/(const Dual &a, T b) { return chain(a.m_value / b, T(1) / b, a); }
+
+  friend bool operator==(const Dual &a, const Dual &b) { return a.m_value == b.m_value; }
+  friend bool operator!=(const Dual &a, const Dual &b) { return a.m_value != b.m_value; }
+  friend bool operator<(const Dual &a, const Dual &b) { return a.m_value < b.m_value; }
+  friend bool operator>(const Dual &a, const Dual &b) { return a.m_value > b.m_value; }
+  friend bool operator<=(const Dual &a, const Dual &b) { return a.m_value <= b.m_value; }
+  friend bool operator>=(const Dual &a, const Dual &b) { return a.m_value >= b.m_value; }
+
+  friend Dual exp(const Dual &x) {
+    const T e = std::exp(x.m_value);
+    return chain(e, e, x);
+  }
+  friend Dual log(const Dual &x) { return chain(std::log(x.m_value), T(1) / x.m_value, x); }
+  friend Dual pow(const Dual &x, const Dual &y) {
+    const T p = std::pow(x.m_value, y.m_value);
+    Dual r = chain(p, y.m_value * std::pow(x.m_value, y.m_value - T(1)), x);
+    // d/dy x^y = x^y log(x), sólo si y depende de algún parámetro
+    // (con x <= 0 el logaritmo no existe)
+    for (int i = 0; i < K; ++i) {
+      if (y.m_d[i] != T(0)) {
+        r.m_d[i] += p * std::log(x.m_value) * y.m_d[i];
+      }
+    }
+    return r;
+  }
+  friend Dual pow(const Dual &x, T y) {
+    if (y == T(2)) {
+      return x * x;
+    }
+    return chain(std::pow(x.m_value, y), y * std::pow(x.m_value, y - T(1)), x);
+  }
+  friend Dual fabs(const Dual &x) { return x.m_value < T(0) ? -x : x; }
+  friend Dual abs(const Dual &x) { return fabs(x); }
+  friend Dual sqrt(const Dual &x) {
+    const T s = std::sqrt(x.m_value);
+    return chain(s, T(0.5) / s, x);
+  }
+  friend Dual tanh(const Dual &x) {
+    const T t = std::tanh(x.m_value);
+    return chain(t, T(1) - t * t, x);
+  }
+  friend Dual sin(const Dual &x) { return chain(std::sin(x.m_value), std::cos(x.m_value), x); }
+  friend Dual cos(const Dual &x) { return chain(std::cos(x.m_value), -std::sin(x.m_value), x); }
+
+private:
+  // f(x) con valor y derivada f'(x) dados: tangentes f'(x) dx
+  static Dual chain(T value, T slope, const Dual &x) {
+    Dual r(value);
+    for (int i = 0; i < K; ++i) {
+      r.m_d[i] = slope * x.m_d[i];
+    }
+    return r;
+  }
+
+  T m_value;
+  std::array<T, K> m_d;
+};
+
+#endif /* DUAL_H_ */
@@ -0,0 +1,56 @@
+/*************************************************************
+ * DynamicRungeKutta4.h - RungeKutta4 para sistemas de tamaño dinámico
+ *
+ * El RungeKutta4 de Neun reserva las etapas en la pila con
+ * System::n_variables, así que no sirve para una FusedNetwork con
+ * std::dynamic_extent. Éste hace las mismas operaciones con n =
+ * system.size() y las etapas en un vector del sistema, que se
+ * dimensiona en el primer paso:
+ *
+ *   DynamicRungeKutta4::step(system, h, vars, params, stages);
+ *
+ * FusedNetwork le pasa su propio vector, así que basta con
+ * net.step<DynamicRungeKutta4>(h).
+ *
+ *************************************************************/
+
+#ifndef DYNAMICRUNGEKUTTA4_H_
+#define DYNAMICRUNGEKUTTA4_H_
+
+#include <cstddef>
+#include <vector>
+
+class DynamicRungeKutta4 {
+public:
+  template <typename System>
+  static void step(System &system, typename System::precission_t h,
+                   typename System::precission_t *const vars,
+                   typename System::precission_t *const params,
+                   std::vector<typename System::precission_t> &stages) {
+    typedef typename System::precission_t T;
+    const std::size_t n = system.size();
+    if (stages.size() != 5 * n) {
+      stages.assign(5 * n, T(0));
+    }
+    T *k1 = stages.data(), *k2 = k1 + n, *k3 = k2 + n, *k4 = k3 + n, *aux = k4 + n;
+
+    system.eval(vars, params, k1);
+    for (std::size_t i = 0; i < n; ++i) {
+      aux[i] = vars[i] + k1[i] * h * 0.5;
+    }
+    system.eval(aux, params, k2);
+    for (std::size_t i = 0; i < n; ++i) {
+      aux[i] = vars[i] + k2[i] * h * 0.5;
+    }
+    system.eval(aux, params, k3);
+    for (std::size_t i = 0; i < n; ++i) {
+      aux[i] = vars[i] + k3[i] * h;
+    }
+    system.eval(aux, params, k4);
+    for (std::size_t i = 0; i < n; ++i) {
+      vars[i] += (k1[i] + 2.0 * k2[i] + 2.0 * k3[i] + k4[i]) * h / 6.0;
+    }
+  }
+};
+
+#endif /* DYNAMICRUNGEKUTTA4_H_ */
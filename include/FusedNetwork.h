@@ -0,0 +1,217 @@
+/*************************************************************
+ * FusedNetwork.h - Red de neuronas y sinapsis en un único vector
+ *
+ * En cpg_completo.cpp cada neurona y cada sinapsis tiene su propio
+ * integrador: en cada paso las sinapsis avanzan con el voltaje de
+ * las neuronas al principio del paso y las neuronas reciben una
+ * corriente sináptica fija durante todo el paso (también en las
+ * etapas intermedias de RungeKutta4). Con gsyn = 50 (N2v -> N1M) ese
+ * acoplamiento explícito es el que limita el paso.
+ *
+ * FusedNetwork junta el estado de Neurons neuronas del mismo tipo y
+ * de Synapses sinapsis de activación gradual en un vector contiguo,
+ *
+ *   [ neurona 0 | neurona 1 | ... | r0 s0 | r1 s1 | ... ]
+ *
+ * y su eval calcula la derivada de toda la red: corrientes sinápticas
+ * con los voltajes de la etapa y derivadas de las neuronas con esas
+ * corrientes. Cumple el contrato de sistema de Neun (precission_t,
+ * n_variables, eval), así que se integra de una sola pasada con
+ * RungeKutta4 o DormandPrince54:
+ *
+ *   net.step<RungeKutta4>(0.05);
+ *
+ * En float la red guarda además una copia del estado en double para
+ * MixedRungeKutta4 (net.step<MixedRungeKutta4>(0.01)).
+ *
+ * Las sinapsis siguen las ecuaciones de GradualActivationSynapsis:
+ *
+ *   tau_syn * dr/dt = r_inf - r,  r_inf = 1/(1 + exp((V_r - V_pre)/dec_slope))
+ *   tau_syn * ds/dt = r - s
+ *   I_syn = g_syn * s * (V_post - E_syn)
+ *
+ * Las neuronas de Neun se usan sólo para evaluar el modelo; su estado
+ * vive en el vector de la red. La corriente total de cada neurona
+ * (sináptica + externa) se le aplica con add_synaptic_input antes de
+ * cada evaluación.
+ *
+ * Con Neurons = Synapses = std::dynamic_extent el tamaño se decide al
+ * construir la red, con vectores de argumentos (circuitos leídos de un
+ * fichero, circuitos/circuito.cpp). Los integradores de Neun necesitan
+ * n_variables constante, así que esa red se integra con
+ * DynamicRungeKutta4, que toma el tamaño de size():
+ *
+ *   FusedNetwork<Neuron, std::dynamic_extent, std::dynamic_extent> net(neurons, synapses);
+ *   net.step<DynamicRungeKutta4>(0.01);
+ *
+ *************************************************************/
+
+#ifndef FUSEDNETWORK_H_
+#define FUSEDNETWORK_H_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+template <typename Neuron, std::size_t Neurons, std::size_t Synapses> class FusedNetwork {
+  static constexpr bool dynamic = Neurons == std::dynamic_extent;
+  static_assert(dynamic == (Synapses == std::dynamic_extent),
+                "neuronas y sinapsis deben ser las dos fijas o las dos dinámicas");
+
+  // std::array con tamaño fijo, std::vector con std::dynamic_extent
+  template <typename T, std::size_t N>
+  using Storage = std::conditional_t<N == std::dynamic_extent, std::vector<T>, std::array<T, N>>;
+
+public:
+  typedef typename Neuron::precission_t precission_t;
+  typedef typename Neuron::ConstructorArgs NeuronArgs;
+
+  enum synapse_variable { r, s, n_synapse_variables };
+
+  static constexpr std::size_t neuron_variables = Neuron::n_variables;
+  static constexpr std::size_t neuron_parameters = Neuron::n_parameters;
+  static constexpr std::size_t n_variables =
+      dynamic ? std::dynamic_extent : Neurons * neuron_variables + Synapses * n_synapse_variables;
+  static constexpr std::size_t n_parameters =
+      dynamic ? std::dynamic_extent : Neurons * neuron_parameters;
+  // Variables en double para los integradores de precisión mixta
+  static constexpr std::size_t n_accumulated =
+      std::is_same_v<precission_t, float> ? n_variables : 0;
+
+  struct SynapseArgs {
+    std::size_t pre, post;  // Índices de neurona
+    precission_t esyn, gsyn, tau_syn, v_r, dec_slope;
+  };
+
+  // voltage es la variable de las neuronas que ven las sinapsis
+  FusedNetwork(Storage<NeuronArgs, Neurons> &neurons,
+               const Storage<SynapseArgs, Synapses> &synapses,
+               typename Neuron::variable voltage = Neuron::v)
+      : m_synapses(synapses), m_voltage(voltage), m_variables{}, m_parameters{},
+        m_accumulated{}, m_external{}, m_applied{} {
+    if constexpr (dynamic) {
+      m_variables.assign(neurons.size() * neuron_variables +
+                             synapses.size() * n_synapse_variables, precission_t(0));
+      m_parameters.assign(neurons.size() * neuron_parameters, precission_t(0));
+      if constexpr (n_accumulated != 0) {
+        m_accumulated.assign(m_variables.size(), 0.0);
+      }
+      m_external.assign(neurons.size(), precission_t(0));
+      m_applied.assign(neurons.size(), precission_t(0));
+    }
+    m_neurons.reserve(neurons.size());
+    for (std::size_t i = 0; i < neurons.size(); ++i) {
+      m_neurons.emplace_back(neurons[i]);
+      for (std::size_t p = 0; p < neuron_parameters; ++p) {
+        m_parameters[i * neuron_parameters + p] = neurons[i].params[p];
+      }
+    }
+  }
+
+  std::size_t neurons() const {
+    if constexpr (dynamic) {
+      return m_neurons.size();
+    } else {
+      return Neurons;
+    }
+  }
+  std::size_t synapses() const { return m_synapses.size(); }
+  std::size_t size() const { return m_variables.size(); }
+
+  precission_t get(std::size_t neuron, typename Neuron::variable var) const {
+    return m_variables[neuron * neuron_variables + var];
+  }
+  void set(std::size_t neuron, typename Neuron::variable var, precission_t x) {
+    m_variables[neuron * neuron_variables + var] = x;
+  }
+
+  precission_t get_synapse(std::size_t k, synapse_variable var) const {
+    return m_variables[synapse_offset(k) + var];
+  }
+  void set_synapse(std::size_t k, synapse_variable var, precission_t x) {
+    m_variables[synapse_offset(k) + var] = x;
+  }
+
+  // Corriente de la sinapsis k con el estado actual
+  precission_t current(std::size_t k) const {
+    return current(m_variables.data(), k);
+  }
+
+  // Corriente externa de la neurona (drive), constante hasta que se cambie
+  void set_input(std::size_t neuron, precission_t I) { m_external[neuron] = I; }
+  precission_t input(std::size_t neuron) const { return m_external[neuron]; }
+
+  precission_t *variables() { return m_variables.data(); }
+  precission_t *parameters() { return m_parameters.data(); }
+
+  template <typename Integrator> void step(double h) {
+    if constexpr (requires { typename Integrator::accumulator_t; }) {
+      static_assert(n_accumulated == n_variables, "la precisión mixta necesita una red en float");
+      Integrator::step(*this, h, m_variables.data(), m_parameters.data(), m_accumulated.data());
+    } else if constexpr (dynamic) {
+      Integrator::step(*this, precission_t(h), m_variables.data(), m_parameters.data(), m_stages);
+    } else {
+      Integrator::step(*this, precission_t(h), m_variables.data(), m_parameters.data());
+    }
+  }
+
+  void eval(const precission_t *const vars, precission_t *const params,
+            precission_t *const incs) const {
+    using std::exp;
+
+    Storage<precission_t, Neurons> &I = m_total;
+    I = m_external;
+    for (std::size_t k = 0; k < synapses(); ++k) {
+      const SynapseArgs &syn = m_synapses[k];
+      const precission_t *x = vars + synapse_offset(k);
+      precission_t v_pre = vars[syn.pre * neuron_variables + m_voltage];
+      precission_t r_inf = 1.0 / (1.0 + exp((syn.v_r - v_pre) / syn.dec_slope));
+      incs[synapse_offset(k) + r] = (r_inf - x[r]) / syn.tau_syn;
+      incs[synapse_offset(k) + s] = (x[r] - x[s]) / syn.tau_syn;
+      I[syn.post] += current(vars, k);
+    }
+
+    for (std::size_t i = 0; i < neurons(); ++i) {
+      apply_input(i, I[i]);
+      m_neurons[i].eval(vars + i * neuron_variables, params + i * neuron_parameters,
+                        incs + i * neuron_variables);
+    }
+  }
+
+private:
+  std::size_t synapse_offset(std::size_t k) const {
+    return neurons() * neuron_variables + k * n_synapse_variables;
+  }
+
+  precission_t current(const precission_t *vars, std::size_t k) const {
+    const SynapseArgs &syn = m_synapses[k];
+    return syn.gsyn * vars[synapse_offset(k) + s] *
+           (vars[syn.post * neuron_variables + m_voltage] - syn.esyn);
+  }
+
+  // Deja la entrada acumulada de la neurona en I. m_applied repite las
+  // mismas sumas que la neurona, así que coincide con lo que tiene.
+  void apply_input(std::size_t i, precission_t I) const {
+    precission_t delta = I - m_applied[i];
+    m_neurons[i].add_synaptic_input(delta);
+    m_applied[i] += delta;
+  }
+
+  Storage<SynapseArgs, Synapses> m_synapses;
+  typename Neuron::variable m_voltage;
+
+  Storage<precission_t, n_variables> m_variables;
+  Storage<precission_t, n_parameters> m_parameters;
+  Storage<double, n_accumulated> m_accumulated;
+  Storage<precission_t, Neurons> m_external;
+  // Etapas de DynamicRungeKutta4 (sólo con tamaño dinámico)
+  std::vector<precission_t> m_stages;
+
+  mutable std::vector<Neuron> m_neurons;
+  mutable Storage<precission_t, Neurons> m_total, m_applied;
+};
+
+#endif /* FUSEDNETWORK_H_ */
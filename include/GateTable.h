@@ -0,0 +1,123 @@
+/*************************************************************
+ * GateTable.h - Funciones de V tabuladas con interpolación
+ *
+ * Las compuertas de los modelos de conductancias dependen sólo de V y
+ * de parámetros fijos: x_inf(V), tau_x(V), activaciones instantáneas.
+ * GateTable precalcula Columns de esas funciones en una rejilla
+ * uniforme [v_min, v_max] con paso dv y las interpola en el bucle:
+ *
+ *   GateTable<double, 3> table(f, -120, 80, 0.05, Interpolation::cubic);
+ *   table.lookup(V, out);      // out[0..2] ~ f(V)
+ *
+ * f(V, out) rellena las Columns funciones exactas. Un único cálculo de
+ * índice sirve para todas las columnas.
+ *
+ *   linear  error ~ dv^2 / 8 * |f''|
+ *   cubic   Hermite con la derivada exacta (diferencia central de f),
+ *           error ~ dv^4 / 384 * |f''''|
+ *
+ * Fuera de [v_min, v_max] se usa el valor del extremo. error() mide
+ * el error frente a f en puntos intermedios de cada celda.
+ *
+ *************************************************************/
+
+#ifndef GATETABLE_H_
+#define GATETABLE_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+enum class Interpolation { none, linear, cubic };
+
+template <typename T, std::size_t Columns> class GateTable {
+public:
+  template <typename Function>
+  GateTable(Function f, double v_min, double v_max, double dv, Interpolation mode)
+      : m_v_min(v_min), m_dv(dv), m_inv_dv(1.0 / dv), m_mode(mode) {
+    if (!(v_max > v_min) || !(dv > 0) || mode == Interpolation::none) {
+      throw std::invalid_argument("GateTable: rango, paso o interpolación no válidos");
+    }
+    m_points = static_cast<std::size_t>(std::ceil((v_max - v_min) / dv)) + 1;
+    m_v_max = v_min + (m_points - 1) * dv;
+    m_data.resize(m_points * Columns * 2);
+
+    // Derivada por diferencia central con un paso pequeño frente a dv
+    const double eps = dv * 1e-3;
+    std::array<T, Columns> y, up, down;
+    for (std::size_t k = 0; k < m_points; ++k) {
+      double V = v_min + k * dv;
+      f(T(V), y.data());
+      f(T(V + eps), up.data());
+      f(T(V - eps), down.data());
+      for (std::size_t c = 0; c < Columns; ++c) {
+        m_data[(k * Columns + c) * 2] = y[c];
+        // Pendiente ya multiplicada por dv (variable local t en [0, 1])
+        m_data[(k * Columns + c) * 2 + 1] = T((up[c] - down[c]) / (2 * eps) * dv);
+      }
+    }
+  }
+
+  void lookup(T V, T *out) const {
+    T s = (V - T(m_v_min)) * T(m_inv_dv);
+    s = std::clamp(s, T(0), T(m_points - 1));
+    std::size_t k = std::min(static_cast<std::size_t>(s), m_points - 2);
+    T t = s - T(k);
+    const T *a = m_data.data() + k * Columns * 2;
+    const T *b = a + Columns * 2;
+
+    if (m_mode == Interpolation::linear) {
+      for (std::size_t c = 0; c < Columns; ++c) {
+        out[c] = a[2 * c] + t * (b[2 * c] - a[2 * c]);
+      }
+      return;
+    }
+
+    // Bases de Hermite
+    T t2 = t * t, t3 = t2 * t;
+    T h00 = T(2) * t3 - T(3) * t2 + T(1);
+    T h10 = t3 - T(2) * t2 + t;
+    T h01 = T(1) - h00;
+    T h11 = t3 - t2;
+    for (std::size_t c = 0; c < Columns; ++c) {
+      out[c] = h00 * a[2 * c] + h10 * a[2 * c + 1] + h01 * b[2 * c] + h11 * b[2 * c + 1];
+    }
+  }
+
+  // Mayor error de cada columna en samples puntos interiores por celda,
+  // relativo a max(|f|, floor)
+  template <typename Function>
+  std::array<double, Columns> error(Function f, int samples = 7, double floor = 1e-6) const {
+    std::array<double, Columns> worst{};
+    std::array<T, Columns> exact, table;
+    for (std::size_t k = 0; k + 1 < m_points; ++k) {
+      for (int i = 1; i <= samples; ++i) {
+        T V = T(m_v_min + (k + double(i) / (samples + 1)) * m_dv);
+        f(V, exact.data());
+        lookup(V, table.data());
+        for (std::size_t c = 0; c < Columns; ++c) {
+          double scale = std::max(std::fabs(double(exact[c])), floor);
+          worst[c] = std::max(worst[c], std::fabs(double(table[c] - exact[c])) / scale);
+        }
+      }
+    }
+    return worst;
+  }
+
+  Interpolation mode() const { return m_mode; }
+  std::size_t points() const { return m_points; }
+  double v_min() const { return m_v_min; }
+  double v_max() const { return m_v_max; }
+  std::size_t bytes() const { return m_data.size() * sizeof(T); }
+
+private:
+  double m_v_min, m_v_max, m_dv, m_inv_dv;
+  Interpolation m_mode;
+  std::size_t m_points;
+  std::vector<T> m_data;  // Por punto y columna: valor, pendiente * dv
+};
+
+#endif /* GATETABLE_H_ */
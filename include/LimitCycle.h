@@ -0,0 +1,151 @@
+/*************************************************************
+ * LimitCycle.h - Detección del ciclo límite para parar antes
+ *
+ * Cuando sólo interesa el periodo y las fases del ritmo estable, no
+ * hace falta simular un tiempo fijo: basta con seguir el mapa de
+ * retorno de una sección de Poincaré hasta que dos vueltas seguidas
+ * coinciden. LimitCycleMonitor recibe el estado completo en cada paso
+ * y toma como sección el cruce ascendente de una de sus variables (el
+ * voltaje del soma de N1M, por ejemplo) por un umbral:
+ *
+ *   LimitCycleMonitor monitor(CPG::n_state, options);
+ *   for (long k = 0; k < steps; ++k) {
+ *     ...
+ *     cpg.state(x);                          // LymnaeaCPG::n_state valores
+ *     if (monitor.add((k + 1) * h, x) != LimitCycleMonitor::running) {
+ *       break;
+ *     }
+ *   }
+ *
+ * En cada vuelta el estado y el instante del cruce se interpolan
+ * linealmente entre los dos pasos que lo rodean. Una vuelta coincide
+ * con la anterior si cada variable cambia menos de tolerance (1 + |x|)
+ * y el periodo menos de period_tolerance (relativa); tras cycles
+ * vueltas seguidas que coinciden, add() devuelve converged.
+ *
+ * Como en BurstDetector, tras un cruce la variable tiene que bajar de
+ * reset antes de que cuente el siguiente, para que una oscilación que
+ * se amortigua alrededor del umbral no parezca un ciclo.
+ *
+ * En una neurona que dispara en ráfagas sólo cuenta el primer spike de
+ * cada ráfaga: un cruce es vuelta si el anterior está a más de gap ms
+ * (el max_isi de BurstDetector). Con gap = 0 cuenta cada spike.
+ *
+ * Si en silence ms desde begin o desde el último cruce no hay ninguno,
+ * add() devuelve no_oscillation. silence debe ser mayor que el periodo
+ * más largo que se espera (ritmos de 3-6 s con SO).
+ *
+ *************************************************************/
+
+#ifndef LIMITCYCLE_H_
+#define LIMITCYCLE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+struct LimitCycleOptions {
+  std::size_t variable = 0;       // Índice en el estado de la variable de la sección
+  double threshold = -20.0;       // Cruce ascendente (mV)
+  double reset = -40.0;           // Hay que bajar de aquí antes del siguiente cruce
+  double gap = 250.0;             // ms sin cruces antes de uno que sea vuelta
+  double tolerance = 1e-3;        // Cambio de cada variable entre vueltas
+  double period_tolerance = 1e-3; // Cambio relativo del periodo
+  int cycles = 2;                 // Vueltas seguidas que deben coincidir
+  double begin = 0.0;             // ms; antes no se vigila (transitorio)
+  double silence = 8000.0;        // ms sin cruces: no hay oscilación
+};
+
+class LimitCycleMonitor {
+public:
+  enum status { running, converged, no_oscillation };
+
+  static const char *name(status s) {
+    static const char *names[] = {"sin converger", "ciclo límite", "sin oscilación"};
+    return names[s];
+  }
+
+  LimitCycleMonitor(std::size_t n, const LimitCycleOptions &options = LimitCycleOptions())
+      : m_options(options), m_prev(n), m_section(n), m_next(n) {
+    if (options.variable >= n) {
+      throw std::invalid_argument("LimitCycleMonitor: variable de la sección fuera del estado");
+    }
+  }
+
+  // Estado x (n valores) en el instante t, tras cada paso
+  status add(double t, const double *x) {
+    if (m_status != running) {
+      return m_status;
+    }
+    const double v = x[m_options.variable], threshold = m_options.threshold;
+    if (v < m_options.reset) {
+      m_armed = true;
+    }
+    if (m_armed && m_started && m_prev[m_options.variable] < threshold && v >= threshold) {
+      const double v0 = m_prev[m_options.variable];
+      const double a = (threshold - v0) / (v - v0);
+      const double tc = m_t_prev + a * (t - m_t_prev);
+      const bool lap = tc - m_crossing > m_options.gap;
+      m_crossing = tc;
+      m_armed = false;
+      if (lap && tc >= m_options.begin) {
+        for (std::size_t i = 0; i < m_next.size(); ++i) {
+          m_next[i] = m_prev[i] + a * (x[i] - m_prev[i]);
+        }
+        section(tc);
+      }
+    } else if (t - std::max(m_options.begin, m_crossing) > m_options.silence) {
+      m_status = no_oscillation;
+    }
+    std::copy(x, x + m_prev.size(), m_prev.begin());
+    m_t_prev = t;
+    m_started = true;
+    return m_status;
+  }
+
+  status state() const { return m_status; }
+  long returns() const { return m_returns; }
+  double time() const { return m_time; }              // Instante de la última vuelta
+  double period() const { return m_period; }          // Entre las dos últimas vueltas
+  double difference() const { return m_difference; }  // Mayor cambio de una variable
+  const std::vector<double> &section_state() const { return m_section; }
+
+private:
+  void section(double t) {
+    if (m_returns > 0) {
+      double difference = 0.0;
+      for (std::size_t i = 0; i < m_next.size(); ++i) {
+        difference = std::max(difference,
+                              std::fabs(m_next[i] - m_section[i]) / (1.0 + std::fabs(m_next[i])));
+      }
+      const double period = t - m_time;
+      const bool agree = m_returns > 1 && difference <= m_options.tolerance &&
+                         std::fabs(period - m_period) <= m_options.period_tolerance * period;
+      m_agree = agree ? m_agree + 1 : 0;
+      m_difference = difference;
+      m_period = period;
+      if (m_agree >= m_options.cycles) {
+        m_status = converged;
+      }
+    }
+    m_section.swap(m_next);
+    m_time = t;
+    ++m_returns;
+  }
+
+  LimitCycleOptions m_options;
+  std::vector<double> m_prev, m_section, m_next;
+  double m_t_prev = 0.0;
+  double m_crossing = -std::numeric_limits<double>::infinity();
+  bool m_started = false, m_armed = false;
+
+  status m_status = running;
+  long m_returns = 0;
+  int m_agree = 0;
+  double m_time = NAN, m_period = NAN, m_difference = NAN;
+};
+
+#endif /* LIMITCYCLE_H_ */
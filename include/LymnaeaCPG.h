@@ -0,0 +1,444 @@
+/*************************************************************
+ * LymnaeaCPG.h - CPG completo de alimentación de Lymnaea como objeto
+ *
+ * Encapsula la red de circuitos/cpg_completo.cpp (N1M, N2v, N3t y SO
+ * con las 8 sinapsis GradualActivationSynapsis de la Tabla 2 de
+ * Vavoulis et al. 2007) para poder crear muchas instancias
+ * independientes, por ejemplo en un barrido de parámetros.
+ *
+ * Los valores por defecto de CPGParameters son los de cpg_completo.
+ *
+ * FusedLymnaeaCPG es la misma red sobre FusedNetwork: todo el estado
+ * en un vector y un único integrador para neuronas y sinapsis.
+ *
+ * LymnaeaCPG::save / restore guardan y recuperan el estado de todas
+ * las neuronas y sinapsis en un Checkpoint, con los nombres de
+ * CPGParameters::neuron_name y synapse_name. FusedLymnaeaCPG::save
+ * escribe el mismo formato; state() copia esas variables en un array.
+ *
+ * Con precisión Dual<double, K> (Dual.h) la red calcula además las
+ * derivadas de la trayectoria respecto a los parámetros que se siembren
+ * en el constructor (herramientas/sensibilidad.cpp).
+ *
+ * Las dos avanzan por pasos k de la rejilla t = k h (step(k, h)) y
+ * toman el drive tónico de CPGDrive, compilado una vez con Stimulus.h.
+ *
+ * steady_state() lleva cualquiera de las dos al punto de reposo de la
+ * red completa (SteadyState.h), con o sin el drive.
+ *
+ *************************************************************/
+
+#ifndef LYMNAEACPG_H_
+#define LYMNAEACPG_H_
+
+#include <Checkpoint.h>
+#include <DifferentialNeuronWrapper.h>
+#include <FusedNetwork.h>
+#include <GradualActivationSynapsis.h>
+#include <RungeKutta4.h>
+#include <SteadyState.h>
+#include <Stimulus.h>
+#include <SystemWrapper.h>
+#include <VavoulisModel.h>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <string>
+
+struct CPGParameters {
+  // Orden de las sinapsis en gsyn / tau_syn
+  enum synapse {
+    n1m_n2v, n2v_n1m, n1m_n3t, n3t_n1m, n2v_n3t, n2v_so, so_n1m, so_n2v,
+    n_synapses
+  };
+
+  enum neuron { N1M, N2v, N3t, SO, n_neurons };
+
+  // Neurona presináptica y postsináptica de cada sinapsis
+  static int synapse_pre(int s) {
+    static const int pre[n_synapses] = {N1M, N2v, N1M, N3t, N2v, N2v, SO, SO};
+    return pre[s];
+  }
+  static int synapse_post(int s) {
+    static const int post[n_synapses] = {N2v, N1M, N3t, N1M, N3t, SO, N1M, N2v};
+    return post[s];
+  }
+
+  static const char *neuron_name(int n) {
+    static const char *names[n_neurons] = {"N1M", "N2v", "N3t", "SO"};
+    return names[n];
+  }
+
+  static const char *synapse_name(int s) {
+    static const char *names[n_synapses] = {
+        "n1m_n2v", "n2v_n1m", "n1m_n3t", "n3t_n1m",
+        "n2v_n3t", "n2v_so",  "so_n1m",  "so_n2v"};
+    return names[s];
+  }
+
+  // Drive tónico (corriente negativa = despolarizante)
+  double I_drive_so = -8.5;
+  double I_drive_n1m = -6.0;
+  double I_drive_n2v = -2.0;
+  double I_drive_n3t = 0.0;
+  double t_stim_start = 100;
+  double t_stim_end = 9500;
+
+  // Tabla 2 (Vavoulis 2007)
+  double gsyn[n_synapses] = {0.077, 50.0, 0.5, 8.0, 2.0, 8.0, 4.0, 1.0};
+  double tau_syn[n_synapses] = {200.0, 50.0, 50.0, 50.0, 50.0, 50.0, 200.0, 200.0};
+  double esyn[n_synapses] = {0.0, -90.0, -90.0, -90.0, -90.0, -90.0, 0.0, 0.0};
+
+  double drive(int n) const {
+    const double I[n_neurons] = {I_drive_n1m, I_drive_n2v, I_drive_n3t, I_drive_so};
+    return I[n];
+  }
+
+  // Permite fijar gsyn_<sinapsis>, tau_syn_<sinapsis> o I_drive_<neurona>
+  // por nombre. Devuelve false si el nombre no existe.
+  bool set(const std::string &name, double value) {
+    if (name == "I_drive_so") { I_drive_so = value; return true; }
+    if (name == "I_drive_n1m") { I_drive_n1m = value; return true; }
+    if (name == "I_drive_n2v") { I_drive_n2v = value; return true; }
+    if (name == "I_drive_n3t") { I_drive_n3t = value; return true; }
+    for (int s = 0; s < n_synapses; ++s) {
+      if (name == std::string("gsyn_") + synapse_name(s)) { gsyn[s] = value; return true; }
+      if (name == std::string("tau_syn_") + synapse_name(s)) { tau_syn[s] = value; return true; }
+    }
+    return false;
+  }
+};
+
+// Ventana del drive tónico [t_stim_start, t_stim_end) sobre la rejilla
+// de pasos: on(k, h) es 1 dentro y 0 fuera. Se compila en el primer
+// paso y otra vez sólo si cambia h.
+class CPGDrive {
+public:
+  explicit CPGDrive(const CPGParameters &p)
+      : m_protocol(StimulusProtocol().pulse(p.t_stim_start, p.t_stim_end, 1.0)), m_h(0) {}
+
+  double on(long k, double h) {
+    if (h != m_h) {
+      m_window = m_protocol.compile(h);
+      m_h = h;
+    }
+    return m_window->current(k);
+  }
+
+private:
+  StimulusProtocol m_protocol;
+  std::optional<Stimulus> m_window;
+  double m_h;
+};
+
+// Parámetros de la Tabla 1, reposo a -67 mV y protocolo de los ejemplos
+// de cada neurona del CPG
+template <typename Neuron> struct CPGNeurons {
+  static void args(int k, typename Neuron::ConstructorArgs &args) {
+    // n_type, tau_p, tau_q, g_eca, g_ecs
+    static const double table[CPGParameters::n_neurons][5] = {
+        {1, 250.0, 1.0, 8.0, 8.0},   // N1M
+        {2, 1.0, 1.0, 0.06, 0.55},   // N2v
+        {3, 4.0, 400.0, 8.0, 8.0},   // N3t
+        {0, 1.0, 1.0, 8.0, 8.0}};    // SO
+    args.params[Neuron::n_type] = table[k][0];
+    args.params[Neuron::tau_p] = table[k][1];
+    args.params[Neuron::tau_q] = table[k][2];
+    args.params[Neuron::g_eca] = table[k][3];
+    args.params[Neuron::g_ecs] = table[k][4];
+  }
+
+  // set(variable, valor) fija cada variable (igual que cpg_completo.cpp)
+  template <typename Set> static void rest(int k, Set set) {
+    using std::exp;
+    set(Neuron::v, -67.0);
+    set(Neuron::va, -67.0);
+    switch (k) {
+    case CPGParameters::N1M:
+      set(Neuron::p, 1 / (1 + exp((-38.8 - (-67.0)) / 10.0)));
+      set(Neuron::q, 0.0);
+      break;
+    case CPGParameters::N2v:
+      set(Neuron::p, 1 / (1 + exp((-51 - (-67.0)) / 10.3)));
+      set(Neuron::q, 1 / (1 + exp((-45 - (-67.0)) / -3)));
+      break;
+    case CPGParameters::N3t:
+      set(Neuron::p, 1 / (1 + exp((-61.6 - (-67)) / 5.6)));
+      set(Neuron::q, 1 / (1 + exp((-73.2 - (-67)) / -5.1)));
+      break;
+    default:
+      set(Neuron::p, 0.0);
+      set(Neuron::q, 0.0);
+      break;
+    }
+    set(Neuron::h, 1 / (1 + exp((-55.2 - (-67.0)) / -7.1)));
+    set(Neuron::n, 1.0 / (1.0 + exp((-30.0 - (-67.0)) / 17.4)));
+  }
+
+  // Estímulo y duración (ms) de cada neurona aislada en neuronas/N1.cpp,
+  // N2.cpp, N3.cpp y SO.cpp
+  static StimulusProtocol protocol(int k) {
+    switch (k) {
+    case CPGParameters::N1M:
+      return StimulusProtocol().pulse(200, 1800, -10.0);
+    case CPGParameters::N2v:
+      return StimulusProtocol().pulse(300, 2700, -5.0);
+    case CPGParameters::N3t:
+      return StimulusProtocol().pulse(1000, 1800, 8.0);
+    default:
+      return StimulusProtocol()
+          .pulse(200, 2800, -10.0)
+          .set(800, 900, 15.0)
+          .set(1500, 1600, 15.0)
+          .set(2200, 2300, 15.0);
+    }
+  }
+
+  static double simulation_time(int k) {
+    static const double time[CPGParameters::n_neurons] = {2000, 3000, 4000, 3000};
+    return time[k];
+  }
+};
+
+template <typename Precission> class FusedLymnaeaCPG;
+
+template <typename Integrator = RungeKutta4, typename Precission = double>
+class LymnaeaCPG {
+public:
+  typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<Precission>>, Integrator> Neuron;
+  typedef GradualActivationSynapsis<Neuron, Neuron, Integrator, Precission> Synapse;
+
+  explicit LymnaeaCPG(const CPGParameters &params = CPGParameters())
+      : LymnaeaCPG(params, [](int, typename Synapse::ConstructorArgs &) {}) {}
+
+  // setup(s, args) puede cambiar los parámetros de la sinapsis s antes
+  // de crearla, por ejemplo para sembrar las tangentes de gsyn (Dual.h)
+  template <typename Setup>
+  LymnaeaCPG(const CPGParameters &params, Setup setup)
+      : m_params(params), m_drive(m_params), m_syn_args(m_params, setup),
+        n1m(m_neuron_args.n1m), n2v(m_neuron_args.n2v),
+        n3t(m_neuron_args.n3t), so(m_neuron_args.so),
+        s_n1m_n2v(n1m, Neuron::v, n2v, Neuron::v, m_syn_args[CPGParameters::n1m_n2v], 1),
+        s_n2v_n1m(n2v, Neuron::v, n1m, Neuron::v, m_syn_args[CPGParameters::n2v_n1m], 1),
+        s_n1m_n3t(n1m, Neuron::v, n3t, Neuron::v, m_syn_args[CPGParameters::n1m_n3t], 1),
+        s_n3t_n1m(n3t, Neuron::v, n1m, Neuron::v, m_syn_args[CPGParameters::n3t_n1m], 1),
+        s_n2v_n3t(n2v, Neuron::v, n3t, Neuron::v, m_syn_args[CPGParameters::n2v_n3t], 1),
+        s_n2v_so(n2v, Neuron::v, so, Neuron::v, m_syn_args[CPGParameters::n2v_so], 1),
+        s_so_n1m(so, Neuron::v, n1m, Neuron::v, m_syn_args[CPGParameters::so_n1m], 1),
+        s_so_n2v(so, Neuron::v, n2v, Neuron::v, m_syn_args[CPGParameters::so_n2v], 1) {
+    // Condiciones iniciales: reposo a -67 mV (igual que cpg_completo.cpp)
+    Neuron *neurons[CPGParameters::n_neurons] = {&n1m, &n2v, &n3t, &so};
+    for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+      CPGNeurons<Neuron>::rest(k, [&](typename Neuron::variable var, double x) {
+        neurons[k]->set(var, x);
+      });
+    }
+  }
+
+  LymnaeaCPG(const LymnaeaCPG &) = delete;
+  LymnaeaCPG &operator=(const LymnaeaCPG &) = delete;
+
+  // Paso k, de k h a (k + 1) h, en el mismo orden que el bucle de
+  // cpg_completo.cpp: sinapsis, drive y neuronas
+  void step(long k, double h) {
+    s_n1m_n2v.step(h);
+    s_n2v_n1m.step(h);
+    s_n1m_n3t.step(h);
+    s_n3t_n1m.step(h);
+    s_n2v_n3t.step(h);
+    s_n2v_so.step(h);
+    s_so_n1m.step(h);
+    s_so_n2v.step(h);
+
+    if (m_drive.on(k, h) != 0.0) {
+      so.add_synaptic_input(m_params.I_drive_so);
+      n1m.add_synaptic_input(m_params.I_drive_n1m);
+      n2v.add_synaptic_input(m_params.I_drive_n2v);
+      n3t.add_synaptic_input(m_params.I_drive_n3t);
+    }
+
+    n1m.step(h);
+    n2v.step(h);
+    n3t.step(h);
+    so.step(h);
+  }
+
+  const CPGParameters &parameters() const { return m_params; }
+
+  // Estado de las 4 neuronas y las 8 sinapsis
+  void save(Checkpoint &state) const {
+    for_each(*this, [&](const char *name, const auto &x) { state.save(name, x); });
+  }
+  void restore(const Checkpoint &state) {
+    for_each(*this, [&](const char *name, auto &x) { state.restore(name, x); });
+  }
+
+  // Variables de state(): las de las neuronas y las sinapsis en el orden de save()
+  static constexpr std::size_t n_state = CPGParameters::n_neurons * Neuron::n_variables +
+                                         CPGParameters::n_synapses * Synapse::n_variables;
+
+  // Copia en x (n_state valores) el estado de toda la red
+  void state(double *x) const {
+    for_each(*this, [&](const char *, const auto &system) { x = state_variables(system, x); });
+  }
+
+  // Reposo de la red con o sin el drive, resuelto sobre la red
+  // fusionada (mismas ecuaciones) desde el reposo de CPGNeurons
+  SteadyStateResult steady_state(bool drive = false,
+                                 const SteadyStateOptions &options = SteadyStateOptions()) {
+    FusedLymnaeaCPG<Precission> fused(m_params);
+    SteadyStateResult result = fused.steady_state(drive, options);
+    if (result.converged) {
+      Checkpoint state;
+      fused.save(state);
+      restore(state);
+    }
+    return result;
+  }
+
+private:
+  // f(nombre, objeto) para cada neurona y sinapsis (Self puede ser const)
+  template <typename Self, typename Function> static void for_each(Self &cpg, Function f) {
+    decltype(&cpg.n1m) neurons[CPGParameters::n_neurons] = {&cpg.n1m, &cpg.n2v, &cpg.n3t, &cpg.so};
+    decltype(&cpg.s_n1m_n2v) synapses[CPGParameters::n_synapses] = {
+        &cpg.s_n1m_n2v, &cpg.s_n2v_n1m, &cpg.s_n1m_n3t, &cpg.s_n3t_n1m,
+        &cpg.s_n2v_n3t, &cpg.s_n2v_so,  &cpg.s_so_n1m,  &cpg.s_so_n2v};
+    for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+      f(CPGParameters::neuron_name(k), *neurons[k]);
+    }
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      f(CPGParameters::synapse_name(s), *synapses[s]);
+    }
+  }
+
+  struct NeuronArgs {
+    typename Neuron::ConstructorArgs n1m, n2v, n3t, so;
+
+    NeuronArgs() {
+      CPGNeurons<Neuron>::args(CPGParameters::N1M, n1m);
+      CPGNeurons<Neuron>::args(CPGParameters::N2v, n2v);
+      CPGNeurons<Neuron>::args(CPGParameters::N3t, n3t);
+      CPGNeurons<Neuron>::args(CPGParameters::SO, so);
+    }
+  };
+
+  struct SynapseArgs {
+    typename Synapse::ConstructorArgs args[CPGParameters::n_synapses];
+
+    template <typename Setup> SynapseArgs(const CPGParameters &p, Setup &setup) {
+      for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+        args[s].params[Synapse::esyn] = p.esyn[s];
+        args[s].params[Synapse::gsyn] = p.gsyn[s];
+        args[s].params[Synapse::tau_syn] = p.tau_syn[s];
+        args[s].params[Synapse::v_pre] = -67.0;
+        args[s].params[Synapse::v_r] = -40.0;
+        args[s].params[Synapse::dec_slope] = 2.5;
+        setup(s, args[s]);
+      }
+    }
+
+    typename Synapse::ConstructorArgs &operator[](int s) { return args[s]; }
+  };
+
+  CPGParameters m_params;
+  CPGDrive m_drive;
+  NeuronArgs m_neuron_args;
+  SynapseArgs m_syn_args;
+
+public:
+  Neuron n1m, n2v, n3t, so;
+  Synapse s_n1m_n2v, s_n2v_n1m, s_n1m_n3t, s_n3t_n1m, s_n2v_n3t;
+  Synapse s_n2v_so, s_so_n1m, s_so_n2v;
+};
+
+template <typename Precission = double> class FusedLymnaeaCPG {
+public:
+  typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<Precission>>, RungeKutta4> Neuron;
+  typedef FusedNetwork<Neuron, CPGParameters::n_neurons, CPGParameters::n_synapses> Network;
+
+  explicit FusedLymnaeaCPG(const CPGParameters &params = CPGParameters())
+      : m_params(params), m_drive(m_params), network(neuron_args(), synapse_args(params)) {
+    for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+      CPGNeurons<Neuron>::rest(k, [&](typename Neuron::variable var, double x) {
+        network.set(k, var, x);
+      });
+    }
+  }
+
+  // Aplica (o quita) el drive tónico a las 4 neuronas
+  void set_drive(bool on) {
+    for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+      network.set_input(n, on ? m_params.drive(n) : 0.0);
+    }
+  }
+
+  // Drive del paso k de la rejilla de paso h, como LymnaeaCPG
+  void stimulate(long k, double h) { set_drive(m_drive.on(k, h) != 0.0); }
+
+  // Paso k de toda la red, de k h a (k + 1) h
+  template <typename Integrator = RungeKutta4> void step(long k, double h) {
+    stimulate(k, h);
+    network.template step<Integrator>(h);
+  }
+
+  Precission v(int neuron) const { return network.get(neuron, Neuron::v); }
+
+  // Punto de reposo de toda la red con o sin el drive
+  SteadyStateResult steady_state(bool drive = false,
+                                 const SteadyStateOptions &options = SteadyStateOptions()) {
+    set_drive(drive);
+    return SteadyState::solve(network, network.variables(), network.parameters(), options);
+  }
+
+  // Estado con los nombres y el formato de LymnaeaCPG::save, para
+  // restaurarlo en la red por objetos
+  void save(Checkpoint &state) const {
+    typedef typename LymnaeaCPG<RungeKutta4, Precission>::Synapse Synapse;
+    for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+      std::vector<double> values(Neuron::n_variables);
+      for (std::size_t var = 0; var < Neuron::n_variables; ++var) {
+        values[var] = network.get(k, static_cast<typename Neuron::variable>(var));
+      }
+      state.save(CPGParameters::neuron_name(k), std::move(values));
+    }
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      std::vector<double> values(Synapse::n_variables);
+      values[Synapse::r] = network.get_synapse(s, Network::r);
+      values[Synapse::s] = network.get_synapse(s, Network::s);
+      values[Synapse::i] = network.current(s);
+      state.save(CPGParameters::synapse_name(s), std::move(values));
+    }
+  }
+
+  const CPGParameters &parameters() const { return m_params; }
+
+private:
+  std::array<typename Neuron::ConstructorArgs, CPGParameters::n_neurons> m_neuron_args;
+
+  std::array<typename Neuron::ConstructorArgs, CPGParameters::n_neurons> &neuron_args() {
+    for (int k = 0; k < CPGParameters::n_neurons; ++k) {
+      CPGNeurons<Neuron>::args(k, m_neuron_args[k]);
+    }
+    return m_neuron_args;
+  }
+
+  static std::array<typename Network::SynapseArgs, CPGParameters::n_synapses>
+  synapse_args(const CPGParameters &p) {
+    std::array<typename Network::SynapseArgs, CPGParameters::n_synapses> syn;
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      syn[s] = {static_cast<std::size_t>(CPGParameters::synapse_pre(s)),
+                static_cast<std::size_t>(CPGParameters::synapse_post(s)),
+                Precission(p.esyn[s]), Precission(p.gsyn[s]), Precission(p.tau_syn[s]),
+                Precission(-40.0), Precission(2.5)};
+    }
+    return syn;
+  }
+
+  CPGParameters m_params;
+  CPGDrive m_drive;
+
+public:
+  Network network;
+};
+
+#endif /* LYMNAEACPG_H_ */
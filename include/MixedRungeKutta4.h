@@ -0,0 +1,73 @@
+/*************************************************************
+ * MixedRungeKutta4.h - RungeKutta4 con estado en float y suma en double
+ *
+ * Con float cada paso de RungeKutta4 redondea x + h dx a 24 bits: con
+ * h = 0.01 ms el incremento de una compuerta lenta (tau_q = 400 ms en
+ * N3t) es del orden del épsilon de float y se pierde en parte en cada
+ * paso. MixedRungeKutta4 evalúa el modelo en la precisión del sistema
+ * (float) pero lleva la suma de los pasos en double.
+ *
+ * El estado en double es del objeto integrado y se pasa junto a vars:
+ *
+ *   MixedRungeKutta4::step(system, h, vars, params, state);
+ *
+ * vars sólo ve el redondeo a float de state. Si vars ya no es ese
+ * redondeo (lo ha cambiado set(), SteadyState o un Checkpoint) se
+ * vuelve a partir del valor de vars. FusedNetwork en float guarda
+ * state junto a su vector de estado, así que basta con
+ *
+ *   FusedLymnaeaCPG<float> cpg;
+ *   cpg.step<MixedRungeKutta4>(k, 0.01);
+ *
+ * No sirve como Integrator de los DifferentialNeuronWrapper de Neun,
+ * que no tienen dónde guardar el estado en double.
+ *
+ *************************************************************/
+
+#ifndef MIXEDRUNGEKUTTA4_H_
+#define MIXEDRUNGEKUTTA4_H_
+
+#include <cstddef>
+#include <type_traits>
+
+class MixedRungeKutta4 {
+public:
+  typedef double accumulator_t;
+
+  template <typename System>
+  static void step(System &system, double h, typename System::precission_t *const vars,
+                   typename System::precission_t *const params, accumulator_t *const state) {
+    typedef typename System::precission_t T;
+    typedef accumulator_t A;
+    static_assert(std::is_floating_point_v<T>, "MixedRungeKutta4 necesita un sistema escalar");
+    constexpr std::size_t n = System::n_variables;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (T(state[i]) != vars[i]) {
+        state[i] = vars[i];
+      }
+    }
+
+    const A dt = h;
+    T k1[n], k2[n], k3[n], k4[n], aux[n];
+    system.eval(vars, params, k1);
+    for (std::size_t i = 0; i < n; ++i) {
+      aux[i] = T(state[i] + A(0.5) * dt * k1[i]);
+    }
+    system.eval(aux, params, k2);
+    for (std::size_t i = 0; i < n; ++i) {
+      aux[i] = T(state[i] + A(0.5) * dt * k2[i]);
+    }
+    system.eval(aux, params, k3);
+    for (std::size_t i = 0; i < n; ++i) {
+      aux[i] = T(state[i] + dt * k3[i]);
+    }
+    system.eval(aux, params, k4);
+    for (std::size_t i = 0; i < n; ++i) {
+      state[i] += dt / A(6) * (A(k1[i]) + A(2) * k2[i] + A(2) * k3[i] + A(k4[i]));
+      vars[i] = T(state[i]);
+    }
+  }
+};
+
+#endif /* MIXEDRUNGEKUTTA4_H_ */
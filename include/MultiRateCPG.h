@@ -0,0 +1,227 @@
+/*************************************************************
+ * MultiRateCPG.h - CPG con un paso distinto para cada componente
+ *
+ * En LymnaeaCPG todo avanza con el mismo paso h, aunque SO y las
+ * sinapsis lentas (tau_syn = 200 ms) cambian mucho más despacio que
+ * las corrientes de los spikes de N1M y N2v. MultiRateCPG integra cada
+ * neurona y cada sinapsis con su propio paso, un múltiplo entero
+ * (stride) del paso base h:
+ *
+ *   MultiRateOptions options = MultiRateOptions::slow(params, 2, 10);
+ *   MultiRateCPG<> net(params, options);
+ *   for (long k = 0; k < steps; ++k) {
+ *     net.step(k, h);
+ *   }
+ *
+ * Un componente de stride m avanza m h en el último paso base de cada
+ * ventana de m pasos ((k + 1) % m == 0), de modo que tras ese paso
+ * está en el mismo instante que los demás. Entre dos pasos suyos:
+ *
+ *   - una sinapsis lenta no suma su corriente a la neurona
+ *     postsináptica; la suma MultiRateCPG con s extrapolada
+ *     linealmente desde sus dos últimos pasos y el voltaje actual de
+ *     la postsináptica: I = g_syn s (V_post - E_syn)
+ *   - una neurona lenta acumula las corrientes de cada paso base y
+ *     avanza con su media en la ventana
+ *   - quien lee el voltaje de una neurona lenta ve el de su último
+ *     paso
+ *
+ * Control de error: cuando una sinapsis lenta avanza, su s real se
+ * compara con la extrapolada y la diferencia se pasa a corriente con
+ * el voltaje postsináptico. El mayor error de cada sinapsis se guarda
+ * en statistics(); si pasa de options.tolerance se cuenta como
+ * violación y, con options.strict, step() lanza std::runtime_error.
+ *
+ * Con todos los strides a 1 el resultado es idéntico al de
+ * LymnaeaCPG::step.
+ *
+ *************************************************************/
+
+#ifndef MULTIRATECPG_H_
+#define MULTIRATECPG_H_
+
+#include <LymnaeaCPG.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+struct MultiRateOptions {
+  int neuron_stride[CPGParameters::n_neurons] = {1, 1, 1, 1};
+  int synapse_stride[CPGParameters::n_synapses] = {1, 1, 1, 1, 1, 1, 1, 1};
+  double tolerance = 0.05;  // Error máximo de la corriente extrapolada
+  bool strict = false;
+
+  // SO con stride so y las sinapsis con tau_syn >= tau con stride synapses
+  static MultiRateOptions slow(const CPGParameters &params, int so, int synapses,
+                               double tau = 200.0) {
+    MultiRateOptions options;
+    options.neuron_stride[CPGParameters::SO] = so;
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      if (params.tau_syn[s] >= tau) {
+        options.synapse_stride[s] = synapses;
+      }
+    }
+    return options;
+  }
+};
+
+struct MultiRateStatistics {
+  long base_steps = 0;
+  long neuron_steps[CPGParameters::n_neurons] = {};
+  long synapse_steps[CPGParameters::n_synapses] = {};
+  double max_error[CPGParameters::n_synapses] = {};  // Corriente extrapolada - real
+  long violations = 0;
+
+  // Pasos de componente frente a los de todo el CPG al paso base
+  double work() const {
+    long steps = 0;
+    for (long n : neuron_steps) {
+      steps += n;
+    }
+    for (long s : synapse_steps) {
+      steps += s;
+    }
+    const long components = int(CPGParameters::n_neurons) + int(CPGParameters::n_synapses);
+    return base_steps ? double(steps) / (double(base_steps) * components) : 1.0;
+  }
+};
+
+template <typename Integrator = RungeKutta4, typename Precission = double>
+class MultiRateCPG {
+public:
+  typedef LymnaeaCPG<Integrator, Precission> CPG;
+  typedef typename CPG::Neuron Neuron;
+  typedef typename CPG::Synapse Synapse;
+
+  explicit MultiRateCPG(const CPGParameters &params = CPGParameters(),
+                        const MultiRateOptions &options = MultiRateOptions())
+      : cpg(params), m_options(options), m_drive(params),
+        m_neurons{&cpg.n1m, &cpg.n2v, &cpg.n3t, &cpg.so},
+        m_synapses{&cpg.s_n1m_n2v, &cpg.s_n2v_n1m, &cpg.s_n1m_n3t, &cpg.s_n3t_n1m,
+                   &cpg.s_n2v_n3t, &cpg.s_n2v_so,  &cpg.s_so_n1m,  &cpg.s_so_n2v} {
+    for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+      check_stride(options.neuron_stride[n], CPGParameters::neuron_name(n));
+    }
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      check_stride(options.synapse_stride[s], CPGParameters::synapse_name(s));
+    }
+    reset_coupling();
+  }
+
+  // Paso base k: avanza de k h a (k + 1) h
+  void step(long k, double h) {
+    const CPGParameters &p = cpg.parameters();
+    const double time = k * h;
+    double added[CPGParameters::n_neurons] = {};
+
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      const int m = m_options.synapse_stride[s];
+      const int post = CPGParameters::synapse_post(s);
+      Coupling &c = m_coupling[s];
+      if ((k + 1) % m == 0) {
+        m_synapses[s]->step(Precission(m * h));
+        const double s_now = m_synapses[s]->get(Synapse::s);
+        if (m > 1) {
+          check_error(s, k, time, s_now);
+        }
+        c.s_prev = c.s_last;
+        c.s_last = s_now;
+        c.k_last = k;
+        ++m_statistics.synapse_steps[s];
+        added[post] += m_synapses[s]->get(Synapse::i);
+      } else {
+        const double I = current(s, predict(s, k));
+        m_neurons[post]->add_synaptic_input(Precission(I));
+        added[post] += I;
+      }
+    }
+
+    if (m_drive.on(k, h) != 0.0) {
+      for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+        m_neurons[n]->add_synaptic_input(Precission(p.drive(n)));
+        added[n] += p.drive(n);
+      }
+    }
+
+    for (int n = 0; n < CPGParameters::n_neurons; ++n) {
+      const int m = m_options.neuron_stride[n];
+      m_window[n] += added[n];
+      if ((k + 1) % m != 0) {
+        continue;
+      }
+      // Lleva la entrada acumulada en la ventana a su media
+      if (m > 1) {
+        m_neurons[n]->add_synaptic_input(Precission(m_window[n] * (1.0 / m - 1.0)));
+      }
+      m_neurons[n]->step(Precission(m * h));
+      m_window[n] = 0.0;
+      ++m_statistics.neuron_steps[n];
+    }
+    ++m_statistics.base_steps;
+  }
+
+  // Tras cambiar el estado de las sinapsis (Checkpoint, SteadyState)
+  void reset_coupling() {
+    for (int s = 0; s < CPGParameters::n_synapses; ++s) {
+      const double x = m_synapses[s]->get(Synapse::s);
+      m_coupling[s] = {x, x, -1};
+    }
+    for (double &w : m_window) {
+      w = 0.0;
+    }
+  }
+
+  const MultiRateOptions &options() const { return m_options; }
+  const MultiRateStatistics &statistics() const { return m_statistics; }
+
+  CPG cpg;
+
+private:
+  struct Coupling {
+    double s_last, s_prev;  // s en los dos últimos pasos de la sinapsis
+    long k_last;            // Paso base del último
+  };
+
+  static void check_stride(int stride, const char *name) {
+    if (stride < 1) {
+      throw std::invalid_argument(std::string("MultiRateCPG: stride de ") + name + " < 1");
+    }
+  }
+
+  // s en el paso base k, extrapolada desde los dos últimos pasos
+  double predict(int s, long k) const {
+    const Coupling &c = m_coupling[s];
+    return c.s_last + (c.s_last - c.s_prev) * double(k - c.k_last) / m_options.synapse_stride[s];
+  }
+
+  // Corriente de la sinapsis con s dada y el voltaje postsináptico actual
+  double current(int s, double x) const {
+    const CPGParameters &p = cpg.parameters();
+    const double v_post = m_neurons[CPGParameters::synapse_post(s)]->get(Neuron::v);
+    return p.gsyn[s] * x * (v_post - p.esyn[s]);
+  }
+
+  void check_error(int s, long k, double time, double s_now) {
+    const double error = std::fabs(current(s, s_now) - current(s, predict(s, k)));
+    m_statistics.max_error[s] = std::max(m_statistics.max_error[s], error);
+    if (error > m_options.tolerance) {
+      ++m_statistics.violations;
+      if (m_options.strict) {
+        throw std::runtime_error(std::string("MultiRateCPG: error de ") + std::to_string(error) +
+                                 " en " + CPGParameters::synapse_name(s) + " a t = " +
+                                 std::to_string(time) + " ms");
+      }
+    }
+  }
+
+  MultiRateOptions m_options;
+  CPGDrive m_drive;
+  MultiRateStatistics m_statistics;
+  Neuron *m_neurons[CPGParameters::n_neurons];
+  Synapse *m_synapses[CPGParameters::n_synapses];
+  Coupling m_coupling[CPGParameters::n_synapses];
+  double m_window[CPGParameters::n_neurons] = {};
+};
+
+#endif /* MULTIRATECPG_H_ */
@@ -0,0 +1,135 @@
+/*************************************************************
+ * NeuronEnsemble.h - Conjunto de neuronas integrado por lotes SIMD
+ *
+ * Agrupa muchas neuronas del mismo modelo (por ejemplo variantes de
+ * N1M/N2v/N3t/SO con distintos tau_p, g_eca o drive) en lotes de W
+ * neuronas. Cada lote es una única neurona de Neun instanciada con
+ * Lanes<Precission, W> como precisión, de modo que las variables de
+ * estado y los parámetros se guardan como arrays de W carriles y las
+ * etapas del integrador (RungeKutta4 u otro) avanzan W neuronas con
+ * cada instrucción vectorial.
+ *
+ * Si el modelo tiene un parámetro selector (n_type en VavoulisModel)
+ * se indica en el constructor y las neuronas se agrupan por su valor,
+ * porque todos los carriles de un lote deben seguir la misma rama del
+ * modelo. Los huecos del último lote de cada grupo se rellenan con
+ * copias de la última neurona y no se observan desde fuera.
+ *
+ *   NeuronEnsemble<VavoulisModel> ensemble(args, Neuron::n_type);
+ *   ensemble.add_synaptic_input(i, -6.0);
+ *   ensemble.step(0.01);
+ *   ensemble.get(i, Neuron::v);
+ *
+ *************************************************************/
+
+#ifndef NEURONENSEMBLE_H_
+#define NEURONENSEMBLE_H_
+
+#include <DifferentialNeuronWrapper.h>
+#include <RungeKutta4.h>
+#include <SimdLanes.h>
+#include <SystemWrapper.h>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+template <template <typename> class Model, typename Integrator = RungeKutta4,
+          typename Precission = double, int W = SIMD_DEFAULT_LANES>
+class NeuronEnsemble {
+public:
+  typedef Lanes<Precission, W> lanes_t;
+  typedef DifferentialNeuronWrapper<SystemWrapper<Model<Precission>>, Integrator> Neuron;
+  typedef DifferentialNeuronWrapper<SystemWrapper<Model<lanes_t>>, Integrator> Batch;
+  typedef typename Neuron::ConstructorArgs ConstructorArgs;
+  typedef typename Neuron::variable variable;
+
+  static constexpr int width = W;
+
+  NeuronEnsemble(const std::vector<ConstructorArgs> &args, int selector = -1)
+      : m_slots(args.size()) {
+    // Orden estable por el parámetro selector para no mezclar ramas
+    std::vector<std::size_t> order(args.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+      order[i] = i;
+    }
+    if (selector >= 0) {
+      std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+        return args[a].params[selector] < args[b].params[selector];
+      });
+    }
+
+    std::size_t k = 0;
+    while (k < order.size()) {
+      std::size_t end = k + 1;
+      while (end < order.size() && end - k < static_cast<std::size_t>(W) &&
+             (selector < 0 || args[order[end]].params[selector] ==
+                                  args[order[k]].params[selector])) {
+        ++end;
+      }
+
+      typename Batch::ConstructorArgs batch_args;
+      for (int l = 0; l < W; ++l) {
+        std::size_t i = order[std::min(k + l, end - 1)];
+        for (int p = 0; p < Neuron::n_parameters; ++p) {
+          batch_args.params[p].set(l, args[i].params[p]);
+        }
+      }
+      m_batches.emplace_back(batch_args);
+
+      for (std::size_t l = 0; k + l < end; ++l) {
+        m_slots[order[k + l]] = {m_batches.size() - 1, static_cast<int>(l)};
+      }
+      k = end;
+    }
+
+    m_inputs.assign(m_batches.size(), lanes_t(0));
+  }
+
+  std::size_t size() const { return m_slots.size(); }
+  std::size_t batches() const { return m_batches.size(); }
+
+  void set(std::size_t i, variable var, Precission value) {
+    Batch &batch = m_batches[m_slots[i].batch];
+    auto v = static_cast<typename Batch::variable>(var);
+    lanes_t x = batch.get(v);
+    x.set(m_slots[i].lane, value);
+    batch.set(v, x);
+  }
+
+  // Fija la misma variable en todas las neuronas (y en los huecos)
+  void set_all(variable var, Precission value) {
+    for (Batch &batch : m_batches) {
+      batch.set(static_cast<typename Batch::variable>(var), lanes_t(value));
+    }
+  }
+
+  Precission get(std::size_t i, variable var) const {
+    const Batch &batch = m_batches[m_slots[i].batch];
+    return batch.get(static_cast<typename Batch::variable>(var))[m_slots[i].lane];
+  }
+
+  void add_synaptic_input(std::size_t i, Precission x) {
+    lanes_t &input = m_inputs[m_slots[i].batch];
+    input.set(m_slots[i].lane, input[m_slots[i].lane] + x);
+  }
+
+  void step(Precission h) {
+    for (std::size_t b = 0; b < m_batches.size(); ++b) {
+      m_batches[b].add_synaptic_input(m_inputs[b]);
+      m_inputs[b] = lanes_t(0);
+      m_batches[b].step(lanes_t(h));
+    }
+  }
+
+private:
+  struct Slot {
+    std::size_t batch;
+    int lane;
+  };
+
+  std::vector<Slot> m_slots;
+  std::vector<Batch> m_batches;
+  std::vector<lanes_t> m_inputs;
+};
+
+#endif /* NEURONENSEMBLE_H_ */
@@ -0,0 +1,90 @@
+/*************************************************************
+ * NoiseCurrent.h - Corrientes de ruido reproducibles por ensayo
+ *
+ * Corriente ruidosa para sumar al drive de una neurona, sobre la
+ * rejilla de pasos k (t = k h) como Stimulus, con los números de un
+ * Philox (Philox.h) cuya clave es la semilla y cuyo flujo es el par
+ * (ensayo, fuente). El ruido del ensayo 17 es el mismo lo corra el
+ * hilo que lo corra y con cualquier número de hilos.
+ *
+ *   NoiseCurrent noise(NoiseCurrent::ou, 0.5, 5.0, step, Philox(seed, trial, neuron));
+ *   for (long k = 0; k < steps; ++k) {
+ *     n.add_synaptic_input(drive + noise.current(k));
+ *     n.step(step);
+ *   }
+ *
+ * Tipos:
+ *
+ *   white  gaussiana independiente en cada paso, de desviación sd
+ *          (como StimulusProtocol::noise). Su efecto depende de h.
+ *   ou     Ornstein-Uhlenbeck de desviación estacionaria sd y tiempo
+ *          de correlación tau (ms), avanzado con su solución exacta
+ *            x_{k+1} = x_k a + sd sqrt(1 - a^2) g_k,  a = exp(-h / tau)
+ *          y empezando en la distribución estacionaria, así que su
+ *          estadística no depende de h.
+ *
+ * current(k) de white sólo depende de k. La de ou se calcula en orden:
+ * pedir un k anterior al último vuelve a generar desde k = 0.
+ *
+ *************************************************************/
+
+#ifndef NOISECURRENT_H_
+#define NOISECURRENT_H_
+
+#include <Philox.h>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+class NoiseCurrent {
+public:
+  enum kind { white, ou };
+
+  NoiseCurrent(kind type, double sd, double tau, double h, const Philox &rng, double mean = 0.0)
+      : m_type(type), m_sd(sd), m_mean(mean), m_rng(rng) {
+    if (!(h > 0) || !(sd >= 0) || (type == ou && !(tau > 0))) {
+      throw std::invalid_argument("NoiseCurrent: sd, tau o paso no válidos");
+    }
+    m_a = type == ou ? std::exp(-h / tau) : 0.0;
+    m_b = std::sqrt(1.0 - m_a * m_a);
+    restart();
+  }
+
+  static kind parse(const std::string &name) {
+    if (name == "white") {
+      return white;
+    }
+    if (name == "ou") {
+      return ou;
+    }
+    throw std::invalid_argument("Tipo de ruido no válido: " + name);
+  }
+
+  double current(long k) {
+    if (m_type == white) {
+      return m_mean + m_sd * m_rng.normal(k);
+    }
+    if (k < m_k) {
+      restart();
+    }
+    while (m_k < k) {
+      m_x = m_x * m_a + m_sd * m_b * m_rng.normal(m_k + 1);
+      ++m_k;
+    }
+    return m_mean + m_x;
+  }
+
+private:
+  void restart() {
+    m_k = 0;
+    m_x = m_sd * m_rng.normal(0);
+  }
+
+  kind m_type;
+  double m_sd, m_mean, m_a, m_b;
+  Philox m_rng;
+  long m_k;
+  double m_x;
+};
+
+#endif /* NOISECURRENT_H_ */
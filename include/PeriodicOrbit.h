@@ -0,0 +1,413 @@
+/*************************************************************
+ * PeriodicOrbit.h - Órbitas periódicas por disparo (shooting)
+ *
+ * En lugar de integrar un transitorio largo y esperar a que el ritmo
+ * se asiente, PeriodicOrbit busca directamente el punto x0 y el
+ * periodo T de la órbita periódica: los ceros de
+ *
+ *   r(x0, T) = phi_T(x0) - x0
+ *
+ * donde phi_T es el flujo del sistema durante T, integrado con el
+ * integrador de Neun (RungeKutta4 por defecto) en pasos iguales de
+ * como mucho options.h. Como la órbita es una curva, una variable de
+ * x0 (options.section, por ejemplo el voltaje de N1M en su umbral) se
+ * fija y su lugar en las incógnitas lo ocupa T. Newton usa la matriz
+ * de monodromía M = d phi_T / d x0 por diferencias finitas (una
+ * integración por columna, repartidas entre options.threads hilos) y
+ * d phi_T / dT = f(phi_T(x0)):
+ *
+ *   PeriodicOrbitResult orbit =
+ *       PeriodicOrbit::solve(net, net.parameters(), x0, 3000.0, options);
+ *
+ * Vale para cualquier sistema con el contrato de los integradores
+ * (precission_t, n_variables, eval(vars, params, incs)), como
+ * FusedNetwork o una neurona, igual que SteadyState::solve. El eval de
+ * FusedNetwork y de las neuronas de Neun escribe la entrada en el
+ * sistema, así que cada columna integra su propia copia: el sistema
+ * tiene que poder copiarse y params no se modifica.
+ *
+ * x0 y T iniciales tienen que estar cerca de la órbita: el cruce y el
+ * periodo de LimitCycleMonitor tras unos ciclos, o la órbita de un
+ * valor cercano del parámetro en una continuación.
+ *
+ * Un punto fijo (f(x0) = 0) cumple r = 0 con cualquier T; si Newton
+ * acaba en uno, el resultado no se da por convergido.
+ *
+ * Al converger, los autovalores de M son los multiplicadores de
+ * Floquet: uno es 1 (la dirección del flujo) y la órbita es estable si
+ * los demás tienen módulo < 1. Se calculan con reducción a Hessenberg
+ * por reflexiones de Householder e iteración QR compleja con el
+ * desplazamiento de Wilkinson.
+ *
+ *************************************************************/
+
+#ifndef PERIODICORBIT_H_
+#define PERIODICORBIT_H_
+
+#include <RungeKutta4.h>
+#include <SteadyState.h>
+#include <WorkStealingPool.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+struct PeriodicOrbitOptions {
+  double h = 0.01;            // Paso máximo de integración (ms)
+  double tolerance = 1e-7;    // max |phi_T(x0) - x0| / (1 + |x0|)
+  int max_iterations = 20;
+  std::size_t section = 0;    // Variable de x0 que se mantiene fija
+  unsigned threads = 1;       // Hilos para las columnas de M
+};
+
+struct PeriodicOrbitResult {
+  bool converged = false;
+  int iterations = 0;
+  double residual = NAN;
+  double period = NAN;
+  std::vector<double> x0;
+  std::vector<std::complex<double>> multipliers;  // De mayor a menor módulo
+
+  // Mayor módulo de los multiplicadores sin contar el más cercano a 1
+  double max_multiplier() const {
+    std::size_t trivial = 0;
+    for (std::size_t i = 1; i < multipliers.size(); ++i) {
+      if (std::abs(multipliers[i] - 1.0) < std::abs(multipliers[trivial] - 1.0)) {
+        trivial = i;
+      }
+    }
+    double max = 0.0;
+    for (std::size_t i = 0; i < multipliers.size(); ++i) {
+      if (i != trivial) {
+        max = std::max(max, std::abs(multipliers[i]));
+      }
+    }
+    return max;
+  }
+
+  bool stable() const { return converged && max_multiplier() < 1.0; }
+};
+
+class PeriodicOrbit {
+public:
+  typedef PeriodicOrbitOptions Options;
+  typedef PeriodicOrbitResult Result;
+
+  // x <- phi_T(x) en pasos iguales de como mucho h
+  template <typename Integrator = RungeKutta4, typename System>
+  static void flow(System &system, typename System::precission_t *const params,
+                   std::vector<double> &x, double period, double h) {
+    typedef typename System::precission_t T;
+    const long steps = std::max(1L, static_cast<long>(std::ceil(period / h - 1e-9)));
+    const T dt = T(period / steps);
+    T vars[System::n_variables];
+    for (std::size_t i = 0; i < System::n_variables; ++i) {
+      vars[i] = T(x[i]);
+    }
+    for (long k = 0; k < steps; ++k) {
+      Integrator::step(system, dt, vars, params);
+    }
+    for (std::size_t i = 0; i < System::n_variables; ++i) {
+      x[i] = double(vars[i]);
+    }
+  }
+
+  template <typename Integrator = RungeKutta4, typename System>
+  static Result solve(System &system, typename System::precission_t *const params,
+                      std::vector<double> x0, double period,
+                      const Options &options = Options()) {
+    typedef typename System::precission_t T;
+    const std::size_t n = System::n_variables;
+    const std::size_t p = options.section;
+    if (x0.size() != n || p >= n || !(period > 0)) {
+      throw std::invalid_argument("PeriodicOrbit: estado, sección o periodo no válidos");
+    }
+    WorkStealingPool pool(std::max(1u, options.threads));
+    const double eps = std::sqrt(double(std::numeric_limits<T>::epsilon()));
+
+    // phi_T(x) y el residuo escalado
+    auto shoot = [&](const std::vector<double> &x, double T_, std::vector<double> &end) {
+      end = x;
+      flow<Integrator>(system, params, end, T_, options.h);
+      double norm = 0.0;
+      for (std::size_t i = 0; i < n; ++i) {
+        // Un flujo que diverge (NaN) no debe parecer un residuo pequeño
+        const double d = std::fabs(end[i] - x[i]) / (1.0 + std::fabs(x[i]));
+        norm = d <= norm ? norm : d;
+      }
+      return std::isfinite(norm) ? norm : std::numeric_limits<double>::infinity();
+    };
+
+    Result result;
+    std::vector<double> end(n), trial(n), trial_end(n), A(n * n), dz(n), f(n);
+    std::vector<double> M(n * n);
+    result.residual = shoot(x0, period, end);
+    for (;;) {
+      // Monodromía por diferencias hacia delante, una columna por tarea
+      pool.parallel_for(n, [&](std::size_t j) {
+        System copy = system;
+        std::vector<double> x = x0;
+        const double dx = eps * std::max(1.0, std::fabs(x[j]));
+        x[j] += dx;
+        flow<Integrator>(copy, params, x, period, options.h);
+        for (std::size_t i = 0; i < n; ++i) {
+          M[i * n + j] = (x[i] - end[i]) / dx;
+        }
+      });
+      if (result.residual <= options.tolerance || result.iterations >= options.max_iterations) {
+        break;
+      }
+      ++result.iterations;
+
+      // [M - I con la columna p sustituida por f(phi_T(x0))] dz = -r
+      std::vector<T> xt(n), ft(n);
+      for (std::size_t i = 0; i < n; ++i) {
+        xt[i] = T(end[i]);
+      }
+      system.eval(xt.data(), params, ft.data());
+      for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+          A[i * n + j] = M[i * n + j] - (i == j ? 1.0 : 0.0);
+        }
+        A[i * n + p] = double(ft[i]);
+        dz[i] = x0[i] - end[i];
+      }
+      if (!SteadyState::gauss(A, dz, n)) {
+        break;
+      }
+
+      // Paso de Newton acortado mientras no baje el residuo
+      double lambda = 1.0, residual = INFINITY, trial_period = period;
+      for (int halvings = 0; halvings < 8; ++halvings, lambda /= 2) {
+        trial = x0;
+        for (std::size_t i = 0; i < n; ++i) {
+          if (i != p) {
+            trial[i] += lambda * dz[i];
+          }
+        }
+        trial_period = period + lambda * dz[p];
+        if (!(trial_period > 0)) {
+          continue;
+        }
+        residual = shoot(trial, trial_period, trial_end);
+        if (residual < result.residual) {
+          break;
+        }
+      }
+      if (!(residual < result.residual)) {
+        break;
+      }
+      x0.swap(trial);
+      end.swap(trial_end);
+      period = trial_period;
+      result.residual = residual;
+    }
+
+    // Un punto fijo es una "órbita" de cualquier periodo: no cuenta
+    std::vector<T> xt(n), ft(n);
+    for (std::size_t i = 0; i < n; ++i) {
+      xt[i] = T(x0[i]);
+    }
+    system.eval(xt.data(), params, ft.data());
+    double speed = 0.0;
+    for (std::size_t i = 0; i < n; ++i) {
+      speed = std::max(speed, std::fabs(double(ft[i])) * period / (1.0 + std::fabs(x0[i])));
+    }
+    result.converged = result.residual <= options.tolerance && speed > 1e3 * options.tolerance;
+    result.period = period;
+    result.x0 = x0;
+    result.multipliers = eigenvalues(M, n);
+    std::sort(result.multipliers.begin(), result.multipliers.end(),
+              [](const std::complex<double> &a, const std::complex<double> &b) {
+                return std::abs(a) > std::abs(b);
+              });
+    return result;
+  }
+
+  // Autovalores de una matriz real n x n (por filas)
+  // (NaN si la matriz no es finita, como la de un flujo que diverge)
+  static std::vector<std::complex<double>> eigenvalues(std::vector<double> a, std::size_t n) {
+    for (double x : a) {
+      if (!std::isfinite(x)) {
+        return std::vector<std::complex<double>>(n, complex(NAN, NAN));
+      }
+    }
+    equilibrate(a, n);
+    householder(a, n);
+    return qr(std::vector<std::complex<double>>(a.begin(), a.end()), n);
+  }
+
+private:
+  typedef std::complex<double> complex;
+
+  // D^-1 A D con D diagonal de potencias de 2 (no cambia los autovalores
+  // ni introduce redondeo) hasta que cada fila y su columna tienen
+  // normas parecidas: la monodromía mezcla voltajes y compuertas
+  static void equilibrate(std::vector<double> &a, std::size_t n) {
+    for (int sweep = 0; sweep < 64; ++sweep) {
+      bool changed = false;
+      for (std::size_t i = 0; i < n; ++i) {
+        double row = 0.0, column = 0.0;
+        for (std::size_t j = 0; j < n; ++j) {
+          if (j != i) {
+            row += std::fabs(a[i * n + j]);
+            column += std::fabs(a[j * n + i]);
+          }
+        }
+        if (row == 0.0 || column == 0.0) {
+          continue;
+        }
+        // Con d = sqrt(row / column) las dos normas pasan a sqrt(row column)
+        const int e = static_cast<int>(std::lround(0.5 * std::log2(row / column)));
+        const double d = std::ldexp(1.0, e);
+        if (e == 0 || column * d + row / d >= 0.95 * (column + row)) {
+          continue;
+        }
+        for (std::size_t j = 0; j < n; ++j) {
+          a[i * n + j] /= d;
+          a[j * n + i] *= d;
+        }
+        changed = true;
+      }
+      if (!changed) {
+        break;
+      }
+    }
+  }
+
+  // Semejanza a Hessenberg superior con reflexiones P = I - 2 v v^T / v^T v
+  // que anulan la columna k bajo la subdiagonal
+  static void householder(std::vector<double> &a, std::size_t n) {
+    std::vector<double> v(n);
+    for (std::size_t k = 0; k + 2 < n; ++k) {
+      const std::size_t m = n - k - 1;  // Filas k + 1 .. n - 1
+      double norm = 0.0;
+      for (std::size_t i = 0; i < m; ++i) {
+        v[i] = a[(k + 1 + i) * n + k];
+        norm = std::hypot(norm, v[i]);
+      }
+      if (norm == 0.0) {
+        continue;
+      }
+      // Signo contrario al de v[0] para no restar números parecidos
+      v[0] += v[0] < 0.0 ? -norm : norm;
+      double vv = 0.0;
+      for (std::size_t i = 0; i < m; ++i) {
+        vv += v[i] * v[i];
+      }
+      // P A: filas k + 1 .. n - 1
+      for (std::size_t j = k; j < n; ++j) {
+        double dot = 0.0;
+        for (std::size_t i = 0; i < m; ++i) {
+          dot += v[i] * a[(k + 1 + i) * n + j];
+        }
+        dot *= 2.0 / vv;
+        for (std::size_t i = 0; i < m; ++i) {
+          a[(k + 1 + i) * n + j] -= dot * v[i];
+        }
+      }
+      // (P A) P: columnas k + 1 .. n - 1
+      for (std::size_t i = 0; i < n; ++i) {
+        double dot = 0.0;
+        for (std::size_t j = 0; j < m; ++j) {
+          dot += a[i * n + k + 1 + j] * v[j];
+        }
+        dot *= 2.0 / vv;
+        for (std::size_t j = 0; j < m; ++j) {
+          a[i * n + k + 1 + j] -= dot * v[j];
+        }
+      }
+      for (std::size_t i = 1; i < m; ++i) {
+        a[(k + 1 + i) * n + k] = 0.0;
+      }
+    }
+  }
+
+  // Iteración QR compleja sobre la matriz de Hessenberg h: en cada paso
+  // H - mu I = Q R y H <- R Q + mu I en el bloque activo [lo, hi], con
+  // rotaciones de Givens y el desplazamiento de Wilkinson (el autovalor
+  // del bloque 2 x 2 final más cercano a H(hi, hi)). Cuando la
+  // subdiagonal H(hi, hi - 1) se hace despreciable, H(hi, hi) es un
+  // autovalor y el bloque se acorta
+  static std::vector<complex> qr(std::vector<complex> h, std::size_t size) {
+    const int n = static_cast<int>(size);
+    auto H = [&](int i, int j) -> complex & { return h[i * size + j]; };
+    const double eps = std::numeric_limits<double>::epsilon();
+    double norm = 0.0;
+    for (const complex &x : h) {
+      norm = std::max(norm, std::abs(x));
+    }
+
+    std::vector<complex> w(size), c(size), s(size);
+    int hi = n - 1, iterations = 0;
+    while (hi >= 0) {
+      // Inicio del bloque: la subdiagonal más baja despreciable
+      int lo = hi;
+      for (; lo > 0; --lo) {
+        double scale = std::abs(H(lo, lo)) + std::abs(H(lo - 1, lo - 1));
+        if (scale == 0.0) {
+          scale = norm;
+        }
+        if (std::abs(H(lo, lo - 1)) <= eps * scale) {
+          H(lo, lo - 1) = 0.0;
+          break;
+        }
+      }
+      if (lo == hi) {
+        w[hi] = H(hi, hi);
+        --hi;
+        iterations = 0;
+        continue;
+      }
+      if (++iterations > 100) {
+        throw std::runtime_error("PeriodicOrbit: QR no converge");
+      }
+
+      complex mu;
+      if (iterations % 10 == 0) {
+        // Desplazamiento arbitrario para salir de un ciclo
+        mu = H(hi, hi) + 0.75 * std::abs(H(hi, hi - 1));
+      } else {
+        const complex p = H(hi - 1, hi - 1), q = H(hi - 1, hi);
+        const complex r = H(hi, hi - 1), t = H(hi, hi);
+        const complex half = 0.5 * (p - t);
+        const complex root = std::sqrt(half * half + q * r);
+        const complex mu1 = t + half + root, mu2 = t + half - root;
+        mu = std::abs(mu1 - t) < std::abs(mu2 - t) ? mu1 : mu2;
+      }
+
+      // Q^H (H - mu I) = R fila a fila
+      for (int i = lo; i <= hi; ++i) {
+        H(i, i) -= mu;
+      }
+      for (int k = lo; k < hi; ++k) {
+        const complex x = H(k, k), y = H(k + 1, k);
+        const double r = std::hypot(std::abs(x), std::abs(y));
+        c[k] = r == 0.0 ? complex(1.0) : x / r;
+        s[k] = r == 0.0 ? complex(0.0) : y / r;
+        for (int j = k; j <= hi; ++j) {
+          const complex u = H(k, j), v = H(k + 1, j);
+          H(k, j) = std::conj(c[k]) * u + std::conj(s[k]) * v;
+          H(k + 1, j) = c[k] * v - s[k] * u;
+        }
+      }
+      // R Q columna a columna, que vuelve a ser de Hessenberg
+      for (int k = lo; k < hi; ++k) {
+        for (int i = lo; i <= k + 1; ++i) {
+          const complex u = H(i, k), v = H(i, k + 1);
+          H(i, k) = u * c[k] + v * s[k];
+          H(i, k + 1) = v * std::conj(c[k]) - u * std::conj(s[k]);
+        }
+      }
+      for (int i = lo; i <= hi; ++i) {
+        H(i, i) += mu;
+      }
+    }
+    return w;
+  }
+};
+
+#endif /* PERIODICORBIT_H_ */
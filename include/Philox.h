@@ -0,0 +1,84 @@
+/*************************************************************
+ * Philox.h - Generador aleatorio basado en contador (Philox4x32-10)
+ *
+ * Un generador como std::mt19937_64 tiene estado: el número k depende
+ * de todos los anteriores, así que repartir ensayos entre hilos cambia
+ * los números de cada uno salvo que cada ensayo tenga su propio
+ * generador, sembrado y avanzado en orden. Philox (Salmon et al.
+ * 2011, "Parallel random numbers: as easy as 1, 2, 3") es una función
+ * pura: 10 rondas de multiplicaciones y xor convierten una clave de 64
+ * bits y un contador de 128 bits en 128 bits aleatorios.
+ *
+ *   Philox rng(seed, trial, source);   // clave y flujo
+ *   double u = rng.uniform(k);         // (0, 1)
+ *   double g = rng.normal(k);          // N(0, 1)
+ *
+ * La clave es la semilla; el contador lleva el número k en sus 64 bits
+ * bajos y el ensayo y la fuente (neurona, sinapsis...) en los altos.
+ * El número k de un ensayo no depende de qué hilo lo calcule ni de en
+ * qué orden se pidan, y se puede pedir cualquier k sin generar los
+ * anteriores.
+ *
+ *************************************************************/
+
+#ifndef PHILOX_H_
+#define PHILOX_H_
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+class Philox {
+public:
+  typedef std::array<std::uint32_t, 4> Block;
+
+  explicit Philox(std::uint64_t seed = 0, std::uint32_t trial = 0, std::uint32_t source = 0)
+      : m_key{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)},
+        m_trial(trial), m_source(source) {}
+
+  // Los 128 bits del contador k
+  Block operator()(std::uint64_t k) const {
+    return generate({static_cast<std::uint32_t>(k), static_cast<std::uint32_t>(k >> 32),
+                     m_trial, m_source},
+                    m_key);
+  }
+
+  // Uniforme en (0, 1) con 53 bits
+  double uniform(std::uint64_t k) const {
+    Block x = (*this)(k);
+    return unit(x[0], x[1]);
+  }
+
+  // Gaussiana N(0, 1) por Box-Muller con las dos mitades del bloque
+  double normal(std::uint64_t k) const {
+    Block x = (*this)(k);
+    const double u1 = unit(x[0], x[1]), u2 = unit(x[2], x[3]);
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+  }
+
+  // Philox4x32 con 10 rondas
+  static Block generate(Block counter, std::array<std::uint32_t, 2> key) {
+    for (int round = 0; round < 10; ++round) {
+      const std::uint64_t p0 = std::uint64_t(0xD2511F53u) * counter[0];
+      const std::uint64_t p1 = std::uint64_t(0xCD9E8D57u) * counter[2];
+      counter = {static_cast<std::uint32_t>(p1 >> 32) ^ counter[1] ^ key[0],
+                 static_cast<std::uint32_t>(p1),
+                 static_cast<std::uint32_t>(p0 >> 32) ^ counter[3] ^ key[1],
+                 static_cast<std::uint32_t>(p0)};
+      key[0] += 0x9E3779B9u;
+      key[1] += 0xBB67AE85u;
+    }
+    return counter;
+  }
+
+private:
+  static double unit(std::uint32_t lo, std::uint32_t hi) {
+    const std::uint64_t x = (std::uint64_t(hi) << 32 | lo) >> 11;
+    return (double(x) + 0.5) * 0x1p-53;
+  }
+
+  std::array<std::uint32_t, 2> m_key;
+  std::uint32_t m_trial, m_source;
+};
+
+#endif /* PHILOX_H_ */
@@ -0,0 +1,263 @@
+/*************************************************************
+ * Population.h - Poblaciones grandes con conectividad dispersa
+ *
+ * Los circuitos de los ejemplos declaran cada sinapsis como un objeto
+ * GradualActivationSynapsis con nombre, lo que no escala a cientos de
+ * neuronas por clase. Population integra las neuronas por lotes SIMD
+ * (NeuronEnsemble) y guarda las sinapsis de activación gradual por
+ * tipo en matrices dispersas CSR indexadas por la neurona
+ * presináptica:
+ *
+ *   row[pre] .. row[pre + 1]   sinapsis de pre
+ *   post[j], gsyn[j]           destino y conductancia (estructura de arrays)
+ *
+ * Un tipo de sinapsis (SynapseType) fija E_syn, tau_syn, V_r y
+ * dec_slope; cada conexión sólo añade su destino y su g_syn. Como
+ * r_inf sólo depende de V_pre, todas las sinapsis de un mismo tipo que
+ * salen de una neurona tienen las mismas r y s: el estado se guarda
+ * una vez por neurona presináptica y tipo, no por sinapsis, y el coste
+ * por sinapsis y paso es una suma G[post] += gsyn s[pre] sobre arrays
+ * contiguos. La corriente de cada neurona es entonces
+ *
+ *   I_syn = sum_tipos G_tipo (V_post - E_syn)
+ *
+ * El orden de cada paso es el de cpg_completo.cpp: sinapsis con los
+ * voltajes al principio del paso, corriente sináptica y externa, y
+ * neuronas. Con V_pre fijo durante el paso r y s son lineales y se
+ * avanzan con su solución exacta.
+ *
+ *   Population<VavoulisModel> pop(args, Neuron::n_type);
+ *   pop.connect({-90.0, 50.0}, connections);       // tipo y conexiones
+ *   pop.set_input(i, -6.0);                         // drive
+ *   pop.step(0.01);
+ *
+ * connect_random() genera conexiones de Bernoulli entre dos rangos de
+ * neuronas en tiempo proporcional al número de conexiones.
+ *
+ *************************************************************/
+
+#ifndef POPULATION_H_
+#define POPULATION_H_
+
+#include <NeuronEnsemble.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+struct SynapseType {
+  double esyn, tau_syn;
+  double v_r = -40.0, dec_slope = 2.5;  // Valores de LymnaeaCPG
+};
+
+struct Connection {
+  std::uint32_t pre, post;
+  double gsyn;
+};
+
+// Cada par (pre, post) con pre en [pre_begin, pre_end) y post en
+// [post_begin, post_end) con probabilidad p; se salta de una conexión
+// a la siguiente con una distribución geométrica
+inline void connect_random(std::vector<Connection> &connections, std::uint32_t pre_begin,
+                           std::uint32_t pre_end, std::uint32_t post_begin,
+                           std::uint32_t post_end, double p, double gsyn, std::mt19937_64 &rng) {
+  if (!(p > 0) || pre_end <= pre_begin || post_end <= post_begin) {
+    return;
+  }
+  const std::uint64_t cols = post_end - post_begin;
+  const std::uint64_t pairs = std::uint64_t(pre_end - pre_begin) * cols;
+  auto add = [&](std::uint64_t k) {
+    connections.push_back({static_cast<std::uint32_t>(pre_begin + k / cols),
+                           static_cast<std::uint32_t>(post_begin + k % cols), gsyn});
+  };
+  if (p >= 1.0) {
+    for (std::uint64_t k = 0; k < pairs; ++k) {
+      add(k);
+    }
+    return;
+  }
+  std::geometric_distribution<std::uint64_t> skip(p);
+  for (std::uint64_t k = skip(rng); k < pairs; k += 1 + skip(rng)) {
+    add(k);
+  }
+}
+
+// Sinapsis de un tipo en CSR por neurona presináptica
+template <typename Precission> class SynapseMatrix {
+public:
+  SynapseMatrix(std::size_t neurons, const SynapseType &type,
+                const std::vector<Connection> &connections)
+      : m_type(type), m_row(neurons + 1, 0), m_post(connections.size()),
+        m_gsyn(connections.size()) {
+    if (connections.size() > UINT32_MAX) {
+      throw std::length_error("SynapseMatrix: demasiadas sinapsis");
+    }
+    // Ordenación por recuento de la neurona presináptica
+    for (const Connection &c : connections) {
+      if (c.pre >= neurons || c.post >= neurons) {
+        throw std::out_of_range("SynapseMatrix: conexión con una neurona inexistente");
+      }
+      ++m_row[c.pre + 1];
+    }
+    for (std::size_t i = 0; i < neurons; ++i) {
+      m_row[i + 1] += m_row[i];
+    }
+    std::vector<std::uint32_t> next(m_row.begin(), m_row.end() - 1);
+    for (const Connection &c : connections) {
+      std::uint32_t j = next[c.pre]++;
+      m_post[j] = c.post;
+      m_gsyn[j] = Precission(c.gsyn);
+    }
+    for (std::size_t i = 0; i < neurons; ++i) {
+      if (m_row[i + 1] > m_row[i]) {
+        m_pre.push_back(static_cast<std::uint32_t>(i));
+      }
+    }
+    m_r.assign(m_pre.size(), Precission(0));
+    m_s.assign(m_pre.size(), Precission(0));
+  }
+
+  const SynapseType &type() const { return m_type; }
+  std::size_t size() const { return m_post.size(); }
+  std::size_t bytes() const {
+    return m_row.size() * sizeof(std::uint32_t) + m_post.size() * sizeof(std::uint32_t) +
+           m_gsyn.size() * sizeof(Precission) + m_pre.size() * sizeof(std::uint32_t) +
+           2 * m_pre.size() * sizeof(Precission);
+  }
+
+  // r y s de las sinapsis que salen de la neurona pre
+  Precission r(std::uint32_t pre) const { return state(m_r, pre); }
+  Precission s(std::uint32_t pre) const { return state(m_s, pre); }
+
+  // Avanza r y s un paso h con los voltajes v (fijos durante el paso):
+  //   r(h) = r_inf + (r0 - r_inf) a
+  //   s(h) = r_inf + (s0 - r_inf) a + (r0 - r_inf) (h / tau_syn) a
+  // con a = exp(-h / tau_syn)
+  void step(const Precission *v, Precission h) {
+    using std::exp;
+    const Precission v_r = m_type.v_r, slope = m_type.dec_slope;
+    const Precission a = exp(-h / Precission(m_type.tau_syn));
+    const Precission b = h / Precission(m_type.tau_syn) * a;
+    for (std::size_t k = 0; k < m_pre.size(); ++k) {
+      Precission r_inf = Precission(1) / (Precission(1) + exp((v_r - v[m_pre[k]]) / slope));
+      Precission dr = m_r[k] - r_inf;
+      m_s[k] = r_inf + (m_s[k] - r_inf) * a + dr * b;
+      m_r[k] = r_inf + dr * a;
+    }
+  }
+
+  // G[post] += gsyn s[pre] para todas las sinapsis
+  void conductance(Precission *__restrict G) const {
+    const std::uint32_t *__restrict post = m_post.data();
+    const Precission *__restrict gsyn = m_gsyn.data();
+    for (std::size_t k = 0; k < m_pre.size(); ++k) {
+      const Precission s = m_s[k];
+      for (std::uint32_t j = m_row[m_pre[k]], end = m_row[m_pre[k] + 1]; j < end; ++j) {
+        G[post[j]] += gsyn[j] * s;
+      }
+    }
+  }
+
+private:
+  Precission state(const std::vector<Precission> &x, std::uint32_t pre) const {
+    auto k = std::lower_bound(m_pre.begin(), m_pre.end(), pre);
+    return k != m_pre.end() && *k == pre ? x[k - m_pre.begin()] : Precission(0);
+  }
+
+  SynapseType m_type;
+  std::vector<std::uint32_t> m_row, m_post;
+  std::vector<Precission> m_gsyn;
+  std::vector<std::uint32_t> m_pre;     // Neuronas con alguna sinapsis de este tipo
+  std::vector<Precission> m_r, m_s;     // Estado por neurona de m_pre
+};
+
+template <template <typename> class Model, typename Integrator = RungeKutta4,
+          typename Precission = double, int W = SIMD_DEFAULT_LANES>
+class Population {
+public:
+  typedef NeuronEnsemble<Model, Integrator, Precission, W> Ensemble;
+  typedef typename Ensemble::Neuron Neuron;
+  typedef typename Ensemble::ConstructorArgs ConstructorArgs;
+  typedef typename Ensemble::variable variable;
+
+  // voltage es la variable de las neuronas que ven las sinapsis
+  Population(const std::vector<ConstructorArgs> &args, int selector = -1,
+             variable voltage = Neuron::v)
+      : m_neurons(args, selector), m_voltage(voltage), m_v(args.size()),
+        m_external(args.size()), m_I(args.size()), m_G(args.size()) {}
+
+  // Añade un tipo de sinapsis con sus conexiones y devuelve su índice
+  std::size_t connect(const SynapseType &type, const std::vector<Connection> &connections) {
+    m_synapses.emplace_back(size(), type, connections);
+    return m_synapses.size() - 1;
+  }
+
+  std::size_t size() const { return m_neurons.size(); }
+  std::size_t synapses() const {
+    std::size_t n = 0;
+    for (const SynapseMatrix<Precission> &m : m_synapses) {
+      n += m.size();
+    }
+    return n;
+  }
+  std::size_t synapse_bytes() const {
+    std::size_t n = 0;
+    for (const SynapseMatrix<Precission> &m : m_synapses) {
+      n += m.bytes();
+    }
+    return n;
+  }
+
+  Ensemble &neurons() { return m_neurons; }
+  const Ensemble &neurons() const { return m_neurons; }
+  const SynapseMatrix<Precission> &synapse_type(std::size_t t) const { return m_synapses[t]; }
+
+  void set(std::size_t i, variable var, Precission x) { m_neurons.set(i, var, x); }
+  Precission get(std::size_t i, variable var) const { return m_neurons.get(i, var); }
+
+  // Corriente externa de la neurona, constante hasta que se cambie
+  void set_input(std::size_t i, Precission I) { m_external[i] = I; }
+  Precission input(std::size_t i) const { return m_external[i]; }
+
+  // Voltajes al final del último paso
+  const std::vector<Precission> &voltages() const { return m_v; }
+
+  void step(Precission h) {
+    const std::size_t n = size();
+    for (std::size_t i = 0; i < n; ++i) {
+      m_v[i] = m_neurons.get(i, m_voltage);
+      m_I[i] = m_external[i];
+    }
+
+    for (SynapseMatrix<Precission> &m : m_synapses) {
+      m.step(m_v.data(), h);
+      std::fill(m_G.begin(), m_G.end(), Precission(0));
+      m.conductance(m_G.data());
+      const Precission esyn = m.type().esyn;
+      for (std::size_t i = 0; i < n; ++i) {
+        m_I[i] += m_G[i] * (m_v[i] - esyn);
+      }
+    }
+
+    for (std::size_t i = 0; i < n; ++i) {
+      m_neurons.add_synaptic_input(i, m_I[i]);
+    }
+    m_neurons.step(h);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      m_v[i] = m_neurons.get(i, m_voltage);
+    }
+  }
+
+private:
+  Ensemble m_neurons;
+  variable m_voltage;
+  std::vector<SynapseMatrix<Precission>> m_synapses;
+
+  std::vector<Precission> m_v, m_external, m_I, m_G;
+};
+
+#endif /* POPULATION_H_ */
@@ -0,0 +1,241 @@
+/*************************************************************
+ * Profiler.h - Tiempo por fase y por objeto del bucle de simulación
+ *
+ * Instrumentación opcional para saber en qué se va el tiempo de un
+ * bucle: sinapsis, neuronas, estímulo, salida... Sólo existe si se
+ * compila con -DNEUN_PROFILE (cmake -DPROFILE=ON); si no, las macros
+ * no generan código.
+ *
+ * Se mide por vueltas: cada marca suma al contador de (fase, objeto)
+ * el tiempo desde la marca anterior, así que cada fase cuesta una
+ * sola lectura del reloj (rdtsc en x86, steady_clock en el resto).
+ * Para que el coste no pese en bucles de pasos cortos, sólo se mide
+ * una de cada stride iteraciones; las llamadas se cuentan todas y el
+ * tiempo total se estima con el de las iteraciones medidas:
+ *
+ *   PROFILE_LAP(lap, 16);                    // mide 1 de cada 16
+ *   for (...) {
+ *     PROFILE_ITERATION(lap);
+ *     s_n1m_n2v.step(h);
+ *     PROFILE_MARK(lap, "sinapsis", "s_n1m_n2v");
+ *     n1m.step(h);
+ *     PROFILE_MARK(lap, "neurona", "n1m");
+ *   }
+ *   PROFILE_REPORT(json_path);               // tabla por stderr
+ *
+ * PROFILE_REPORT escribe la tabla por stderr (stdout suele llevar la
+ * traza) y, si la ruta no está vacía, el mismo desglose en JSON. Los
+ * ciclos de rdtsc se pasan a ns comparándolos con steady_clock entre
+ * el primer contador y el informe.
+ *
+ * Los contadores son globales y no están protegidos: instrumentar
+ * sólo bucles de un hilo.
+ *
+ *************************************************************/
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#ifdef NEUN_PROFILE
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+struct ProfileCounter {
+  std::string phase, object;
+  std::uint64_t calls = 0;
+  std::uint64_t samples = 0;  // Llamadas medidas
+  std::uint64_t ticks = 0;    // Tiempo de las llamadas medidas
+
+  // Tiempo estimado de todas las llamadas
+  double ns(double ns_per_tick) const {
+    return samples ? ticks * ns_per_tick * (double(calls) / samples) : 0.0;
+  }
+};
+
+class Profiler {
+public:
+  static Profiler &global() {
+    static Profiler profiler;
+    return profiler;
+  }
+
+  static std::uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+#endif
+  }
+
+  // Contador de (phase, object); la referencia es estable
+  ProfileCounter &counter(const char *phase, const char *object) {
+    for (ProfileCounter &c : m_counters) {
+      if (c.phase == phase && c.object == object) {
+        return c;
+      }
+    }
+    ProfileCounter &c = m_counters.emplace_back();
+    c.phase = phase;
+    c.object = object;
+    return c;
+  }
+
+  const std::deque<ProfileCounter> &counters() const { return m_counters; }
+
+  // ns por tick medidos desde que se creó el perfilador
+  double ns_per_tick() const {
+    double ticks = double(now() - m_ticks0);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() -
+                                                         m_clock0)
+                    .count();
+    return ticks > 0 ? ns / ticks : 1.0;
+  }
+
+  void report(const std::string &json_path) const {
+    const double scale = ns_per_tick();
+    double total = 0;
+    for (const ProfileCounter &c : m_counters) {
+      total += c.ns(scale);
+    }
+
+    // Fases en orden de aparición, con sus objetos y un subtotal
+    std::vector<std::string> phases;
+    for (const ProfileCounter &c : m_counters) {
+      bool seen = false;
+      for (const std::string &p : phases) {
+        seen = seen || p == c.phase;
+      }
+      if (!seen) {
+        phases.push_back(c.phase);
+      }
+    }
+
+    std::fprintf(stderr, "%-12s %-12s %12s %12s %12s %7s\n", "fase", "objeto", "llamadas",
+                 "ns/llamada", "total ms", "%");
+    for (const std::string &p : phases) {
+      std::uint64_t calls = 0;
+      double ns = 0;
+      int objects = 0;
+      for (const ProfileCounter &c : m_counters) {
+        if (c.phase != p) {
+          continue;
+        }
+        print_row(c.phase, c.object, c.calls, c.ns(scale), total);
+        calls += c.calls;
+        ns += c.ns(scale);
+        ++objects;
+      }
+      if (objects > 1) {
+        print_row(p, "(total)", calls, ns, total);
+      }
+    }
+    std::fprintf(stderr, "%-12s %-12s %12s %12s %12.3f\n", "total", "", "", "", total * 1e-6);
+
+    if (!json_path.empty()) {
+      write_json(json_path, scale, total);
+    }
+  }
+
+private:
+  Profiler() : m_ticks0(now()), m_clock0(std::chrono::steady_clock::now()) {}
+
+  static void print_row(const std::string &phase, const std::string &object,
+                        std::uint64_t calls, double ns, double total) {
+    std::fprintf(stderr, "%-12s %-12s %12llu %12.1f %12.3f %7.2f\n", phase.c_str(),
+                 object.c_str(), static_cast<unsigned long long>(calls),
+                 calls ? ns / calls : 0.0, ns * 1e-6, total > 0 ? 100.0 * ns / total : 0.0);
+  }
+
+  void write_json(const std::string &path, double scale, double total) const {
+    std::FILE *f = std::fopen(path.c_str(), "w");
+    if (!f) {
+      std::perror(path.c_str());
+      return;
+    }
+    std::fprintf(f, "{\n  \"ns_per_tick\": %.6g,\n  \"total_ns\": %.6g,\n  \"counters\": [\n",
+                 scale, total);
+    for (std::size_t i = 0; i < m_counters.size(); ++i) {
+      const ProfileCounter &c = m_counters[i];
+      std::fprintf(f,
+                   "    {\"phase\": \"%s\", \"object\": \"%s\", \"calls\": %llu, "
+                   "\"samples\": %llu, \"ns\": %.6g}%s\n",
+                   c.phase.c_str(), c.object.c_str(), static_cast<unsigned long long>(c.calls),
+                   static_cast<unsigned long long>(c.samples), c.ns(scale),
+                   i + 1 < m_counters.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+  }
+
+  std::deque<ProfileCounter> m_counters;
+  std::uint64_t m_ticks0;
+  std::chrono::steady_clock::time_point m_clock0;
+};
+
+// Cronómetro por vueltas: mark() asigna al contador el tiempo desde la
+// marca anterior
+class ProfileLap {
+public:
+  explicit ProfileLap(long stride = 1)
+      : m_stride(stride > 0 ? stride : 1), m_iteration(0), m_sampling(true),
+        m_last((Profiler::global(), Profiler::now())) {}
+
+  // Al principio de cada iteración: decide si se mide
+  void iteration() {
+    m_sampling = m_iteration++ % m_stride == 0;
+    if (m_sampling) {
+      m_last = Profiler::now();
+    }
+  }
+
+  void mark(ProfileCounter &c) {
+    ++c.calls;
+    if (m_sampling) {
+      std::uint64_t t = Profiler::now();
+      c.ticks += t - m_last;
+      ++c.samples;
+      m_last = t;
+    }
+  }
+
+  // Descarta el tiempo desde la última marca
+  void restart() { m_last = Profiler::now(); }
+
+private:
+  long m_stride, m_iteration;
+  bool m_sampling;
+  std::uint64_t m_last;
+};
+
+#define PROFILE_LAP(lap, stride) ProfileLap lap(stride)
+#define PROFILE_ITERATION(lap) (lap).iteration()
+#define PROFILE_MARK(lap, phase, object)                                                     \
+  do {                                                                                       \
+    static ProfileCounter &profile_counter_ = Profiler::global().counter(phase, object);     \
+    (lap).mark(profile_counter_);                                                            \
+  } while (0)
+#define PROFILE_RESTART(lap) (lap).restart()
+#define PROFILE_REPORT(json_path) Profiler::global().report(json_path)
+
+#else
+
+#define PROFILE_LAP(lap, stride) static_cast<void>(stride)
+#define PROFILE_ITERATION(lap) static_cast<void>(0)
+#define PROFILE_MARK(lap, phase, object) static_cast<void>(0)
+#define PROFILE_RESTART(lap) static_cast<void>(0)
+#define PROFILE_REPORT(json_path) static_cast<void>(0)
+
+#endif /* NEUN_PROFILE */
+
+#endif /* PROFILER_H_ */
@@ -0,0 +1,102 @@
+/*************************************************************
+ * RushLarsen.h - Integrador exponencial para variables de compuerta
+ *
+ * En VavoulisModel y VavoulisCGCModel cada compuerta sigue
+ *
+ *   dx/dt = (x_inf(V) - x) / tau(V)
+ *
+ * que, con V fijo, es lineal en x y tiene solución exacta:
+ *
+ *   x(t + h) = x_inf + (x(t) - x_inf) exp(-h / tau)
+ *
+ * El esquema de Rush y Larsen (1978) avanza así las compuertas y los
+ * voltajes de forma explícita, de modo que compuertas rápidas
+ * (tau0_r = 4.01, tau0_e = 3.81 en la CGC) no limitan el paso. Esta
+ * versión es la de segundo orden (Perego y Veneziani 2009): medio
+ * paso de Rush-Larsen para estimar el punto medio y paso completo con
+ * x_inf, tau y dV/dt evaluados en él.
+ *
+ * x_inf y tau no se piden al modelo: se obtienen de su eval
+ * perturbando a la vez todas las compuertas (la derivada de cada una
+ * sólo depende de ella misma y de los voltajes), así que sirve para
+ * cualquier modelo de Neun sin cambiarlo. Cada paso cuesta 4
+ * evaluaciones, como RungeKutta4.
+ *
+ * Voltages es el número de variables de voltaje, que en Neun van antes
+ * que las compuertas:
+ *
+ *   RushLarsen<1>   VavoulisCGCModel (v; h, r, a, b, n, e, f)
+ *   RushLarsen<2>   VavoulisModel    (v, va; p, q, h, n)
+ *
+ *************************************************************/
+
+#ifndef RUSHLARSEN_H_
+#define RUSHLARSEN_H_
+
+#include <cmath>
+#include <cstddef>
+
+template <int Voltages = 1> class RushLarsen {
+public:
+  template <typename System>
+  static void step(System &system, typename System::precission_t h,
+                   typename System::precission_t *const vars,
+                   typename System::precission_t *const params) {
+    typedef typename System::precission_t T;
+    constexpr std::size_t n = System::n_variables;
+    static_assert(Voltages >= 0 && static_cast<std::size_t>(Voltages) <= n,
+                  "RushLarsen: más voltajes que variables");
+
+    T f[n], rate[n], mid[n], probe[n];
+
+    // Medio paso de primer orden desde vars hasta mid
+    linearize(system, vars, params, f, rate, probe);
+    advance<T, n>(vars, vars, f, rate, T(0.5) * h, mid);
+
+    // Paso completo desde vars con la linealización en mid
+    linearize(system, mid, params, f, rate, probe);
+    advance<T, n>(vars, mid, f, rate, h, vars);
+  }
+
+private:
+  // Perturbación de las compuertas para medir su pendiente. Como la
+  // derivada es lineal en la compuerta el resultado no depende de ella.
+  static constexpr double gate_probe = 0.25;
+
+  // f = f(x) y, para cada compuerta, rate = d f_i / d x_i = -1 / tau
+  template <typename System, typename T>
+  static void linearize(System &system, const T *x, T *params, T *f, T *rate, T *probe) {
+    constexpr std::size_t n = System::n_variables;
+    system.eval(x, params, f);
+    for (std::size_t i = 0; i < n; ++i) {
+      probe[i] = i < static_cast<std::size_t>(Voltages) ? x[i] : x[i] + T(gate_probe);
+    }
+    system.eval(probe, params, rate);
+    for (std::size_t i = Voltages; i < n; ++i) {
+      rate[i] = (rate[i] - f[i]) / T(gate_probe);
+    }
+  }
+
+  // (exp(z) - 1) / z, con su serie cerca de 0
+  template <typename T> static T phi(T z) {
+    using std::exp;
+    using std::fabs;
+    return fabs(z) < T(1e-6) ? T(1) + T(0.5) * z : (exp(z) - T(1)) / z;
+  }
+
+  // Avanza x0 un paso h con la linealización (f, rate) tomada en xm:
+  // exponencial en las compuertas y Euler en los voltajes
+  template <typename T, std::size_t n>
+  static void advance(const T *x0, const T *xm, const T *f, const T *rate, T h, T *out) {
+    for (std::size_t i = 0; i < static_cast<std::size_t>(Voltages); ++i) {
+      out[i] = x0[i] + h * f[i];
+    }
+    for (std::size_t i = Voltages; i < n; ++i) {
+      // f_i(x0) = f_i(xm) + rate_i (x0_i - xm_i) por ser lineal en x_i
+      T f0 = f[i] + rate[i] * (x0[i] - xm[i]);
+      out[i] = x0[i] + h * f0 * phi(rate[i] * h);
+    }
+  }
+};
+
+#endif /* RUSHLARSEN_H_ */
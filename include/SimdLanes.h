@@ -0,0 +1,297 @@
+/*************************************************************
+ * SimdLanes.h - Tipo numérico con W carriles SIMD
+ *
+ * Lanes<T, W> se comporta como un escalar de tipo T pero guarda W
+ * valores en un registro vectorial (extensiones vectoriales de GCC,
+ * que se traducen a SSE/AVX2/AVX-512 según -march). Como los modelos
+ * de Neun están parametrizados por la precisión, instanciar por
+ * ejemplo VavoulisModel<Lanes<double, 8>> integra 8 neuronas a la vez
+ * con el mismo código del modelo y del integrador: cada variable de
+ * estado pasa a ser un vector de 8 carriles (estructura de arrays).
+ *
+ * Funciones matemáticas vectorizadas: exp, log, pow, sqrt, fabs, tanh.
+ * exp y log usan reducción de rango y polinomios con error relativo
+ * del orden de 1e-16 (1e-7 en float), así que los resultados coinciden
+ * con la ruta escalar dentro de tolerancia, no bit a bit.
+ *
+ * Las comparaciones devuelven bool y sólo son ciertas si lo son en
+ * todos los carriles. Sirven para parámetros selectores uniformes en
+ * el lote (n_type en VavoulisModel); los modelos con ramas que
+ * dependen del estado no se pueden vectorizar así.
+ *
+ * SIMD_DEFAULT_LANES sale de los macros del compilador: 8 double con
+ * AVX-512F, 4 con AVX2 y 1 en otro caso. Con registros de 2 double
+ * (SSE2, el x86-64 por defecto sin -march, o NEON) los lotes eran más
+ * lentos que la ruta escalar, así que Lanes<T, 1> es un escalar con
+ * las funciones de <cmath> y NeuronEnsemble integra neurona a neurona.
+ * Para usar los registros anchos hay que compilar con -march=native
+ * (opción NATIVE_ARCH de CMake) o el -march de la máquina destino.
+ *
+ *************************************************************/
+
+#ifndef SIMDLANES_H_
+#define SIMDLANES_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Ancho por defecto para double según el conjunto de instrucciones
+#if defined(__AVX512F__)
+#define SIMD_DEFAULT_LANES 8
+#elif defined(__AVX2__)
+#define SIMD_DEFAULT_LANES 4
+#else
+#define SIMD_DEFAULT_LANES 1
+#endif
+
+template <typename T, int W = SIMD_DEFAULT_LANES> class Lanes {
+  static_assert(std::is_floating_point_v<T>, "Lanes necesita un tipo de coma flotante");
+  static_assert(W > 0 && (W & (W - 1)) == 0, "W debe ser potencia de 2");
+
+public:
+  typedef T value_type;
+  typedef T vector_type __attribute__((vector_size(sizeof(T) * W)));
+  static constexpr int width = W;
+
+  Lanes() : v{} {}
+  Lanes(T x) : v(vector_type{} + x) {}
+
+  T operator[](int i) const { return v[i]; }
+  void set(int i, T x) { v[i] = x; }
+
+  // Valor del carril 0. Sólo tiene sentido para parámetros uniformes
+  explicit operator T() const { return v[0]; }
+
+  Lanes &operator+=(const Lanes &o) { v += o.v; return *this; }
+  Lanes &operator-=(const Lanes &o) { v -= o.v; return *this; }
+  Lanes &operator*=(const Lanes &o) { v *= o.v; return *this; }
+  Lanes &operator/=(const Lanes &o) { v /= o.v; return *this; }
+
+  Lanes operator-() const { return wrap(-v); }
+  Lanes operator+() const { return *this; }
+
+  friend Lanes operator+(const Lanes &a, const Lanes &b) { return wrap(a.v + b.v); }
+  friend Lanes operator-(const Lanes &a, const Lanes &b) { return wrap(a.v - b.v); }
+  friend Lanes operator*(const Lanes &a, const Lanes &b) { return wrap(a.v * b.v); }
+  friend Lanes operator/(const Lanes &a, const Lanes &b) { return wrap(a.v / b.v); }
+  friend Lanes operator+(T a, const Lanes &b) { return wrap(a + b.v); }
+  friend Lanes operator-(T a, const Lanes &b) { return wrap(a - b.v); }
+  friend Lanes operator*(T a, const Lanes &b) { return wrap(a * b.v); }
+  friend Lanes operator/(T a, const Lanes &b) { return wrap(a / b.v); }
+  friend Lanes operator+(const Lanes &a, T b) { return wrap(a.v + b); }
+  friend Lanes operator-(const Lanes &a, T b) { return wrap(a.v - b); }
+  friend Lanes operator*(const Lanes &a, T b) { return wrap(a.v * b); }
+  friend Lanes operator/(const Lanes &a, T b) { return wrap(a.v / b); }
+
+  friend bool operator==(const Lanes &a, const Lanes &b) { return all(a.v == b.v); }
+  friend bool operator!=(const Lanes &a, const Lanes &b) { return !(a == b); }
+  friend bool operator<(const Lanes &a, const Lanes &b) { return all(a.v < b.v); }
+  friend bool operator>(const Lanes &a, const Lanes &b) { return all(a.v > b.v); }
+  friend bool operator<=(const Lanes &a, const Lanes &b) { return all(a.v <= b.v); }
+  friend bool operator>=(const Lanes &a, const Lanes &b) { return all(a.v >= b.v); }
+
+  // Selección carril a carril: mask ? a : b con mask = (x < y)
+  static Lanes select_less(const Lanes &x, const Lanes &y, const Lanes &a, const Lanes &b) {
+    return wrap(x.v < y.v ? a.v : b.v);
+  }
+
+  friend Lanes exp(const Lanes &x) { return wrap(vexp(x.v)); }
+  friend Lanes log(const Lanes &x) { return wrap(vlog(x.v)); }
+  friend Lanes pow(const Lanes &x, const Lanes &y) { return wrap(vexp(y.v * vlog(x.v))); }
+  friend Lanes pow(const Lanes &x, T y) {
+    if (y == T(2)) {
+      return x * x;
+    }
+    return wrap(vexp(y * vlog(x.v)));
+  }
+  friend Lanes fabs(const Lanes &x) { return wrap(x.v < T(0) ? -x.v : x.v); }
+  friend Lanes abs(const Lanes &x) { return fabs(x); }
+  friend Lanes sqrt(const Lanes &x) {
+    vector_type r;
+    for (int i = 0; i < W; ++i) {
+      r[i] = std::sqrt(x.v[i]);  // Se vectoriza a vsqrtpd/vsqrtps
+    }
+    return wrap(r);
+  }
+  friend Lanes tanh(const Lanes &x) {
+    vector_type e = vexp(T(-2) * x.v);
+    return wrap((T(1) - e) / (T(1) + e));
+  }
+
+private:
+  struct raw {};
+  Lanes(raw, vector_type x) : v(x) {}
+  static Lanes wrap(vector_type x) { return Lanes(raw{}, x); }
+
+  typedef std::conditional_t<sizeof(T) == 8, std::int64_t, std::int32_t> int_type;
+  typedef int_type int_vector __attribute__((vector_size(sizeof(T) * W)));
+
+  static constexpr int mantissa_bits = sizeof(T) == 8 ? 52 : 23;
+  static constexpr int exponent_bias = sizeof(T) == 8 ? 1023 : 127;
+
+  static constexpr T shifter() { return T(1.5) * T(int_type(1) << mantissa_bits); }
+
+  template <int N> struct coefficients {
+    T c[N + 1];
+    constexpr T operator[](int k) const { return c[k]; }
+  };
+
+  template <int N> static constexpr coefficients<N> inv_factorials() {
+    coefficients<N> f{};
+    f.c[0] = T(1);
+    for (int k = 1; k <= N; ++k) {
+      f.c[k] = f.c[k - 1] / T(k);
+    }
+    return f;
+  }
+
+  static int_vector as_int(vector_type x) {
+    int_vector r;
+    __builtin_memcpy(&r, &x, sizeof(x));
+    return r;
+  }
+
+  static vector_type as_float(int_vector x) {
+    vector_type r;
+    __builtin_memcpy(&r, &x, sizeof(x));
+    return r;
+  }
+
+  template <typename Mask> static bool all(Mask m) {
+    for (int i = 0; i < W; ++i) {
+      if (!m[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // exp(x) = 2^n * exp(r), x = n ln2 + r, |r| <= ln2 / 2
+  static vector_type vexp(vector_type x) {
+    const T max_x = sizeof(T) == 8 ? T(709.0) : T(88.0);
+    const T min_x = sizeof(T) == 8 ? T(-708.0) : T(-87.0);
+    x = x > max_x ? vector_type{} + max_x : x;
+    x = x < min_x ? vector_type{} + min_x : x;
+
+    // ln2 partido en dos para que fn * ln2_hi sea exacto (Cody-Waite)
+    const T ln2_hi = sizeof(T) == 8 ? T(0.693145751953125) : T(0.693359375);
+    const T ln2_lo = sizeof(T) == 8 ? T(1.42860682030941723212e-6) : T(-2.12194440e-4);
+    const T log2e = T(1.4426950408889634074);
+
+    // Redondeo al entero más cercano sumando 1.5 * 2^mantissa_bits: el
+    // entero queda en los bits bajos de la mantisa sin convertir tipos
+    // (la conversión int64 <-> double no tiene instrucción antes de AVX-512)
+    vector_type t = x * log2e + shifter();
+    vector_type fn = t - shifter();
+    int_vector n = as_int(t) - as_int(vector_type{} + shifter());
+    vector_type r = (x - fn * ln2_hi) - fn * ln2_lo;
+
+    // Taylor de exp(r) por Horner (grado 13 en double, 7 en float)
+    constexpr int degree = sizeof(T) == 8 ? 13 : 7;
+    constexpr auto c = inv_factorials<degree>();
+    vector_type p = vector_type{} + c[degree];
+    for (int k = degree - 1; k >= 0; --k) {
+      p = p * r + c[k];
+    }
+
+    // Multiplicar por 2^n sumando n al exponente
+    return as_float(as_int(p) + (n << mantissa_bits));
+  }
+
+  // log(x) = e ln2 + log(m), m en [sqrt(1/2), sqrt(2)), vía atanh
+  static vector_type vlog(vector_type x) {
+    int_vector bits = as_int(x);
+    // x = m 2^e con m en [1/2, 1)
+    int_vector e = ((bits >> mantissa_bits) & ((int_type(1) << (sizeof(T) * 8 - 1 - mantissa_bits)) - 1)) - (exponent_bias - 1);
+    vector_type m = as_float((bits & ((int_type(1) << mantissa_bits) - 1)) |
+                             (int_type(exponent_bias - 1) << mantissa_bits));
+
+    const T sqrt_half = T(0.70710678118654752440);
+    int_vector shift = m < sqrt_half ? int_vector{} + 1 : int_vector{};
+    m = m < sqrt_half ? m * T(2) : m;
+    e -= shift;
+
+    vector_type s = (m - T(1)) / (m + T(1));
+    vector_type s2 = s * s;
+    constexpr int terms = sizeof(T) == 8 ? 11 : 5;
+    vector_type p = vector_type{} + T(1) / T(2 * terms + 1);
+    for (int k = terms - 1; k >= 0; --k) {
+      p = p * s2 + T(1) / T(2 * k + 1);
+    }
+
+    const T ln2 = T(0.69314718055994530942);
+    // e a coma flotante con el mismo truco que en vexp
+    vector_type fe = as_float(e + as_int(vector_type{} + shifter())) - shifter();
+    vector_type result = T(2) * s * p + fe * ln2;
+    // Fuera del dominio se devuelve NaN como std::log
+    return x > T(0) ? result : vector_type{} + T(NAN);
+  }
+
+  vector_type v;
+};
+
+// Un carril: la misma interfaz sobre un escalar, sin vectores de GCC
+template <typename T> class Lanes<T, 1> {
+  static_assert(std::is_floating_point_v<T>, "Lanes necesita un tipo de coma flotante");
+
+public:
+  typedef T value_type;
+  typedef T vector_type;
+  static constexpr int width = 1;
+
+  Lanes() : v{} {}
+  Lanes(T x) : v(x) {}
+
+  T operator[](int) const { return v; }
+  void set(int, T x) { v = x; }
+
+  explicit operator T() const { return v; }
+
+  Lanes &operator+=(const Lanes &o) { v += o.v; return *this; }
+  Lanes &operator-=(const Lanes &o) { v -= o.v; return *this; }
+  Lanes &operator*=(const Lanes &o) { v *= o.v; return *this; }
+  Lanes &operator/=(const Lanes &o) { v /= o.v; return *this; }
+
+  Lanes operator-() const { return Lanes(-v); }
+  Lanes operator+() const { return *this; }
+
+  friend Lanes operator+(const Lanes &a, const Lanes &b) { return Lanes(a.v + b.v); }
+  friend Lanes operator-(const Lanes &a, const Lanes &b) { return Lanes(a.v - b.v); }
+  friend Lanes operator*(const Lanes &a, const Lanes &b) { return Lanes(a.v * b.v); }
+  friend Lanes operator/(const Lanes &a, const Lanes &b) { return Lanes(a.v / b.v); }
+  friend Lanes operator+(T a, const Lanes &b) { return Lanes(a + b.v); }
+  friend Lanes operator-(T a, const Lanes &b) { return Lanes(a - b.v); }
+  friend Lanes operator*(T a, const Lanes &b) { return Lanes(a * b.v); }
+  friend Lanes operator/(T a, const Lanes &b) { return Lanes(a / b.v); }
+  friend Lanes operator+(const Lanes &a, T b) { return Lanes(a.v + b); }
+  friend Lanes operator-(const Lanes &a, T b) { return Lanes(a.v - b); }
+  friend Lanes operator*(const Lanes &a, T b) { return Lanes(a.v * b); }
+  friend Lanes operator/(const Lanes &a, T b) { return Lanes(a.v / b); }
+
+  friend bool operator==(const Lanes &a, const Lanes &b) { return a.v == b.v; }
+  friend bool operator!=(const Lanes &a, const Lanes &b) { return a.v != b.v; }
+  friend bool operator<(const Lanes &a, const Lanes &b) { return a.v < b.v; }
+  friend bool operator>(const Lanes &a, const Lanes &b) { return a.v > b.v; }
+  friend bool operator<=(const Lanes &a, const Lanes &b) { return a.v <= b.v; }
+  friend bool operator>=(const Lanes &a, const Lanes &b) { return a.v >= b.v; }
+
+  static Lanes select_less(const Lanes &x, const Lanes &y, const Lanes &a, const Lanes &b) {
+    return x.v < y.v ? a : b;
+  }
+
+  friend Lanes exp(const Lanes &x) { return Lanes(std::exp(x.v)); }
+  friend Lanes log(const Lanes &x) { return Lanes(std::log(x.v)); }
+  friend Lanes pow(const Lanes &x, const Lanes &y) { return Lanes(std::pow(x.v, y.v)); }
+  friend Lanes pow(const Lanes &x, T y) { return Lanes(y == T(2) ? x.v * x.v : std::pow(x.v, y)); }
+  friend Lanes fabs(const Lanes &x) { return Lanes(std::fabs(x.v)); }
+  friend Lanes abs(const Lanes &x) { return fabs(x); }
+  friend Lanes sqrt(const Lanes &x) { return Lanes(std::sqrt(x.v)); }
+  friend Lanes tanh(const Lanes &x) { return Lanes(std::tanh(x.v)); }
+
+private:
+  T v;
+};
+
+#endif /* SIMDLANES_H_ */
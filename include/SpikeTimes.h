@@ -0,0 +1,57 @@
+/*************************************************************
+ * SpikeTimes.h - Instantes de spike a partir de una traza de voltaje
+ *
+ * Registra los cruces ascendentes de un umbral (por defecto -20 mV),
+ * interpolando linealmente entre dos muestras consecutivas, para
+ * comparar integradores o pasos distintos:
+ *
+ *   SpikeTimes spikes;
+ *   spikes.add(time, n.get(Neuron::v));   // en cada muestra
+ *   max_shift(spikes, reference);         // mayor desfase (ms)
+ *
+ *************************************************************/
+
+#ifndef SPIKETIMES_H_
+#define SPIKETIMES_H_
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+struct SpikeTimes {
+  explicit SpikeTimes(double threshold = -20.0) : threshold(threshold) {}
+
+  void add(double t, double v) {
+    if (!first && v_prev < threshold && v >= threshold) {
+      times.push_back(t_prev + (t - t_prev) * (threshold - v_prev) / (v - v_prev));
+    }
+    t_prev = t;
+    v_prev = v;
+    first = false;
+  }
+
+  std::size_t size() const { return times.size(); }
+
+  std::vector<double> times;
+  double threshold;
+
+private:
+  double t_prev = 0, v_prev = 0;
+  bool first = true;
+};
+
+// Mayor diferencia entre spikes emparejados en orden (infinito si el
+// número de spikes no coincide)
+inline double max_shift(const SpikeTimes &a, const SpikeTimes &b) {
+  if (a.size() != b.size()) {
+    return std::numeric_limits<double>::infinity();
+  }
+  double shift = 0.0;
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    shift = std::max(shift, std::fabs(a.times[i] - b.times[i]));
+  }
+  return shift;
+}
+
+#endif /* SPIKETIMES_H_ */
@@ -0,0 +1,217 @@
+/*************************************************************
+ * SteadyState.h - Punto de reposo de un modelo o de una red
+ *
+ * Las condiciones iniciales de los ejemplos son x_inf de cada
+ * compuerta a un voltaje fijado a mano (-67 mV, -60 mV), que no es el
+ * punto fijo del modelo: la simulación empieza fuera del equilibrio y
+ * gasta tiempo en el transitorio. SteadyState busca el punto fijo
+ * f(x) = 0 del lado derecho del modelo partiendo del estado actual.
+ *
+ * Newton desde una estimación lejana puede acabar en un punto fijo
+ * inestable o no converger, así que se usa continuación
+ * pseudo-transitoria: pasos de Euler implícito
+ *
+ *   (I/dt - J) dx = f(x),   J por diferencias finitas
+ *
+ * cuyo dt crece a medida que baja el residuo. Con dt pequeño sigue la
+ * dinámica del modelo hacia el reposo estable; con dt grande es
+ * Newton y converge cuadráticamente:
+ *
+ *   n.set(...);                              // estimación inicial
+ *   SteadyState::rest(n);                    // reposo sin entrada
+ *   SteadyState::rest(n, -6.0);              // bajo un drive tónico
+ *
+ * solve() trabaja directamente sobre un sistema con el contrato de
+ * los integradores (eval(vars, params, incs)), como FusedNetwork, para
+ * una red completa con sus entradas externas:
+ *
+ *   SteadyState::solve(net, net.variables(), net.parameters());
+ *
+ * Si no converge (por ejemplo, una neurona que oscila sin estímulo no
+ * tiene reposo estable) el estado no se modifica y el resultado lo
+ * indica (converged = false).
+ *
+ *************************************************************/
+
+#ifndef STEADYSTATE_H_
+#define STEADYSTATE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
+
+struct SteadyStateOptions {
+  double tolerance = 1e-10;  // max |f(x)| (unidades de dx/dt)
+  int max_iterations = 200;
+  double dt = 1.0;           // Paso inicial de la continuación (ms)
+};
+
+struct SteadyStateResult {
+  bool converged = false;
+  int iterations = 0;
+  double residual = 0.0;  // max |f(x)| en el punto final
+};
+
+class SteadyState {
+public:
+  typedef SteadyStateOptions Options;
+  typedef SteadyStateResult Result;
+
+  // Punto fijo de system desde vars; si converge, lo deja en vars
+  template <typename System>
+  static Result solve(System &system, typename System::precission_t *const vars,
+                      typename System::precission_t *const params,
+                      const Options &options = Options()) {
+    typedef typename System::precission_t T;
+    const std::size_t n = System::n_variables;
+
+    std::vector<T> xt(n), ft(n);
+    auto rhs = [&](const std::vector<double> &x, std::vector<double> &f) {
+      for (std::size_t i = 0; i < n; ++i) {
+        xt[i] = T(x[i]);
+      }
+      system.eval(xt.data(), params, ft.data());
+      double norm = 0.0;
+      for (std::size_t i = 0; i < n; ++i) {
+        f[i] = double(ft[i]);
+        norm = std::max(norm, std::fabs(f[i]));
+      }
+      // Un NaN no debe parecer un residuo pequeño
+      return std::isfinite(norm) ? norm : std::numeric_limits<double>::infinity();
+    };
+
+    std::vector<double> x(vars, vars + n), f(n), trial(n), ftrial(n), dx(n);
+    std::vector<double> J(n * n);
+    const double eps = std::sqrt(double(std::numeric_limits<T>::epsilon()));
+    // En float el residuo no baja de ~1e-5 aunque el punto sea exacto
+    const double tolerance =
+        std::max(options.tolerance, 1e3 * double(std::numeric_limits<T>::epsilon()));
+
+    Result result;
+    double dt = options.dt;
+    result.residual = rhs(x, f);
+    while (result.residual > tolerance && result.iterations < options.max_iterations) {
+      ++result.iterations;
+
+      // Jacobiano por diferencias hacia delante, columna a columna
+      for (std::size_t j = 0; j < n; ++j) {
+        double h = eps * std::max(1.0, std::fabs(x[j]));
+        trial = x;
+        trial[j] += h;
+        rhs(trial, ftrial);
+        for (std::size_t i = 0; i < n; ++i) {
+          J[i * n + j] = (ftrial[i] - f[i]) / h;
+        }
+      }
+
+      // (I/dt - J) dx = f: Euler implícito con paso dt
+      for (std::size_t i = 0; i < n; ++i) {
+        for (std::size_t j = 0; j < n; ++j) {
+          J[i * n + j] = -J[i * n + j];
+        }
+        J[i * n + i] += 1.0 / dt;
+        dx[i] = f[i];
+      }
+      if (!gauss(J, dx, n)) {
+        break;
+      }
+      for (std::size_t i = 0; i < n; ++i) {
+        trial[i] = x[i] + dx[i];
+      }
+      double residual = rhs(trial, ftrial);
+
+      // Paso rechazado (sale del dominio o dispara el residuo): dt menor
+      if (!(residual < 10 * result.residual)) {
+        dt /= 10;
+        if (dt < 1e-12) {
+          break;
+        }
+        continue;
+      }
+
+      // El paso crece al bajar el residuo, hasta ser Newton puro
+      dt = std::min(dt * std::max(0.5, result.residual / residual), max_dt);
+      std::swap(x, trial);
+      std::swap(f, ftrial);
+      result.residual = residual;
+    }
+
+    result.converged = result.residual <= tolerance;
+    if (result.converged) {
+      for (std::size_t i = 0; i < n; ++i) {
+        vars[i] = T(x[i]);
+      }
+    }
+    return result;
+  }
+
+  // Reposo de una neurona con entrada constante I (0: sin entrada).
+  // Los valores que tenga la neurona son sólo la estimación inicial; si
+  // no converge, se queda con ellos. La entrada sólo se usa para
+  // resolver: al salir la neurona no tiene ninguna entrada pendiente de más
+  template <typename Neuron>
+  static Result rest(Neuron &neuron, double I = 0.0, const Options &options = Options()) {
+    typedef typename Neuron::precission_t T;
+    T vars[Neuron::n_variables], params[Neuron::n_parameters];
+    for (std::size_t k = 0; k < Neuron::n_variables; ++k) {
+      vars[k] = neuron.get(static_cast<typename Neuron::variable>(k));
+    }
+    for (std::size_t k = 0; k < Neuron::n_parameters; ++k) {
+      params[k] = neuron.get(static_cast<typename Neuron::parameter>(k));
+    }
+
+    neuron.add_synaptic_input(T(I));
+    Result result = solve(neuron, vars, params, options);
+    neuron.add_synaptic_input(T(-I));
+
+    if (result.converged) {
+      for (std::size_t k = 0; k < Neuron::n_variables; ++k) {
+        neuron.set(static_cast<typename Neuron::variable>(k), vars[k]);
+      }
+    }
+    return result;
+  }
+
+  // Resuelve A x = b (b se sobrescribe con x) con pivoteo parcial
+  static bool gauss(std::vector<double> &A, std::vector<double> &b, std::size_t n) {
+    for (std::size_t c = 0; c < n; ++c) {
+      std::size_t pivot = c;
+      for (std::size_t r = c + 1; r < n; ++r) {
+        if (std::fabs(A[r * n + c]) > std::fabs(A[pivot * n + c])) {
+          pivot = r;
+        }
+      }
+      if (!(std::fabs(A[pivot * n + c]) > 0.0)) {
+        return false;
+      }
+      if (pivot != c) {
+        for (std::size_t k = 0; k < n; ++k) {
+          std::swap(A[c * n + k], A[pivot * n + k]);
+        }
+        std::swap(b[c], b[pivot]);
+      }
+      for (std::size_t r = c + 1; r < n; ++r) {
+        double m = A[r * n + c] / A[c * n + c];
+        for (std::size_t k = c; k < n; ++k) {
+          A[r * n + k] -= m * A[c * n + k];
+        }
+        b[r] -= m * b[c];
+      }
+    }
+    for (std::size_t c = n; c-- > 0;) {
+      for (std::size_t k = c + 1; k < n; ++k) {
+        b[c] -= A[c * n + k] * b[k];
+      }
+      b[c] /= A[c * n + c];
+    }
+    return true;
+  }
+
+private:
+  static constexpr double max_dt = 1e12;
+};
+
+#endif /* STEADYSTATE_H_ */
@@ -0,0 +1,237 @@
+/*************************************************************
+ * Stimulus.h - Protocolos de estimulación compilados a una rejilla
+ *
+ * Los ejemplos construyen el estímulo comparando el tiempo con cada
+ * ventana en cada paso (time >= t_start && time <= t_end), y el tiempo
+ * se acumula con time += step, así que los extremos dependen del
+ * redondeo y cada pulso dura un paso más de lo pedido. StimulusProtocol
+ * describe el estímulo de una neurona por partes y lo compila sobre la
+ * rejilla exacta de pasos k (t = k h):
+ *
+ *   Stimulus so = StimulusProtocol()
+ *                     .pulse(200, 2800, -10.0)       // suma en [200, 2800)
+ *                     .set(800, 900, 15.0)           // sustituye lo anterior
+ *                     .compile(step);
+ *   for (long k = 0; k < steps; ++k) {
+ *     n.add_synaptic_input(so.current(k));
+ *     n.step(step);
+ *   }
+ *
+ * Componentes, todos en ventanas semiabiertas [start, end) en ms: el
+ * paso k lleva la corriente si start <= k h < end, así que un pulso
+ * dura end - start con cualquier h múltiplo de los extremos y dos
+ * ventanas contiguas no se solapan:
+ *
+ *   pulse(start, end, I)                 corriente constante
+ *   train(start, end, I, width, period)  pulsos de width ms cada period
+ *   ramp(start, end, I0, I1)             rampa lineal de I0 a I1
+ *   noise(start, end, sd, mean)          gaussiana nueva en cada paso
+ *   set(start, end, I)                   fija I e ignora los componentes
+ *                                        declarados antes
+ *
+ * Los componentes se suman en el orden en que se declaran. compile()
+ * los convierte en tramos [k_begin, k_end) ordenados con corriente
+ * a + b k (+ ruido); current(k) sólo compara k con el final del tramo
+ * actual. breakpoints() da los instantes pedidos (start y end de los
+ * componentes) en los que cambia el estímulo, para integradores que
+ * deben parar en ellos (Breakpoints.h).
+ *
+ *************************************************************/
+
+#ifndef STIMULUS_H_
+#define STIMULUS_H_
+
+#include <Breakpoints.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+class Stimulus {
+public:
+  // Tramo [begin, end) de pasos con corriente offset + slope k. time es
+  // el instante pedido en el que empieza (begin h salvo redondeo)
+  struct Segment {
+    long begin, end;
+    double offset, slope, sd, mean;
+    double time;
+  };
+
+  Stimulus(std::vector<Segment> segments, double h, std::uint64_t seed)
+      : m_segments(std::move(segments)), m_h(h), m_cursor(0), m_rng(seed) {}
+
+  // Corriente del paso k. Los k se recorren normalmente en orden; si se
+  // vuelve atrás se busca desde el principio
+  double current(long k) {
+    if (k < m_segments[m_cursor].begin) {
+      m_cursor = 0;
+    }
+    while (k >= m_segments[m_cursor].end) {
+      ++m_cursor;
+    }
+    const Segment &s = m_segments[m_cursor];
+    double I = s.offset + s.slope * k;
+    if (s.sd != 0.0 || s.mean != 0.0) {
+      I += s.mean + s.sd * m_gauss(m_rng);
+    }
+    return I;
+  }
+
+  // Corriente en el instante t = k h
+  double at(double time) { return current(std::lround(time / m_h)); }
+
+  double step() const { return m_h; }
+  const std::vector<Segment> &segments() const { return m_segments; }
+
+  // Instantes en los que empieza un tramo nuevo
+  Breakpoints breakpoints() const {
+    std::vector<double> times;
+    for (const Segment &s : m_segments) {
+      if (s.begin > 0) {
+        times.push_back(s.time);
+      }
+    }
+    return Breakpoints(std::move(times));
+  }
+
+private:
+  std::vector<Segment> m_segments;
+  double m_h;
+  std::size_t m_cursor;
+  std::mt19937_64 m_rng;
+  std::normal_distribution<double> m_gauss;
+};
+
+class StimulusProtocol {
+public:
+  StimulusProtocol &pulse(double start, double end, double I) {
+    return add({Component::add, start, end, I, I, 0.0, 0.0});
+  }
+
+  StimulusProtocol &train(double start, double end, double I, double width, double period) {
+    if (!(width > 0) || !(period > 0)) {
+      throw std::invalid_argument("StimulusProtocol::train: width y period deben ser > 0");
+    }
+    for (long i = 0; start + i * period < end; ++i) {
+      double t = start + i * period;
+      pulse(t, std::min(t + width, end), I);
+    }
+    return *this;
+  }
+
+  StimulusProtocol &ramp(double start, double end, double I0, double I1) {
+    return add({Component::add, start, end, I0, I1, 0.0, 0.0});
+  }
+
+  StimulusProtocol &noise(double start, double end, double sd, double mean = 0.0) {
+    return add({Component::add, start, end, 0.0, 0.0, sd, mean});
+  }
+
+  StimulusProtocol &set(double start, double end, double I) {
+    return add({Component::replace, start, end, I, I, 0.0, 0.0});
+  }
+
+  // Semilla del ruido
+  StimulusProtocol &seed(std::uint64_t seed) {
+    m_seed = seed;
+    return *this;
+  }
+
+  Stimulus compile(double h) const {
+    if (!(h > 0)) {
+      throw std::invalid_argument("StimulusProtocol::compile: paso no válido");
+    }
+    // Pasos de cada componente: los k con start <= k h < end
+    struct Window {
+      long begin, end;
+    };
+    // Paso en el que cambia el estímulo e instante pedido
+    struct Cut {
+      long k;
+      double time;
+      bool operator<(const Cut &other) const { return k < other.k; }
+    };
+    std::vector<Window> windows;
+    std::vector<Cut> cuts = {{0, 0.0}};
+    for (const Component &c : m_components) {
+      Window w = {static_cast<long>(std::ceil(c.start / h - grid_tolerance)),
+                  static_cast<long>(std::ceil(c.end / h - grid_tolerance))};
+      w.begin = std::max(w.begin, 0L);
+      windows.push_back(w);
+      if (w.end > w.begin) {
+        cuts.push_back({w.begin, std::max(c.start, 0.0)});
+        cuts.push_back({w.end, c.end});
+      }
+    }
+    std::stable_sort(cuts.begin(), cuts.end());
+    cuts.erase(std::unique(cuts.begin(), cuts.end(),
+                           [](const Cut &a, const Cut &b) { return a.k == b.k; }),
+               cuts.end());
+    cuts.push_back({std::numeric_limits<long>::max(), 0.0});
+
+    std::vector<Stimulus::Segment> segments;
+    for (std::size_t i = 0; i + 1 < cuts.size(); ++i) {
+      Stimulus::Segment s = {cuts[i].k, cuts[i + 1].k, 0.0, 0.0, 0.0, 0.0, cuts[i].time};
+      double variance = 0.0;
+      for (std::size_t j = 0; j < m_components.size(); ++j) {
+        const Component &c = m_components[j];
+        if (s.begin < windows[j].begin || s.begin >= windows[j].end) {
+          continue;
+        }
+        if (c.mode == Component::replace) {
+          s.offset = s.slope = s.mean = variance = 0.0;
+        }
+        if (c.I0 == c.I1 || c.end == c.start) {
+          s.offset += c.I0;
+        } else {
+          // I0 + (I1 - I0) (k h - start) / (end - start)
+          double rate = (c.I1 - c.I0) / (c.end - c.start);
+          s.offset += c.I0 - rate * c.start;
+          s.slope += rate * h;
+        }
+        s.mean += c.mean;
+        variance += c.sd * c.sd;
+      }
+      s.sd = std::sqrt(variance);
+
+      // Une tramos consecutivos iguales
+      if (!segments.empty()) {
+        Stimulus::Segment &last = segments.back();
+        if (last.offset == s.offset && last.slope == s.slope && last.sd == s.sd &&
+            last.mean == s.mean) {
+          last.end = s.end;
+          continue;
+        }
+      }
+      segments.push_back(s);
+    }
+    return Stimulus(std::move(segments), h, m_seed);
+  }
+
+private:
+  struct Component {
+    enum kind { add, replace } mode;
+    double start, end;
+    double I0, I1;
+    double sd, mean;
+  };
+
+  // Fracción de paso que se tolera al pasar los extremos a la rejilla
+  static constexpr double grid_tolerance = 1e-9;
+
+  StimulusProtocol &add(const Component &c) {
+    if (!(c.end >= c.start)) {
+      throw std::invalid_argument("StimulusProtocol: ventana con end < start");
+    }
+    m_components.push_back(c);
+    return *this;
+  }
+
+  std::vector<Component> m_components;
+  std::uint64_t m_seed = 0;
+};
+
+#endif /* STIMULUS_H_ */
@@ -0,0 +1,169 @@
+/*************************************************************
+ * TabulatedCGC.h - CGC con cinética de compuertas tabulada
+ *
+ * Misma neurona que VavoulisCGCModel (mismas variables y parámetros,
+ * ver neuronas/CGC.cpp), pero las funciones de V de sus compuertas se
+ * calculan una vez al construirla en una GateTable:
+ *
+ *   x_inf(V) = 1 / (1 + exp((vh_x - V) / vs_x))
+ *   tau_x(V) = tau0_x exp(delta_x (V - vh_x) / vs_x) / (1 + exp((V - vh_x) / vs_x))
+ *
+ * para h, r, a, b, n, e, f, y las activaciones instantáneas m_inf y
+ * c_inf d_inf. Cada evaluación hace una interpolación en lugar de 24
+ * exponenciales:
+ *
+ *   C dV/dt = I - Gnat m^3 h (V - vna) - Gnap r (V - vna)
+ *               - Ga a b (V - vk) - Gd n (V - vk)
+ *               - Glva c d (V - vca) - Ghva e f (V - vca)
+ *
+ * Al construirla se comprueba el error de la tabla frente a las
+ * expresiones exactas en puntos intermedios de cada celda, y se lanza
+ * std::runtime_error si supera tolerance. Con Interpolation::none no
+ * hay tabla y se evalúan las expresiones exactas.
+ *
+ * Como FusedNetwork, cumple el contrato de sistema de Neun y se
+ * integra con cualquier integrador:
+ *
+ *   TabulatedCGC<> n(args.params);
+ *   n.add_synaptic_input(0.2);
+ *   n.step<RungeKutta4>(0.01);
+ *
+ * Las neuronas del CPG no se tabulan: su cinética está dentro de
+ * VavoulisModel de Neun, sin parámetros por compuerta. La única
+ * sigmoide que FusedNetwork calcula por su cuenta, r_inf(V_pre) de las
+ * sinapsis, no gana nada con una tabla (una interpolación cúbica
+ * cuesta casi lo mismo que la exponencial), así que el bucle del CPG
+ * no cambia.
+ *
+ *************************************************************/
+
+#ifndef TABULATEDCGC_H_
+#define TABULATEDCGC_H_
+
+#include <GateTable.h>
+#include <VavoulisCGCModel.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+template <typename T = double> class TabulatedCGC {
+public:
+  typedef VavoulisCGCModel<T> Model;
+  typedef T precission_t;
+  typedef typename Model::variable variable;
+  typedef typename Model::parameter parameter;
+
+  static constexpr std::size_t n_variables = Model::n_variables;
+  static constexpr std::size_t n_parameters = Model::n_parameters;
+
+  // Compuertas con dinámica, en el orden de las variables
+  static constexpr std::size_t n_gates = 7;
+  // Columnas de la tabla: x_inf y 1/tau de cada compuerta, m_inf, c_inf d_inf
+  enum column { m_inf = 2 * n_gates, cd_inf, n_columns };
+  typedef GateTable<T, n_columns> Table;
+
+  struct Options {
+    Interpolation mode = Interpolation::cubic;
+    double dv = 0.1;                      // mV
+    double v_min = -120.0, v_max = 80.0;  // mV
+    double tolerance = 1e-6;              // Error relativo máximo de la tabla
+  };
+
+  explicit TabulatedCGC(const T *params, const Options &options = Options())
+      : m_inputs(0) {
+    std::copy(params, params + n_parameters, m_parameters.begin());
+    m_variables.fill(T(0));
+    m_error.fill(0.0);
+
+    if (options.mode == Interpolation::none) {
+      return;
+    }
+    auto exact = [this](T V, T *out) { kinetics(m_parameters.data(), V, out); };
+    m_table = std::make_unique<Table>(exact, options.v_min, options.v_max, options.dv,
+                                      options.mode);
+    m_error = m_table->error(exact);
+    double worst = *std::max_element(m_error.begin(), m_error.end());
+    if (!(worst <= options.tolerance)) {
+      throw std::runtime_error("TabulatedCGC: error de la tabla " + std::to_string(worst) +
+                               " mayor que la tolerancia " +
+                               std::to_string(options.tolerance));
+    }
+  }
+
+  precission_t get(variable var) const { return m_variables[var]; }
+  void set(variable var, precission_t x) { m_variables[var] = x; }
+  precission_t get(parameter p) const { return m_parameters[p]; }
+
+  // Como en Neun, la entrada se acumula hasta el siguiente paso
+  void add_synaptic_input(precission_t I) { m_inputs += I; }
+
+  template <typename Integrator> void step(precission_t h) {
+    Integrator::step(*this, h, m_variables.data(), m_parameters.data());
+    m_inputs = T(0);
+  }
+
+  void eval(const T *const x, T *const P, T *const d) const {
+    T k[n_columns];
+    if (m_table) {
+      m_table->lookup(x[Model::v], k);
+    } else {
+      kinetics(P, x[Model::v], k);
+    }
+
+    T V = x[Model::v];
+    T m = k[m_inf];
+    T I = P[Model::Gnat] * m * m * m * x[Model::h] * (V - P[Model::vna]) +
+          P[Model::Gnap] * x[Model::r] * (V - P[Model::vna]) +
+          P[Model::Ga] * x[Model::a] * x[Model::b] * (V - P[Model::vk]) +
+          P[Model::Gd] * x[Model::n] * (V - P[Model::vk]) +
+          P[Model::Glva] * k[cd_inf] * (V - P[Model::vca]) +
+          P[Model::Ghva] * x[Model::e] * x[Model::f] * (V - P[Model::vca]);
+    d[Model::v] = (m_inputs - I) / P[Model::cm];
+
+    for (std::size_t g = 0; g < n_gates; ++g) {
+      d[Model::h + g] = (k[2 * g] - x[Model::h + g]) * k[2 * g + 1];
+    }
+  }
+
+  // Funciones exactas de las columnas de la tabla
+  static void kinetics(const T *P, T V, T *out) {
+    using std::exp;
+    for (std::size_t g = 0; g < n_gates; ++g) {
+      const parameter *q = gate_parameters[g];
+      T z = (V - P[q[0]]) / P[q[1]];
+      out[2 * g] = T(1) / (T(1) + exp(-z));
+      out[2 * g + 1] = (T(1) + exp(z)) / (P[q[2]] * exp(P[q[3]] * z));
+    }
+    out[m_inf] = T(1) / (T(1) + exp((P[Model::Vh_m] - V) / P[Model::Vs_m]));
+    out[cd_inf] = T(1) / (T(1) + exp((P[Model::Vh_c] - V) / P[Model::Vs_c])) /
+                  (T(1) + exp((P[Model::Vh_d] - V) / P[Model::Vs_d]));
+  }
+
+  const Table *table() const { return m_table.get(); }
+  // Error relativo de cada columna medido al construir la tabla
+  const std::array<double, n_columns> &error() const { return m_error; }
+
+private:
+  // vh, vs, tau0 y delta de cada compuerta
+  static constexpr parameter gate_parameters[n_gates][4] = {
+      {Model::vh_h, Model::vs_h, Model::tau0_h, Model::delta_h},
+      {Model::vh_r, Model::vs_r, Model::tau0_r, Model::delta_r},
+      {Model::vh_a, Model::vs_a, Model::tau0_a, Model::delta_a},
+      {Model::vh_b, Model::vs_b, Model::tau0_b, Model::delta_b},
+      {Model::vh_n, Model::vs_n, Model::tau0_n, Model::delta_n},
+      {Model::vh_e, Model::vs_e, Model::tau0_e, Model::delta_e},
+      {Model::vh_f, Model::vs_f, Model::tau0_f, Model::delta_f}};
+
+  std::array<T, n_variables> m_variables;
+  std::array<T, n_parameters> m_parameters;
+  T m_inputs;
+
+  std::unique_ptr<const Table> m_table;
+  std::array<double, n_columns> m_error;
+};
+
+#endif /* TABULATEDCGC_H_ */
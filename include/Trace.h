@@ -0,0 +1,298 @@
+/*************************************************************
+ * Trace.h - Salida de trazas configurable desde la línea de órdenes
+ *
+ * Todos los ejecutables escriben su traza a través de esta clase,
+ * que elige el formato a partir de los argumentos del programa:
+ *
+ *   ./CPG                          texto por stdout (como siempre)
+ *   ./CPG --precision 8            texto con 8 cifras significativas
+ *   ./CPG --binary cpg.ntr         binario float64 (BinaryTraceWriter)
+ *   ./CPG --binary cpg.ntr --float32
+ *
+ * Además del formato se puede elegir el modo de registro, que es
+ * independiente del paso de integración:
+ *
+ *   --decimate N   guarda una de cada N muestras (la 0, la N, ...)
+ *   --envelope N   agrupa N muestras por bin y guarda, por columna,
+ *                  el mínimo, el máximo y el último valor del bin, de
+ *                  modo que los picos de los spikes no se pierden.
+ *                  La primera columna (tiempo) guarda sólo el último.
+ *   --no-trace     no escribe nada, para cuando sólo interesa el
+ *                  análisis en línea (BurstDetector.h)
+ *
+ * Con --async las filas se copian sin formatear a un anillo de bloques
+ * y un hilo aparte las formatea y escribe (AsyncWriter.h), así que la
+ * simulación sólo espera a la salida si el anillo se llena.
+ * --async-blocks N fija el número de bloques (16 por defecto) y
+ * --async-stats escribe al final por stderr cuánto ha esperado.
+ *
+ * Los nombres de columna sólo se usan en el formato binario; la
+ * salida de texto conserva el formato sin cabecera. En modo envelope
+ * cada columna "x" se expande a "x_min", "x_max" y "x".
+ *
+ * Un argumento desconocido o un factor fuera de rango escribe el error
+ * y las opciones por stderr y termina el programa con código 1. Un
+ * programa que saca sus propias opciones antes de pasar el resto a
+ * Trace las da en program_usage para que aparezcan también:
+ *
+ *   Trace trace(argc, argv, columns, "[--time ms] [--save-state f.ckp]");
+ *
+ *************************************************************/
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <AsyncWriter.h>
+#include <BinaryTraceWriter.h>
+#include <TraceWriter.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+struct TraceOptions {
+  enum mode { full, decimate, envelope, none };
+
+  std::string binary_path;  // Vacío: texto por stdout
+  BinaryTraceWriter::dtype type = BinaryTraceWriter::float64;
+  int precision = 6;
+  mode record = full;
+  long factor = 1;          // Muestras por fila escrita (decimate/envelope)
+  bool async = false;       // Escritura en un hilo aparte
+  long async_blocks = 16;
+  bool async_stats = false;
+
+  static TraceOptions parse(int argc, char **argv, const std::string &program_usage = "") {
+    TraceOptions options;
+    for (int i = 1; i < argc; ++i) {
+      std::string arg = argv[i];
+      if (arg == "--binary" && i + 1 < argc) {
+        options.binary_path = argv[++i];
+      } else if (arg == "--float32") {
+        options.type = BinaryTraceWriter::float32;
+      } else if (arg == "--precision" && i + 1 < argc) {
+        options.precision = std::atoi(argv[++i]);
+      } else if (arg == "--decimate" && i + 1 < argc) {
+        options.record = decimate;
+        options.factor = std::atol(argv[++i]);
+      } else if (arg == "--envelope" && i + 1 < argc) {
+        options.record = envelope;
+        options.factor = std::atol(argv[++i]);
+      } else if (arg == "--no-trace") {
+        options.record = none;
+      } else if (arg == "--async") {
+        options.async = true;
+      } else if (arg == "--async-blocks" && i + 1 < argc) {
+        options.async = true;
+        options.async_blocks = std::atol(argv[++i]);
+      } else if (arg == "--async-stats") {
+        options.async_stats = true;
+      } else {
+        usage("Argumento no reconocido: " + arg, program_usage);
+      }
+    }
+    if (options.factor < 1) {
+      usage("El factor de registro debe ser >= 1", program_usage);
+    }
+    if (options.async_blocks < 2) {
+      usage("--async-blocks debe ser >= 2", program_usage);
+    }
+    return options;
+  }
+
+  [[noreturn]] static void usage(const std::string &error,
+                                 const std::string &program_usage = "") {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    if (!program_usage.empty()) {
+      std::fprintf(stderr, "Opciones: %s\n", program_usage.c_str());
+    }
+    std::fprintf(stderr,
+                 "Opciones de traza: [--binary fichero [--float32]] [--precision n] "
+                 "[--decimate n | --envelope n | --no-trace] [--async] [--async-blocks n] "
+                 "[--async-stats]\n");
+    std::exit(1);
+  }
+};
+
+class Trace {
+public:
+  Trace(const TraceOptions &options, const std::vector<std::string> &columns)
+      : m_record(options.record), m_factor(options.factor), m_count(0),
+        m_columns(columns.size()), m_async_stats(options.async_stats) {
+    std::vector<std::string> names = columns;
+    if (m_record == TraceOptions::envelope) {
+      names = envelope_names(columns);
+      m_min.resize(m_columns);
+      m_max.resize(m_columns);
+      m_last.resize(m_columns);
+      m_out.resize(names.size());
+    }
+
+    if (m_record == TraceOptions::none) {
+      return;
+    }
+    if (options.binary_path.empty()) {
+      m_text = std::make_unique<TraceWriter>(stdout, options.precision);
+    } else {
+      m_binary = std::make_unique<BinaryTraceWriter>(options.binary_path,
+                                                     names, options.type);
+    }
+    if (options.async) {
+      m_async = std::make_unique<AsyncWriter>(
+          names.size(),
+          [this](const double *values, std::size_t n) {
+            if (m_text) {
+              m_text->row(values, n);
+            } else {
+              m_binary->row(values, n);
+            }
+          },
+          options.async_blocks);
+    }
+  }
+
+  Trace(int argc, char **argv, const std::vector<std::string> &columns,
+        const std::string &program_usage = "")
+      : Trace(TraceOptions::parse(argc, argv, program_usage), columns) {}
+
+  Trace(const Trace &) = delete;
+  Trace &operator=(const Trace &) = delete;
+
+  // El último bin incompleto también se escribe
+  ~Trace() {
+    if (m_record == TraceOptions::envelope && m_count > 0) {
+      write_envelope();
+    }
+    if (m_async) {
+      m_async->close();
+      if (m_async_stats) {
+        const AsyncStatistics &s = m_async->statistics();
+        std::fprintf(stderr,
+                     "async: %llu filas en %llu bloques, %llu esperas (%.3f s), "
+                     "ocupación máxima %zu bloques\n",
+                     static_cast<unsigned long long>(s.rows),
+                     static_cast<unsigned long long>(s.blocks),
+                     static_cast<unsigned long long>(s.stalls), s.stall_seconds, s.high_water);
+      }
+    }
+  }
+
+  template <typename... Values>
+    requires(std::is_arithmetic_v<Values> && ...)
+  void row(Values... values) {
+    if (m_record == TraceOptions::full) {
+      write(values...);
+      return;
+    }
+    if (m_record == TraceOptions::none) {
+      return;
+    }
+    const double data[] = {static_cast<double>(values)...};
+    row(data, sizeof...(Values));
+  }
+
+  template <typename T> void row(const T *values, std::size_t n) {
+    switch (m_record) {
+    case TraceOptions::full:
+      write(values, n);
+      break;
+    case TraceOptions::decimate:
+      if (m_count == 0) {
+        write(values, n);
+      }
+      if (++m_count == m_factor) {
+        m_count = 0;
+      }
+      break;
+    case TraceOptions::envelope:
+      accumulate(values, n);
+      if (m_count == m_factor) {
+        write_envelope();
+      }
+      break;
+    case TraceOptions::none:
+      break;
+    }
+  }
+
+private:
+  static std::vector<std::string> envelope_names(const std::vector<std::string> &columns) {
+    std::vector<std::string> names;
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+      if (i > 0) {
+        names.push_back(columns[i] + "_min");
+        names.push_back(columns[i] + "_max");
+      }
+      names.push_back(columns[i]);
+    }
+    return names;
+  }
+
+  template <typename T> void accumulate(const T *values, std::size_t n) {
+    if (n != m_columns) {
+      throw std::invalid_argument("Trace: número de columnas incorrecto");
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      double x = static_cast<double>(values[i]);
+      m_min[i] = m_count == 0 ? x : std::min(m_min[i], x);
+      m_max[i] = m_count == 0 ? x : std::max(m_max[i], x);
+      m_last[i] = x;
+    }
+    ++m_count;
+  }
+
+  void write_envelope() {
+    std::size_t k = 0;
+    m_out[k++] = m_last[0];
+    for (std::size_t i = 1; i < m_columns; ++i) {
+      m_out[k++] = m_min[i];
+      m_out[k++] = m_max[i];
+      m_out[k++] = m_last[i];
+    }
+    write(m_out.data(), m_out.size());
+    m_count = 0;
+  }
+
+  template <typename... Values> void write(Values... values) {
+    if (m_async) {
+      const double data[] = {static_cast<double>(values)...};
+      m_async->row(data, sizeof...(Values));
+      return;
+    }
+    if (m_text) {
+      m_text->row(values...);
+    } else {
+      m_binary->row(values...);
+    }
+  }
+
+  template <typename T> void write(T *values, std::size_t n) {
+    if (m_async) {
+      m_async->row(values, n);
+      return;
+    }
+    if (m_text) {
+      m_text->row(values, n);
+    } else {
+      m_binary->row(values, n);
+    }
+  }
+
+  TraceOptions::mode m_record;
+  long m_factor;
+  long m_count;
+  std::size_t m_columns;
+  bool m_async_stats;
+  std::vector<double> m_min, m_max, m_last, m_out;
+
+  std::unique_ptr<TraceWriter> m_text;
+  std::unique_ptr<BinaryTraceWriter> m_binary;
+  // Después de los escritores: se destruye (y los vacía) antes que ellos
+  std::unique_ptr<AsyncWriter> m_async;
+};
+
+#endif /* TRACE_H_ */
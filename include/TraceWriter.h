@@ -0,0 +1,111 @@
+/*************************************************************
+ * TraceWriter.h - Escritura rápida de trazas de simulación
+ *
+ * Sustituye a `std::cout << ... << std::endl` en los bucles de
+ * simulación. Cada fila se formatea con std::to_chars en un buffer
+ * grande que sólo se vuelca al fichero cuando se llena (o al
+ * destruir el objeto), en lugar de vaciar el stream en cada paso.
+ *
+ * Con la precisión por defecto (6 cifras significativas, formato
+ * general) la salida es idéntica a la de iostream: columnas separadas
+ * por un espacio y una fila por línea.
+ *
+ *   TraceWriter trace;                        // stdout, precisión 6
+ *   trace.row(time, n.get(Neuron::v), ...);
+ *
+ *************************************************************/
+
+#ifndef TRACEWRITER_H_
+#define TRACEWRITER_H_
+
+#include <charconv>
+#include <cstddef>
+#include <cstdio>
+#include <type_traits>
+#include <vector>
+
+class TraceWriter {
+public:
+  explicit TraceWriter(std::FILE *file = stdout, int precision = 6,
+                       std::size_t buffer_size = 1 << 20)
+      : m_file(file), m_precision(precision),
+        m_buffer(buffer_size < min_buffer ? min_buffer : buffer_size),
+        m_used(0) {}
+
+  TraceWriter(const TraceWriter &) = delete;
+  TraceWriter &operator=(const TraceWriter &) = delete;
+
+  ~TraceWriter() { flush(); }
+
+  // Escribe una fila: valores separados por espacios y salto de línea
+  template <typename... Values>
+    requires(std::is_arithmetic_v<Values> && ...)
+  void row(Values... values) {
+    bool first = true;
+    ((put(values, first), first = false), ...);
+    put_char('\n');
+  }
+
+  // Escribe una fila a partir de un array de n valores
+  template <typename T> void row(const T *values, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+      put(values[i], i == 0);
+    }
+    put_char('\n');
+  }
+
+  void flush() {
+    if (m_used > 0) {
+      std::fwrite(m_buffer.data(), 1, m_used, m_file);
+      m_used = 0;
+    }
+    std::fflush(m_file);
+  }
+
+  int precision() const { return m_precision; }
+
+private:
+  // Espacio suficiente para un valor en formato general con signo,
+  // punto decimal y exponente de tres cifras
+  static constexpr std::size_t max_field = 64;
+  static constexpr std::size_t min_buffer = 4 * max_field;
+
+  template <typename T> void put(T value, bool first) {
+    if (m_buffer.size() - m_used < max_field + 1) {
+      drain();
+    }
+    if (!first) {
+      m_buffer[m_used++] = ' ';
+    }
+    char *begin = m_buffer.data() + m_used;
+    char *end = m_buffer.data() + m_buffer.size();
+    std::to_chars_result res;
+    if constexpr (std::is_floating_point_v<T>) {
+      res = std::to_chars(begin, end, value, std::chars_format::general,
+                          m_precision);
+    } else {
+      res = std::to_chars(begin, end, value);
+    }
+    m_used = res.ptr - m_buffer.data();
+  }
+
+  void put_char(char c) {
+    if (m_used == m_buffer.size()) {
+      drain();
+    }
+    m_buffer[m_used++] = c;
+  }
+
+  // Vuelca el buffer sin forzar el flush del FILE
+  void drain() {
+    std::fwrite(m_buffer.data(), 1, m_used, m_file);
+    m_used = 0;
+  }
+
+  std::FILE *m_file;
+  int m_precision;
+  std::vector<char> m_buffer;
+  std::size_t m_used;
+};
+
+#endif /* TRACEWRITER_H_ */
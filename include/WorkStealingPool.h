@@ -0,0 +1,173 @@
+/*************************************************************
+ * WorkStealingPool.h - Pool de hilos con robo de tareas
+ *
+ * Cada hilo tiene su propia cola de tareas: saca trabajo del final
+ * de la suya y, cuando se vacía, roba del principio de la de otro
+ * hilo. Pensado para muchas simulaciones independientes de duración
+ * desigual (un punto del barrido que no oscila acaba antes que otro
+ * que sí lo hace).
+ *
+ *   WorkStealingPool pool;                       // un hilo por núcleo
+ *   pool.parallel_for(n, [&](std::size_t i) { ... });
+ *
+ *************************************************************/
+
+#ifndef WORKSTEALINGPOOL_H_
+#define WORKSTEALINGPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkStealingPool {
+public:
+  typedef std::function<void()> Task;
+
+  explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency())
+      : m_queues(threads == 0 ? 1 : threads), m_pending(0), m_queued(0), m_next(0),
+        m_stop(false) {
+    for (std::size_t w = 0; w < m_queues.size(); ++w) {
+      m_queues[w] = std::make_unique<Queue>();
+    }
+    for (std::size_t w = 0; w < m_queues.size(); ++w) {
+      m_workers.emplace_back([this, w] { run(w); });
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool &) = delete;
+  WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (std::thread &t : m_workers) {
+      t.join();
+    }
+  }
+
+  std::size_t size() const { return m_workers.size(); }
+
+  // Encola una tarea en la cola de un hilo (reparto round-robin)
+  void submit(Task task) {
+    std::size_t w = m_next++ % m_queues.size();
+    // Se cuenta antes de encolarla para que m_queued no baje de 0
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++m_pending;
+      ++m_queued;
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_queues[w]->mutex);
+      m_queues[w]->tasks.push_back(std::move(task));
+    }
+    m_wake.notify_one();
+  }
+
+  // Espera a que terminen todas las tareas encoladas. Relanza la
+  // primera excepción que haya escapado de una tarea.
+  void wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_pending == 0; });
+    if (m_error) {
+      std::exception_ptr error = m_error;
+      m_error = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  // Ejecuta body(i) para i en [0, n) y espera a que terminen todos
+  template <typename Body> void parallel_for(std::size_t n, Body body) {
+    for (std::size_t i = 0; i < n; ++i) {
+      submit([&body, i] { body(i); });
+    }
+    wait();
+  }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  bool pop_local(std::size_t w, Task &task) {
+    std::lock_guard<std::mutex> lock(m_queues[w]->mutex);
+    if (m_queues[w]->tasks.empty()) {
+      return false;
+    }
+    task = std::move(m_queues[w]->tasks.back());
+    m_queues[w]->tasks.pop_back();
+    return true;
+  }
+
+  bool steal(std::size_t w, Task &task) {
+    for (std::size_t k = 1; k < m_queues.size(); ++k) {
+      Queue &victim = *m_queues[(w + k) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void run(std::size_t w) {
+    for (;;) {
+      Task task;
+      if (pop_local(w, task) || steal(w, task)) {
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          --m_queued;
+        }
+        try {
+          task();
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          if (!m_error) {
+            m_error = std::current_exception();
+          }
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_pending == 0) {
+          m_done.notify_all();
+          m_wake.notify_all();
+        }
+        continue;
+      }
+
+      // Sin trabajo visible: se duerme hasta que se encole una tarea o
+      // se pare el pool sin nada pendiente. Las tareas en curso no
+      // despiertan a nadie, porque no dejan trabajo que robar. Si
+      // m_queued > 0 la tarea se está encolando y se vuelve a buscar.
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (m_stop && m_pending == 0) {
+        return;
+      }
+      m_wake.wait(lock, [this] { return m_queued > 0 || (m_stop && m_pending == 0); });
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> m_queues;
+  std::vector<std::thread> m_workers;
+
+  std::mutex m_mutex;
+  std::condition_variable m_wake, m_done;
+  std::size_t m_pending;  // Encoladas o en curso
+  std::size_t m_queued;   // Encoladas sin que nadie las haya tomado
+  std::atomic<std::size_t> m_next;
+  bool m_stop;
+  std::exception_ptr m_error;
+};
+
+#endif /* WORKSTEALINGPOOL_H_ */
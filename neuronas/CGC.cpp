@@ -18,7 +18,10 @@
 #include <VavoulisCGCModel.h>
 #include <RungeKutta4.h>
 #include <SystemWrapper.h>
-#include <iostream>
+#include <SteadyState.h>
+#include <Stimulus.h>
+#include <Trace.h>
+#include <cstdio>
 
 typedef RungeKutta4 Integrator;
 typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisCGCModel<double>>, Integrator>
@@ -111,6 +114,12 @@ int main(int argc, char **argv) {
   n.set(Neuron::e, 1.0 / (1.0 + exp((-14.25 - (-60.0)) / 6.96)));
   n.set(Neuron::f, 1.0 / (1.0 + exp((-21.44 - (-60.0)) / -5.78)));
 
+  SteadyStateResult rest = SteadyState::rest(n);
+  if (!rest.converged) {
+    std::fprintf(stderr, "Reposo sin converger (residuo %g); se parte de los valores iniciales\n",
+                 rest.residual);
+  }
+
 
   const double step = 0.01;              // Paso de integración (ms)
   const double simulation_time = 3000;   // Tiempo total (ms)
@@ -120,25 +129,23 @@ int main(int argc, char **argv) {
   const double t_pulse_end   = 2500.0;   // Fin del pulso (ms)
   const double I_inj         = 0.2;     // Corriente inyectada
 
+  Trace trace(argc, argv, {"tiempo", "V", "h", "r", "a", "b", "n", "e", "f"});
+
+  // Pulso sobre la rejilla de pasos (Stimulus.h)
+  Stimulus stimulus = StimulusProtocol().pulse(t_pulse_start, t_pulse_end, I_inj).compile(step);
+  const long steps = std::lround(simulation_time / step);
+
   // Simulación
-  for (double time = 0; time < simulation_time; time += step) {
-    if (time >= t_pulse_start && time <= t_pulse_end) {
-      n.add_synaptic_input(I_inj);
-    }
+  for (long k = 0; k < steps; ++k) {
+    const double time = k * step;
+    n.add_synaptic_input(stimulus.current(k));
 
     n.step(step);
 
     // Salida: tiempo, V, h, r, a, b, n, e, f
-    std::cout << time << " "
-              << n.get(Neuron::v) << " "
-              << n.get(Neuron::h) << " "
-              << n.get(Neuron::r) << " "
-              << n.get(Neuron::a) << " "
-              << n.get(Neuron::b) << " "
-              << n.get(Neuron::n) << " "
-              << n.get(Neuron::e) << " "
-              << n.get(Neuron::f)
-              << std::endl;
+    trace.row(time, n.get(Neuron::v), n.get(Neuron::h), n.get(Neuron::r),
+              n.get(Neuron::a), n.get(Neuron::b), n.get(Neuron::n),
+              n.get(Neuron::e), n.get(Neuron::f));
   }
 
   return 0;
@@ -2,7 +2,10 @@
 #include <VavoulisModel.h>
 #include <RungeKutta4.h>
 #include <SystemWrapper.h>
-#include <iostream>
+#include <SteadyState.h>
+#include <Stimulus.h>
+#include <Trace.h>
+#include <cstdio>
 
 typedef RungeKutta4 Integrator;
 typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, Integrator>
@@ -33,6 +36,12 @@ int main(int argc, char **argv) {
   n.set(Neuron::h, 1 / (1 + exp((-55.2 - (-67.0))/-7.1)));
   n.set(Neuron::n, 1.0 / (1.0 + exp((-30.0 - (-67.0)) / 17.4)));
 
+  SteadyStateResult rest = SteadyState::rest(n);
+  if (!rest.converged) {
+    std::fprintf(stderr, "Reposo sin converger (residuo %g); se parte de los valores iniciales\n",
+                 rest.residual);
+  }
+
   // Parametros de simulacion
   const double step = 0.01;            // Paso de integracion (ms)
   const double simulation_time = 4000; // Tiempo total (ms) - 4 segundos
@@ -44,16 +53,20 @@ int main(int argc, char **argv) {
   const double t_pulse_end = 1800;
   const double I_inj = 8.0;            // Corriente hiperpolarizante (positiva = hiperpolariza en el modelo)
 
-  for (double time = 0; time < simulation_time; time += step) {
-    if (time >= t_pulse_start && time <= t_pulse_end) {
-      n.add_synaptic_input(I_inj);
-    }
+  Trace trace(argc, argv, {"tiempo", "V_soma", "V_axon", "p", "q", "h", "n"});
+
+  // Pulso sobre la rejilla de pasos (Stimulus.h)
+  Stimulus stimulus = StimulusProtocol().pulse(t_pulse_start, t_pulse_end, I_inj).compile(step);
+  const long steps = std::lround(simulation_time / step);
+
+  for (long k = 0; k < steps; ++k) {
+    const double time = k * step;
+    n.add_synaptic_input(stimulus.current(k));
     
     n.step(step);
     // Salida: tiempo, V_soma, V_axon, p, q, h, n
-    std::cout << time << " " << n.get(Neuron::v) << " " << n.get(Neuron::va) 
-              << " " << n.get(Neuron::p) << " " << n.get(Neuron::q)
-              << " " << n.get(Neuron::h) << " " << n.get(Neuron::n) << std::endl;
+    trace.row(time, n.get(Neuron::v), n.get(Neuron::va), n.get(Neuron::p),
+              n.get(Neuron::q), n.get(Neuron::h), n.get(Neuron::n));
   }
 
   return 0;
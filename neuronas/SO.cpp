@@ -2,7 +2,10 @@
 #include <VavoulisModel.h>
 #include <RungeKutta4.h>
 #include <SystemWrapper.h>
-#include <iostream>
+#include <SteadyState.h>
+#include <Stimulus.h>
+#include <Trace.h>
+#include <cstdio>
 
 typedef RungeKutta4 Integrator;
 typedef DifferentialNeuronWrapper<SystemWrapper<VavoulisModel<double>>, Integrator>
@@ -34,6 +37,12 @@ int main(int argc, char **argv) {
   n.set(Neuron::h, 1 / (1 + exp((-55.2 - (-67.0))/-7.1)));
   n.set(Neuron::n, 1.0 / (1.0 + exp((-30.0 - (-67.0)) / 17.4)));
 
+  SteadyStateResult rest = SteadyState::rest(n);
+  if (!rest.converged) {
+    std::fprintf(stderr, "Reposo sin converger (residuo %g); se parte de los valores iniciales\n",
+                 rest.residual);
+  }
+
   // Parametros de simulacion
   const double step = 0.01;            // Paso de integracion (ms)
   const double simulation_time = 3000; // Tiempo total (ms) - 3 segundos
@@ -53,28 +62,26 @@ int main(int argc, char **argv) {
   const double t_inhib3_end = 2300;
   const double I_inhib = 15.0;         // Corriente hiperpolarizante
 
-  for (double time = 0; time < simulation_time; time += step) {
-    double current = 0.0;
-    
-    // Estimulacion despolarizante continua
-    if (time >= t_stim_start && time <= t_stim_end) {
-      current = I_stim;
-    }
-    
-    // Pulsos inhibitorios breves
-    if ((time >= t_inhib1_start && time <= t_inhib1_end) ||
-        (time >= t_inhib2_start && time <= t_inhib2_end) ||
-        (time >= t_inhib3_start && time <= t_inhib3_end)) {
-      current = I_inhib;
-    }
-    
-    n.add_synaptic_input(current);
+  Trace trace(argc, argv, {"tiempo", "V_soma", "V_axon", "p", "q", "h", "n"});
+
+  // Estimulacion despolarizante continua; los pulsos inhibitorios
+  // sustituyen a la corriente continua mientras duran (Stimulus.h)
+  Stimulus stimulus = StimulusProtocol()
+                          .pulse(t_stim_start, t_stim_end, I_stim)
+                          .set(t_inhib1_start, t_inhib1_end, I_inhib)
+                          .set(t_inhib2_start, t_inhib2_end, I_inhib)
+                          .set(t_inhib3_start, t_inhib3_end, I_inhib)
+                          .compile(step);
+  const long steps = std::lround(simulation_time / step);
+
+  for (long k = 0; k < steps; ++k) {
+    const double time = k * step;
+    n.add_synaptic_input(stimulus.current(k));
     n.step(step);
     
     // Salida: tiempo, V_soma, V_axon, p, q, h, n
-    std::cout << time << " " << n.get(Neuron::v) << " " << n.get(Neuron::va) 
-              << " " << n.get(Neuron::p) << " " << n.get(Neuron::q)
-              << " " << n.get(Neuron::h) << " " << n.get(Neuron::n) << std::endl;
+    trace.row(time, n.get(Neuron::v), n.get(Neuron::va), n.get(Neuron::p),
+              n.get(Neuron::q), n.get(Neuron::h), n.get(Neuron::n));
   }
 
   return 0;
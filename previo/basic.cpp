@@ -36,7 +36,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <HodgkinHuxleyModel.h>
 #include <RungeKutta4.h>
 #include <SystemWrapper.h>
-#include <iostream>
+#include <Trace.h>
 
 typedef RungeKutta4 Integrator;
 typedef DifferentialNeuronWrapper<SystemWrapper<HodgkinHuxleyModel<double>>, Integrator>
@@ -67,12 +67,14 @@ int main(int argc, char **argv) {
   // Set the integration step
   const double step = 0.001;
 
+  Trace trace(argc, argv, {"time", "V"});
+
   // Perform the simulation
   double simulation_time = 100;
   for (double time = 0; time < simulation_time; time += step) {
     n.step(step);
 
-    std::cout << time << " " << n.get(Neuron::v) << std::endl;
+    trace.row(time, n.get(Neuron::v));
   }
 
   return 0;
@@ -15,8 +15,41 @@ plt.rcParams.update({'font.size': 11})
 
 import sys
 import os
+import struct
 import pandas as pd
 
+
+TRACE_MAGIC = b"NEUNTRC1"
+
+
+def read_binary_trace(path):
+	"""Abre una traza binaria de BinaryTraceWriter.h sin copiarla.
+
+	Devuelve un diccionario {nombre de columna: vista de np.memmap}.
+	"""
+	with open(path, "rb") as f:
+		fixed = f.read(32)
+		if fixed[:8] != TRACE_MAGIC:
+			raise ValueError(path + " no es una traza binaria de Neun")
+		version, header_size, n_columns, itemsize, n_rows = struct.unpack("<IIIIQ", fixed[8:32])
+		names = f.read(header_size - 32).split(b"\0")[:n_columns]
+
+	if version != 1:
+		raise ValueError("Version de traza no soportada: %d" % version)
+
+	dtype = np.dtype("<f4") if itemsize == 4 else np.dtype("<f8")
+	if n_rows == 0:
+		n_rows = (os.path.getsize(path) - header_size) // (n_columns * itemsize)
+
+	rows = np.memmap(path, dtype=dtype, mode="r", offset=header_size, shape=(n_rows, n_columns))
+	return {name.decode(): rows[:, i] for i, name in enumerate(names)}
+
+
+def is_binary_trace(path):
+	with open(path, "rb") as f:
+		return f.read(8) == TRACE_MAGIC
+
+
 if len(sys.argv) >1:
 	path = sys.argv[1]
 else:
@@ -27,12 +60,22 @@ else:
 file_name = path[path.rfind('/')+1:]
 
 print("Ploting file from ", file_name)
-data = pd.read_csv(path, delim_whitespace=True, low_memory=False)
+if is_binary_trace(path):
+	data = read_binary_trace(path)
+	for name, column in data.items():
+		print(name, column.shape, column.dtype)
+else:
+	data = pd.read_csv(path, delim_whitespace=True, low_memory=False)
+	print(data)
 
+headers = list(data.keys())
 
-print(data)
-headers = data.keys()
-rows = data.shape[1]
+# Trazas grabadas con --envelope: x_min y x_max se dibujan como banda de x
+# (Trace.h escribe x_min, x_max y x, con x el último valor del bin)
+envelope = [h for h in headers if h + "_min" in data and h + "_max" in data]
+bands = set(h + suffix for h in envelope for suffix in ("_min", "_max"))
+headers = [h for h in headers if h not in bands]
+rows = len(headers)
 
 colors = ['teal', 'brown', 'blue', 'green','maroon','teal', 'brown', 'blue', 'green','maroon']
 
@@ -48,6 +91,9 @@ for i in range(1,rows):
 		plt.xlabel("Time (ms)")
 
 	plt.ylabel("Voltage\n(mV)", multialignment='center')
+	if headers[i] in envelope:
+		x = np.arange(len(data[headers[i]]))
+		plt.fill_between(x, data[headers[i] + "_min"], data[headers[i] + "_max"], color=colors[i-1], alpha=0.4, linewidth=0)
 	plt.plot(data[headers[i]],color=colors[i-1])
 
 	plt.title(headers[i])
@@ -37,7 +37,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <HodgkinHuxleyModel.h>
 #include <SystemWrapper.h>
 #include <RungeKutta4.h>
-#include <iostream>
+#include <Trace.h>
 
 typedef RungeKutta4 Integrator;
 typedef DifferentialNeuronWrapper<SystemWrapper<HodgkinHuxleyModel<double>>, Integrator> HH;
@@ -68,6 +68,8 @@ int main(int argc, char **argv) {
   // Set the integration step
   const double step = 0.001;
 
+  Trace trace(argc, argv, {"time", "V1", "V2", "I1"});
+
   // Perform the simulation
   double simulation_time = 1000;
   for (double time = 0; time < simulation_time; time += step) {
@@ -80,8 +82,7 @@ int main(int argc, char **argv) {
     h1.step(step);
     h2.step(step);
 
-    std::cout << time << " " << h1.get(HH::v) << " " << h2.get(HH::v) 
-              << " " << s.get(Synapsis::i1) << std::endl;
+    trace.row(time, h1.get(HH::v), h2.get(HH::v), s.get(Synapsis::i1));
   }
 
   return 0;